@@ -0,0 +1,186 @@
+#include "AgentChannel.h"
+
+#include <new>
+#include <type_traits>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared memory rings need lock free atomics");
+static_assert(std::is_trivially_copyable_v<AgentObservation> && std::is_trivially_copyable_v<AgentAction>,
+    "Everything in the channel must be readable from another process");
+
+AgentChannel::~AgentChannel()
+{
+    Close();
+}
+
+bool AgentChannel::Create(const std::string& name)
+{
+    Close();
+    if (!Map(name, true))
+    {
+        return false;
+    }
+    mOwner = true;
+
+    new (mLayout) AgentChannelLayout();
+    mLayout->Version = kAgentChannelVersion;
+    mLayout->ObservationSize = (uint32_t)sizeof(AgentObservation);
+    mLayout->ActionSize = (uint32_t)sizeof(AgentAction);
+    // Agents wait for the magic, so it goes last
+    std::atomic_thread_fence(std::memory_order_release);
+    mLayout->Magic = kMagic;
+    return true;
+}
+
+bool AgentChannel::Open(const std::string& name)
+{
+    Close();
+    if (!Map(name, false))
+    {
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (mLayout->Magic != kMagic || mLayout->Version != kAgentChannelVersion ||
+        mLayout->ObservationSize != sizeof(AgentObservation) || mLayout->ActionSize != sizeof(AgentAction))
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void AgentChannel::Close()
+{
+#if defined(_WIN32)
+    if (mLayout)
+    {
+        UnmapViewOfFile(mLayout);
+    }
+    if (mMappingHandle)
+    {
+        CloseHandle(mMappingHandle);
+    }
+    mMappingHandle = nullptr;
+#else
+    if (mLayout)
+    {
+        munmap(mLayout, sizeof(AgentChannelLayout));
+    }
+    if (mOwner)
+    {
+        shm_unlink(mName.c_str());
+    }
+#endif
+    mLayout = nullptr;
+    mOwner = false;
+    mName.clear();
+}
+
+bool AgentChannel::IsOpen() const
+{
+    return mLayout != nullptr;
+}
+
+void AgentChannel::AddEnemy(AgentObservation& observation, float x, float z)
+{
+    auto distanceSquared = [&](float enemyX, float enemyZ)
+    {
+        return (enemyX - observation.PlayerX) * (enemyX - observation.PlayerX) + (enemyZ - observation.PlayerZ) * (enemyZ - observation.PlayerZ);
+    };
+    float distance = distanceSquared(x, z);
+    uint32_t index = observation.NumEnemies;
+    if (index == kMaxObservedEnemies)
+    {
+        const auto& farthest = observation.Enemies[kMaxObservedEnemies - 1];
+        if (distance >= distanceSquared(farthest.X, farthest.Z))
+        {
+            return;
+        }
+        index--;
+    }
+    else
+    {
+        observation.NumEnemies++;
+    }
+    for (; index > 0; --index)
+    {
+        const auto& previous = observation.Enemies[index - 1];
+        if (distanceSquared(previous.X, previous.Z) <= distance)
+        {
+            break;
+        }
+        observation.Enemies[index] = previous;
+    }
+    observation.Enemies[index] = { x, z };
+}
+
+AgentRing<AgentObservation>& AgentChannel::GetObservations()
+{
+    return mLayout->Observations;
+}
+
+AgentRing<AgentAction>& AgentChannel::GetActions()
+{
+    return mLayout->Actions;
+}
+
+bool AgentChannel::Map(const std::string& name, bool create)
+{
+    constexpr auto size = sizeof(AgentChannelLayout);
+#if defined(_WIN32)
+    mName = "Local\\" + name;
+    HANDLE mapping = create ?
+        CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, (DWORD)size, mName.c_str()) :
+        OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, mName.c_str());
+    if (mapping == nullptr)
+    {
+        return false;
+    }
+    mMappingHandle = mapping;
+    mLayout = static_cast<AgentChannelLayout*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size));
+#else
+    // POSIX shared memory names are a single path component starting with a slash
+    mName = "/" + name;
+    if (create)
+    {
+        shm_unlink(mName.c_str());
+    }
+    int descriptor = shm_open(mName.c_str(), create ? O_CREAT | O_EXCL | O_RDWR : O_RDWR, 0600);
+    if (descriptor < 0)
+    {
+        return false;
+    }
+    struct stat stats;
+    bool sized = create ? ftruncate(descriptor, (off_t)size) == 0 : fstat(descriptor, &stats) == 0 && (size_t)stats.st_size >= size;
+    void* data = sized ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0) : MAP_FAILED;
+    // The mapping keeps the memory alive
+    close(descriptor);
+    if (create && data == MAP_FAILED)
+    {
+        shm_unlink(mName.c_str());
+    }
+    mLayout = data == MAP_FAILED ? nullptr : static_cast<AgentChannelLayout*>(data);
+#endif
+
+    if (mLayout == nullptr)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
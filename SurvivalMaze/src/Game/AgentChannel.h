@@ -0,0 +1,140 @@
+#pragma once
+
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+
+// Observations and actions exchanged with external agents (bots, RL trainers) through a named shared memory
+// mapping, one single producer / single consumer ring per direction. Both sides map the same memory and fill or
+// read the slots in place, so nothing is ever serialized or copied. Works on both Windows and POSIX.
+// Every struct in here is part of the layout agents are built against, bump kAgentChannelVersion when changing one
+
+constexpr uint32_t kAgentChannelVersion = 1;
+constexpr uint32_t kAgentRingCapacity = 8;
+constexpr int32_t kObservationRadius = 7; // Tiles around the player in every direction
+constexpr uint32_t kObservationWidth = 2 * kObservationRadius + 1;
+constexpr uint32_t kMaxObservedEnemies = 32;
+constexpr uint8_t kObservedOutside = 0xFF; // Tile value outside of the maze, otherwise TileType
+
+struct ObservedEnemy
+{
+    float X;
+    float Z;
+};
+
+struct AgentObservation
+{
+    uint64_t Tick;
+    float Health;
+    float RemainingTime;
+    float PlayerX;
+    float PlayerZ;
+    int32_t PlayerRow;
+    int32_t PlayerCol;
+    uint32_t Outcome; // SimWorld::Outcome, the game only uses Running
+    uint32_t NumEnemies; // Closest enemies first
+    ObservedEnemy Enemies[kMaxObservedEnemies];
+    uint8_t Tiles[kObservationWidth * kObservationWidth]; // Row major, centered on the player's tile
+};
+
+struct AgentAction
+{
+    uint64_t Tick; // Of the observation this answers
+    float MoveX;
+    float MoveZ;
+    float AimX;
+    float AimZ;
+    uint32_t Shoot;
+    uint32_t Reserved;
+};
+
+template <typename T>
+struct AgentRing
+{
+    alignas(64) std::atomic<uint64_t> Head; // Written by the producer only
+    alignas(64) std::atomic<uint64_t> Tail; // Written by the consumer only
+    alignas(64) T Slots[kAgentRingCapacity];
+
+    // Null when the ring is full. The slot is published by EndWrite
+    T* BeginWrite()
+    {
+        auto head = Head.load(std::memory_order_relaxed);
+        if (head - Tail.load(std::memory_order_acquire) >= kAgentRingCapacity)
+        {
+            return nullptr;
+        }
+        return &Slots[head % kAgentRingCapacity];
+    }
+    void EndWrite()
+    {
+        Head.store(Head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    // Null when the ring is empty. The slot stays valid until EndRead
+    const T* BeginRead()
+    {
+        auto tail = Tail.load(std::memory_order_relaxed);
+        if (tail == Head.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        return &Slots[tail % kAgentRingCapacity];
+    }
+    void EndRead()
+    {
+        Tail.store(Tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+};
+
+struct AgentChannelLayout
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t ObservationSize;
+    uint32_t ActionSize;
+    AgentRing<AgentObservation> Observations;
+    AgentRing<AgentAction> Actions;
+};
+
+class AgentChannel
+{
+public:
+    static constexpr const uint32_t kMagic = 0x4E484341; // "ACHN"
+
+public:
+    AgentChannel() = default;
+    ~AgentChannel();
+
+    AgentChannel(const AgentChannel&) = delete;
+    AgentChannel& operator=(const AgentChannel&) = delete;
+
+public:
+    // Simulation side, creates the mapping (replacing a stale one with the same name) and removes it on Close
+    bool Create(const std::string& name);
+    // Agent side, fails when the simulation didn't create the channel or was built against another layout
+    bool Open(const std::string& name);
+    void Close();
+
+    bool IsOpen() const;
+
+    // Keeps the kMaxObservedEnemies enemies closest to the observation's player, sorted by distance
+    static void AddEnemy(AgentObservation& observation, float x, float z);
+
+    // Written by the simulation, read by the agent
+    AgentRing<AgentObservation>& GetObservations();
+    // Written by the agent, read by the simulation
+    AgentRing<AgentAction>& GetActions();
+
+private:
+    bool Map(const std::string& name, bool create);
+
+private:
+    AgentChannelLayout* mLayout = nullptr;
+    std::string mName;
+    bool mOwner = false;
+
+#if defined(_WIN32)
+    void* mMappingHandle = nullptr;
+#endif
+};
@@ -2,6 +2,11 @@
 #include "MaterialManager.h"
 #include "TextureManager.h"
 #include "PipelineManager.h"
+#include "MeshCache.h"
+#include "ChunkMesher.h"
+
+#include <chrono>
+#include <filesystem>
 
 #include "imgui/imgui.h"
 
@@ -10,30 +15,94 @@ Application::Application() :
 {
 }
 
+void Application::SetLevelPath(const std::string& levelPath)
+{
+    mLevelPath = levelPath;
+}
+
+void Application::SetEndless(bool endless)
+{
+    mEndless = endless;
+}
+
+void Application::SetBakedMeshes(bool bakedMeshes)
+{
+    mBakedMeshes = bakedMeshes;
+}
+
+void Application::SetAgentChannel(const std::string& name)
+{
+    mAgentChannelName = name;
+}
+
+void Application::SetSpectatorPort(uint16_t port)
+{
+    mSpectatorPort = port;
+}
+
 bool Application::OnInit(ID3D12GraphicsCommandList* initializationCmdList, ID3D12CommandAllocator* cmdAllocator)
 {
+    mLoadingStart = std::chrono::steady_clock::now();
     mSceneLight.SetAmbientColor(0.1f, 0.1f, 0.1f, 1.0f);
     // mSceneLight.SetAmbientColor(1.0f, 1.0f, 1.0f, 1.0f);
     mSceneLight.AddDirectionalLight("Sun", DirectX::XMFLOAT3(-0.5f, -1.0f, 0.0f), DirectX::XMFLOAT3(0.5f, 0.5f, 0.5f));
 
     CHECK(InitModels(initializationCmdList, cmdAllocator), false, "Unable to initialize all models");
 
+    if (!mAgentChannelName.empty())
+    {
+        CHECK(mAgentChannel.Create(mAgentChannelName), false, "Unable to create the agent channel {}", mAgentChannelName);
+        SHOWINFO("Waiting for agents on channel {}", mAgentChannelName);
+    }
+    if (mSpectatorPort != 0)
+    {
+        CHECK(mSpectatorServer.Start(mSpectatorPort), false, "Unable to stream to spectators on port {}", mSpectatorPort);
+        SHOWINFO("Streaming to spectators on port {}", mSpectatorServer.GetPort());
+    }
+
     return true;
 }
 
 bool Application::OnUpdate(FrameResources* frameResources, float dt)
 {
+    // Last frame's scratch, rendering included, is done with. Grows it when last frame didn't fit, which still counts
+    // against last frame
+    FrameArena::Get().Reset();
+    CheckSteadyAllocations();
+    if (IsLoading())
+    {
+        ExpectAllocations();
+        if (!mStartupGraph.Poll())
+        {
+            return true;
+        }
+        CHECK(FinishLoading(), false, "Unable to load the maze");
+    }
     ReactToKeyPresses(dt);
+    UpdateAgent(dt);
     UpdateCamera(frameResources);
     UpdateModels(frameResources);
     mSceneLight.UpdateLightsBuffer(frameResources->LightsBuffer);
+    UpdateTorchLights(frameResources);
     mProjectileManager.Update(dt);
     mMaze.Update(dt);
+    mMaze.UpdateStreaming(mPlayer.mPosition);
+    CHECK(UpdateLevel(), false, "Unable to enter level {}", mLevel + 1);
+#if RENDERER_INSTANCE_MOTION
+    // Every frame, the vertex shader moves the enemies from their last patrol to where the maze is now
+    frameResources->PerPassBuffers.GetMappedMemory()->Time = (float)mMaze.GetSimulationTime();
+#endif
+    UpdateSpectators();
     return true;
 }
 
 bool Application::OnRender(ID3D12GraphicsCommandList* cmdList, FrameResources* frameResources)
 {
+    if (IsLoading())
+    {
+        return RenderLoadingScreen(cmdList);
+    }
+
     auto d3d = Direct3D::Get();
     auto pipelineManager = PipelineManager::Get();
     frameResources->VertexBatchRenderer.Begin();
@@ -60,11 +129,21 @@ bool Application::OnRender(ID3D12GraphicsCommandList* cmdList, FrameResources* f
     Model::Bind(cmdList);
     ResetModelsInstances();
 
-    mMaze.Render();
+    mCuller.Update(mActiveCamera->GetView(), mActiveCamera->GetProjection());
+    // The third person camera looks over the walls, so only the first person one can use the visible sets
+    if (mActiveCamera == &mFirstPersonCamera)
+    {
+        mMaze.UpdateVisibility(mActiveCamera->GetPosition());
+    }
+    else
+    {
+        mMaze.DisableVisibility();
+    }
+    mMaze.Render(mCuller);
     // mMaze.RenderDebug(frameResources->VertexBatchRenderer);
-    mPlayer.Render();
+    mPlayer.Render(mCuller);
     // mPlayer.RenderDebug(frameResources->VertexBatchRenderer);
-    mProjectileManager.Render();
+    mProjectileManager.Render(mCuller);
 
     cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     RenderModels(cmdList, frameResources);
@@ -79,6 +158,42 @@ bool Application::OnRender(ID3D12GraphicsCommandList* cmdList, FrameResources* f
 
 bool Application::OnRenderGUI()
 {
+    if (IsLoading())
+    {
+        ImGui::Begin("Loading");
+        ImGui::Text("Generating the maze... %.1f s", std::chrono::duration<float>(std::chrono::steady_clock::now() - mLoadingStart).count());
+        ImGui::End();
+        return true;
+    }
+    if (mMenuActive)
+    {
+        const auto& statistics = mCuller.GetStatistics();
+        ImGui::Begin("Culling");
+        ImGui::Text("Level %u", mLevel);
+        ImGui::Text("Chunks: %u visible, %u culled", statistics.VisibleChunks, statistics.CulledChunks);
+        ImGui::Text("Instances: %u visible, %u culled", statistics.VisibleInstances, statistics.CulledInstances);
+        ImGui::Text("Occluded by the visible sets: %u", mMaze.GetNumOccludedInstances());
+        ImGui::Text("Enemies resumed this tick: %u", mMaze.GetNumSimulatedEnemies());
+        ImGui::End();
+
+        auto& memoryTracker = MemoryTracker::Get();
+        ImGui::Begin("Memory");
+        for (uint32_t i = 0; i < (uint32_t)MemoryTag::Count; ++i)
+        {
+            auto statistics = memoryTracker.GetStatistics((MemoryTag)i);
+            ImGui::Text("%s: %.1f KB live, %.1f KB peak, %llu allocations, %llu last frame", memoryTracker.GetName((MemoryTag)i),
+                statistics.LiveBytes / 1024.0f, statistics.PeakBytes / 1024.0f, (unsigned long long)statistics.NumAllocations,
+                (unsigned long long)statistics.FrameAllocations);
+        }
+        const auto& frameArena = FrameArena::Get();
+        ImGui::Text("Frame arena: %.1f KB used, %.1f KB peak, %.1f KB reserved", frameArena.GetUsedBytes() / 1024.0f,
+            frameArena.GetPeakBytes() / 1024.0f, frameArena.GetCapacity() / 1024.0f);
+        if (ImGui::Button("Dump to memory.json"))
+        {
+            CHECKSHOW(memoryTracker.DumpJson("memory.json"), "Unable to write memory.json");
+        }
+        ImGui::End();
+    }
     return true;
 }
 
@@ -105,6 +220,16 @@ bool Application::OnResize()
 }
 
 std::unordered_map<uuids::uuid, uint32_t> Application::GetInstanceCount()
+{
+    // The startup tasks are adding instances, the counts from before they started have to do
+    if (IsLoading())
+    {
+        return mInstanceCountWhileLoading;
+    }
+    return CountInstances();
+}
+
+std::unordered_map<uuids::uuid, uint32_t> Application::CountInstances() const
 {
     std::unordered_map<uuids::uuid, uint32_t> result;
     for (const auto& model : mModels)
@@ -135,48 +260,466 @@ ID3D12PipelineState* Application::GetBeginFramePipeline()
 bool Application::InitModels(ID3D12GraphicsCommandList* initializationCmdList, ID3D12CommandAllocator* cmdAllocator)
 {
     auto d3d = Direct3D::Get();
-    auto materialManager = MaterialManager::Get();
     CHECK_HR(cmdAllocator->Reset(), false);
     CHECK_HR(initializationCmdList->Reset(cmdAllocator, nullptr), false);
 
-    CHECK(mCubeModel.Create(Direct3D::kBufferCount, 0, "Resources\\Cube.obj"), false, "Unable to load cube");
-    mCubeModel.ClearInstances();
-    mModels.push_back(&mCubeModel);
-
-
-    CHECK(mSphereModel.Create(Direct3D::kBufferCount, 1, "Resources\\Sphere.obj"), false, "Unable to load cube");
-    mSphereModel.ClearInstances();
-    mModels.push_back(&mSphereModel);
-
-    ComPtr<ID3D12Resource> intermediaryResources[2];
-    CHECK(Model::InitBuffers(initializationCmdList, intermediaryResources), false, "Unable to initialize buffers for models");
-
     mFirstPersonCamera.Create({ 0.0f, 0.0f, 0.0f }, (float)mClientWidth / mClientHeight);
     mThirdPersonCamera.Create((float)mClientWidth / mClientHeight);
-    CHECK(mPlayer.Create(&mCubeModel, &mMaze), false, "Unable to create player model");
-    mPlayer.SetCamera(&mThirdPersonCamera);
     mActiveCamera = &mThirdPersonCamera;
 
-    CHECK(mProjectileManager.Create(&mSphereModel, &mMaze, MaximumProjectiles), false, "Unable to initialize projectile manager");
+    // A model's index is its place in mModels, so these two go first whichever is loaded first
+    mModels.push_back(&mCubeModel);
+    mModels.push_back(&mSphereModel);
+    auto mazeInfo = GetMazeInitializationInfo();
 
+    // Only uploading the meshes needs the command list, everything before it loads in parallel and the maze is
+    // generated next to all of it. Models share the renderer's geometry buffers and their place in mModels, so they
+    // are created one after the other. Tasks adding instances to the same model never run at the same time
+    auto& graph = mStartupGraph;
+    auto cube = graph.Add("Load the cube", [this]()
+        {
+            CHECK(mCubeModel.Create(Direct3D::kBufferCount, 0, ResolveMeshPath("Resources\\Cube.obj")), false, "Unable to load cube");
+            mCubeModel.ClearInstances();
+            return true;
+        });
+    auto sphere = graph.Add("Load the sphere", [this]()
+        {
+            CHECK(mSphereModel.Create(Direct3D::kBufferCount, 1, ResolveMeshPath("Resources\\Sphere.obj")), false, "Unable to load sphere");
+            mSphereModel.ClearInstances();
+            return true;
+        }, { cube });
+    // Baked with the cube's box, while the sphere loads
+    auto bake = graph.Add("Bake the chunk meshes", [this]()
+        {
+            if (mBakedMeshes)
+            {
+                CHECKSHOW(!mLevelPath.empty(), "Baked meshes need a level, rendering tiles instead");
+                if (!mLevelPath.empty() && !BakeChunkMeshes())
+                {
+                    SHOWINFO("Unable to bake the meshes of {}, rendering tiles instead", mLevelPath);
+                    mChunkMeshPaths.clear();
+                }
+            }
+            return true;
+        }, { cube });
+    auto chunks = graph.Add("Load the chunk meshes", [this]()
+        {
+            if (!mChunkMeshPaths.empty() && !CreateChunkModels())
+            {
+                SHOWINFO("Unable to load the meshes of {}, rendering tiles instead", mLevelPath);
+                for (const auto& chunkModel : mChunkModels)
+                {
+                    if (chunkModel)
+                    {
+                        mModels.erase(std::remove(mModels.begin(), mModels.end(), chunkModel.get()), mModels.end());
+                    }
+                }
+                mChunkModels.clear();
+            }
+            return true;
+        }, { sphere, bake });
+    auto upload = graph.AddOnWaitingThread("Upload the meshes", [this, d3d, initializationCmdList]()
+        {
+            ComPtr<ID3D12Resource> intermediaryResources[2];
+            CHECK(Model::InitBuffers(initializationCmdList, intermediaryResources), false, "Unable to initialize buffers for models");
+            CHECK_HR(initializationCmdList->Close(), false);
+            d3d->Flush(initializationCmdList, mFence.Get(), ++mCurrentFrame);
+            // The tasks adding instances only start after this one
+            mInstanceCountWhileLoading = CountInstances();
+            return true;
+        }, { chunks });
+    auto player = graph.Add("Create the player", [this]()
+        {
+            CHECK(mPlayer.Create(&mCubeModel, &mMaze), false, "Unable to create player model");
+            mPlayer.SetCamera(&mThirdPersonCamera);
+            return true;
+        }, { upload });
+    auto projectiles = graph.Add("Create the projectiles", [this]()
+        {
+            CHECK(mProjectileManager.Create(&mSphereModel, &mMaze, MaximumProjectiles), false, "Unable to initialize projectile manager");
+            return true;
+        }, { upload });
+    auto createMaze = [this](Maze::MazeInitializationInfo mazeInfo, bool fromLayout)
+    {
+        for (const auto& chunkModel : mChunkModels)
+        {
+            mazeInfo.chunkModels.push_back(chunkModel.get());
+        }
+        auto startPositionResult = fromLayout ? mMaze.Create(mazeInfo, std::move(mNextLayout)) : mMaze.Create(mazeInfo);
+        CHECK(startPositionResult.Valid(), false, "Unable to create maze");
+        mStartPosition = startPositionResult.Get();
+        return true;
+    };
+    if (!mEndless && mLevelPath.empty())
+    {
+        // The first level's layout is built where the next ones' go
+        auto layout = graph.Add("Generate the maze", [this, mazeInfo]() { return Maze::BuildLayout(mazeInfo, mNextLayout); });
+        graph.Add("Create the maze instances", [createMaze, mazeInfo]() { return createMaze(mazeInfo, true); }, { layout, player, projectiles });
+    }
+    else
+    {
+        graph.Add("Create the maze", [createMaze, mazeInfo]() { return createMaze(mazeInfo, false); }, { upload, player, projectiles });
+    }
+
+    mLoading = true;
+    mStartupThreads = std::make_unique<ThreadPool>();
+    graph.Start(*mStartupThreads);
+    // The rest goes on behind the loading screen, see FinishLoading
+    CHECK(graph.Wait(upload), false, "Unable to load the models");
+    return true;
+}
+
+Maze::MazeInitializationInfo Application::GetMazeInitializationInfo()
+{
     Maze::MazeInitializationInfo mazeInfo = {};
     mazeInfo.rows = Random::get(10, 20);
     mazeInfo.cols = Random::get(10, 20);
-    mazeInfo.tileWidthDepth = 5.0f;
+    mazeInfo.seed = Random::get(0u, std::numeric_limits<uint32_t>::max());
+    mazeInfo.tileWidthDepth = GameRules::kTileSize;
+    mazeInfo.levelPath = mLevelPath;
+    mazeInfo.visibilityRadius = 24;
+    if (mEndless)
+    {
+        mazeInfo.endless = true;
+        mazeInfo.rows = 64;
+        mazeInfo.cols = 21;
+        mazeInfo.visibilityRadius = 0;
+    }
     mazeInfo.cubeModel = &mCubeModel;
     mazeInfo.enemyModel = &mSphereModel;
-    auto startPositionResult = mMaze.Create(mazeInfo);
-    CHECK(startPositionResult.Valid(), false, "Unable to create maze");
+    return mazeInfo;
+}
+
+bool Application::IsLoading() const
+{
+    return mLoading;
+}
+
+bool Application::FinishLoading()
+{
+    mLoading = false;
+    mStartupThreads.reset();
+    SHOWINFO("Startup timeline: {}", mStartupGraph.FormatTimeline());
+    CHECK(mStartupGraph.Succeeded(), false, "Unable to create the maze");
+    // The game's first frame is this one
+    SHOWINFO("{:.2f} ms from initialization to the first frame",
+        std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - mLoadingStart).count());
+    CheckModelSizes();
+    EnterLevel(mStartPosition);
+    PrewarmNextLevel();
+    return true;
+}
+
+void Application::CheckModelSizes() const
+{
+    auto matches = [](float measured, float expected)
+    {
+        return std::fabs(measured - expected) <= GameRules::kModelSizeTolerance;
+    };
+    const auto& sphere = mSphereModel.GetBoundingBox().Extents;
+    const auto& cube = mCubeModel.GetBoundingBox().Extents;
+    float sphereHalfExtent = std::max(sphere.x, sphere.z), cubeHalfExtent = std::max(cube.x, cube.z);
+    CHECKSHOW(matches(mPlayer.mRadius, GameRules::kPlayerRadius),
+        "The player radius is {}, SimWorld runs with {}", mPlayer.mRadius, GameRules::kPlayerRadius);
+    CHECKSHOW(matches(sphereHalfExtent, GameRules::kEnemyHalfExtent),
+        "The enemies are {} across, SimWorld runs with {}", 2.0f * sphereHalfExtent, 2.0f * GameRules::kEnemyHalfExtent);
+    CHECKSHOW(matches(sphereHalfExtent * Projectile::scale, GameRules::kProjectileHalfExtent),
+        "The projectiles are {} across, SimWorld runs with {}", 2.0f * sphereHalfExtent * Projectile::scale,
+        2.0f * GameRules::kProjectileHalfExtent);
+    CHECKSHOW(matches(cubeHalfExtent, GameRules::kWallHalfExtent),
+        "The cube is {} across, SimWorld runs with {}", 2.0f * cubeHalfExtent, 2.0f * GameRules::kWallHalfExtent);
+}
+
+bool Application::RenderLoadingScreen(ID3D12GraphicsCommandList* cmdList)
+{
+    auto d3d = Direct3D::Get();
+    FLOAT backgroundColor[4] = { 0.2f, 0.2f, 0.2f, 1.0f };
+    auto backbufferHandle = d3d->GetBackbufferHandle();
+    auto dsvHandle = d3d->GetDSVHandle();
+
+    cmdList->RSSetViewports(1, &mViewport);
+    cmdList->RSSetScissorRects(1, &mScissors);
+    cmdList->ClearRenderTargetView(backbufferHandle, backgroundColor, 0, nullptr);
+    cmdList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+    cmdList->OMSetRenderTargets(1, &backbufferHandle, TRUE, &dsvHandle);
+    return true;
+}
+
+void Application::PrewarmNextLevel()
+{
+    // Endless mazes have no exit, and a level file is the only level there is
+    if (mEndless || !mLevelPath.empty())
+    {
+        return;
+    }
+    mNextMazeInfo = GetMazeInitializationInfo();
+    mNextLayoutBuilt = mLevelThread.Submit([this]() { return Maze::BuildLayout(mNextMazeInfo, mNextLayout); });
+}
+
+bool Application::UpdateLevel()
+{
+    if (!mNextLayoutBuilt.valid() || mPlayer.mHealth <= 0.0f)
+    {
+        return true;
+    }
+    DirectX::XMFLOAT3 playerPosition;
+    DirectX::XMStoreFloat3(&playerPosition, mPlayer.mPosition);
+    auto playerTile = mMaze.GetCoordinatesFromPosition(playerPosition);
+    auto exitTile = mMaze.GetExitCoordinates();
+    if (playerTile.x != exitTile.x || playerTile.y != exitTile.y)
+    {
+        return true;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    // Only waits when the exit is reached faster than the layout is built
+    bool built = mNextLayoutBuilt.get();
+    auto layoutReady = std::chrono::steady_clock::now();
+    CHECK(built, false, "Unable to generate the maze of level {}", mLevel + 1);
+    auto startPositionResult = mMaze.Create(mNextMazeInfo, std::move(mNextLayout));
+    CHECK(startPositionResult.Valid(), false, "Unable to create the maze of level {}", mLevel + 1);
+    mLevel++;
+    mRemainingTime = MaximumTime;
+    // Snapshots only load into the maze they were taken in
+    mQuickSave.Clear();
+    // Projectiles in flight would keep going through the walls of the old maze
+    mProjectileManager.Reset();
+    EnterLevel(startPositionResult.Get());
+    ExpectAllocations();
+    auto end = std::chrono::steady_clock::now();
+    SHOWINFO("Entered level {} in {:.3f} ms, {:.3f} ms of which waiting for its layout", mLevel,
+        std::chrono::duration<float, std::milli>(end - begin).count(), std::chrono::duration<float, std::milli>(layoutReady - begin).count());
+
+    PrewarmNextLevel();
+    return true;
+}
+
+void Application::EnterLevel(DirectX::XMFLOAT3 startPosition)
+{
+    mTorches.clear();
+    mMaze.PlaceTorches(TorchSpacing, mTorches);
+    SHOWINFO("Placed {} torches", mTorches.size());
 
-    // mPlayer.mPosition = DirectX::XMVectorSetY(mPlayer.mPosition);
-    auto& startPosition = startPositionResult.Get();
     startPosition.y = mPlayer.mModel.GetHalfHeight() + 0.25f; // animation looks better if we offset the model by 0.25f
     mPlayer.mPosition = DirectX::XMLoadFloat3(&startPosition);
-    mThirdPersonCamera.SetTarget(mPlayer.mPosition);
+    UpdateCameraTarget(mPlayer.mPosition);
+}
+
+std::string Application::ResolveMeshPath(const std::string& sourcePath)
+{
+    auto cachePath = MeshCache::FindCachedMesh(sourcePath);
+    if (cachePath.empty())
+    {
+        SHOWINFO("No up to date baked mesh for {}, loading the source. Run MeshBaker to speed up startup", sourcePath);
+        return sourcePath;
+    }
+    return cachePath;
+}
+
+bool Application::BakeChunkMeshes()
+{
+    MazeFile levelFile;
+    CHECK(levelFile.Open(mLevelPath), false, "Unable to open maze level {}", mLevelPath);
+    const auto& header = levelFile.GetHeader();
+    uint32_t numChunksX = (header.Cols + Maze::kChunkSize - 1) / Maze::kChunkSize;
+    uint32_t numChunksY = (header.Rows + Maze::kChunkSize - 1) / Maze::kChunkSize;
+    CHECK(numChunksX * numChunksY <= MaximumBakedChunks, false,
+        "Level {} has {} chunks, baked meshes only support up to {}", mLevelPath, numChunksX * numChunksY, MaximumBakedChunks);
+
+    std::error_code error;
+    std::filesystem::create_directories(ChunkMesher::GetMeshDirectory(mLevelPath), error);
+    CHECK(!error, false, "Unable to create {}: {}", ChunkMesher::GetMeshDirectory(mLevelPath), error.message());
+
+    // Baked with the actual cube, so the meshes match the tiles the collisions are computed against
+    const auto& cubeBox = mCubeModel.GetBoundingBox();
+    const float boxMin[3] = { cubeBox.Center.x - cubeBox.Extents.x, cubeBox.Center.y - cubeBox.Extents.y, cubeBox.Center.z - cubeBox.Extents.z };
+    const float boxMax[3] = { cubeBox.Center.x + cubeBox.Extents.x, cubeBox.Center.y + cubeBox.Extents.y, cubeBox.Center.z + cubeBox.Extents.z };
+
+    uint64_t numTriangles = 0;
+    ChunkMesh parts[ChunkMesher::kNumParts];
+    mChunkMeshPaths.assign((std::size_t)numChunksX * numChunksY * ChunkMesher::kNumParts, std::string());
+    for (uint32_t chunkY = 0; chunkY < numChunksY; ++chunkY)
+    {
+        for (uint32_t chunkX = 0; chunkX < numChunksX; ++chunkX)
+        {
+            TileRect area = { chunkY * Maze::kChunkSize, chunkX * Maze::kChunkSize, 0, 0 };
+            area.rows = std::min(Maze::kChunkSize, header.Rows - area.row);
+            area.cols = std::min(Maze::kChunkSize, header.Cols - area.col);
+            ChunkMesher::Build(levelFile.GetTiles(), header.Rows, header.Cols, area, header.TileWidthDepth, boxMin, boxMax, parts);
+
+            for (uint32_t part = 0; part < ChunkMesher::kNumParts; ++part)
+            {
+                if (parts[part].Empty())
+                {
+                    continue;
+                }
+                auto path = ChunkMesher::GetMeshPath(mLevelPath, chunkX, chunkY, (ChunkMeshPart)part);
+                CHECK(ChunkMesher::WriteObj(path, parts[part]), false, "Unable to write chunk mesh {}", path);
+                mChunkMeshPaths[((std::size_t)chunkY * numChunksX + chunkX) * ChunkMesher::kNumParts + part] = std::move(path);
+                numTriangles += parts[part].GetTriangleCount();
+            }
+        }
+    }
 
-    CHECK_HR(initializationCmdList->Close(), false);
-    d3d->Flush(initializationCmdList, mFence.Get(), ++mCurrentFrame);
+    SHOWINFO("Baked {} chunks of {} into {} triangles, instancing its tiles takes {}", numChunksX * numChunksY, mLevelPath,
+        numTriangles, (uint64_t)header.Rows * header.Cols * ChunkMesher::kTrianglesPerTile);
+    return true;
+}
 
+bool Application::CreateChunkModels()
+{
+    // Models can only be created before their buffers are initialized, so this runs before the maze is loaded
+    mChunkModels.resize(mChunkMeshPaths.size());
+    for (std::size_t i = 0; i < mChunkMeshPaths.size(); ++i)
+    {
+        const auto& path = mChunkMeshPaths[i];
+        if (path.empty())
+        {
+            continue;
+        }
+        auto model = std::make_unique<Model>();
+        CHECK(model->Create(Direct3D::kBufferCount, (uint32_t)mModels.size(), path), false, "Unable to load chunk mesh {}", path);
+        model->ClearInstances();
+        mModels.push_back(model.get());
+        mChunkModels[i] = std::move(model);
+    }
+    return true;
+}
+
+void Application::UpdateAgent(float dt)
+{
+    if (!mAgentChannel.IsOpen())
+    {
+        return;
+    }
+
+    // The game never waits for the agent: one action is taken per frame when there is one, and the
+    // observation is dropped when the agent is too far behind to have room for it
+    if (const auto* action = mAgentChannel.GetActions().BeginRead())
+    {
+        if (mPlayer.mHealth > 0.0f)
+        {
+            if ((action->MoveX != 0.0f || action->MoveZ != 0.0f) &&
+                mPlayer.Move(dt, DirectX::XMVectorSet(action->MoveX, 0.0f, action->MoveZ, 0.0f)))
+            {
+                UpdateCameraTarget(mPlayer.mPosition);
+            }
+            if (action->Shoot && (action->AimX != 0.0f || action->AimZ != 0.0f))
+            {
+                auto direction = DirectX::XMVector3Normalize(DirectX::XMVectorSet(action->AimX, 0.0f, action->AimZ, 0.0f));
+                mProjectileManager.SpawnProjectile(mPlayer.mPosition, direction);
+            }
+        }
+        mAgentChannel.GetActions().EndRead();
+    }
+
+    if (auto* observation = mAgentChannel.GetObservations().BeginWrite())
+    {
+        DirectX::XMFLOAT3 playerPosition;
+        DirectX::XMStoreFloat3(&playerPosition, mPlayer.mPosition);
+        mMaze.Observe(playerPosition, *observation);
+        observation->Tick = mAgentTick;
+        observation->Health = mPlayer.mHealth;
+        observation->RemainingTime = mRemainingTime;
+        observation->Outcome = 0;
+        mAgentChannel.GetObservations().EndWrite();
+    }
+    mAgentTick++;
+}
+
+void Application::CheckSteadyAllocations()
+{
+    auto& memoryTracker = MemoryTracker::Get();
+    memoryTracker.EndFrame();
+    bool warm = ++mNumSteadyFrames > MemoryWarmupFrames;
+    for (uint32_t i = 0; i < (uint32_t)MemoryTag::Count; ++i)
+    {
+        auto numAllocations = memoryTracker.GetStatistics((MemoryTag)i).NumAllocations;
+        auto frameAllocations = numAllocations - mFrameStartAllocations[i];
+        mFrameStartAllocations[i] = numAllocations;
+        if (warm && frameAllocations > 0 && !mReportedSteadyAllocations[i])
+        {
+            SHOWINFO("{} still made {} allocations in a frame, {} frames after warm up started", memoryTracker.GetName((MemoryTag)i),
+                frameAllocations, mNumSteadyFrames);
+            mReportedSteadyAllocations[i] = true;
+        }
+    }
+}
+
+void Application::ExpectAllocations()
+{
+    mNumSteadyFrames = 0;
+}
+
+void Application::UpdateSpectators()
+{
+    if (!mSpectatorServer.IsRunning())
+    {
+        return;
+    }
+
+    // Only gathering the entities happens here, the server thread encodes and sends them
+    auto& frame = mSpectatorServer.BeginPublish();
+    frame.Tick = mSpectatorTick++;
+    frame.Health = mPlayer.mHealth;
+    frame.RemainingTime = mRemainingTime;
+    frame.Entities.clear();
+    DirectX::XMFLOAT3 playerPosition;
+    DirectX::XMStoreFloat3(&playerPosition, mPlayer.mPosition);
+    frame.Entities.push_back({ SpectatorEntity::MakeId(SpectatorEntityKind::Player, 0), 0,
+        playerPosition.x, playerPosition.y, playerPosition.z, mPlayer.mYAngle });
+    mMaze.Spectate(frame);
+    mProjectileManager.Spectate(frame);
+    mSpectatorServer.EndPublish();
+}
+
+void Application::SaveSnapshot(WorldSnapshot& snapshot) const
+{
+    auto begin = std::chrono::high_resolution_clock::now();
+    WriteSnapshot(snapshot);
+    auto end = std::chrono::high_resolution_clock::now();
+    SHOWINFO("Saved a {:.2f} KB snapshot in {:.3f} ms", snapshot.GetSize() / 1024.0f,
+        std::chrono::duration<float, std::milli>(end - begin).count());
+}
+
+bool Application::LoadSnapshot(const WorldSnapshot& snapshot)
+{
+    CHECK(snapshot.GetSize() > 0, false, "There is no snapshot to load");
+    auto begin = std::chrono::high_resolution_clock::now();
+    // A short snapshot, or one of another world, is only found out once the parts before it are loaded, so the
+    // world is put back from the rollback then
+    WriteSnapshot(mRollback);
+    if (!ApplySnapshot(snapshot))
+    {
+        CHECK(ApplySnapshot(mRollback), false, "Unable to restore the world after failing to load a snapshot");
+        return false;
+    }
+    UpdateCameraTarget(mPlayer.mPosition);
+    auto end = std::chrono::high_resolution_clock::now();
+    SHOWINFO("Loaded a {:.2f} KB snapshot in {:.3f} ms", snapshot.GetSize() / 1024.0f,
+        std::chrono::duration<float, std::milli>(end - begin).count());
+    return true;
+}
+
+void Application::WriteSnapshot(WorldSnapshot& snapshot) const
+{
+    snapshot.Clear();
+    snapshot.Write(mRemainingTime);
+    // Enemies pick their directions and speeds from the shared generator, so the rolled back world only replays
+    // exactly when the generator is rolled back too
+    snapshot.Write(Random::get_engine());
+    mPlayer.SaveState(snapshot);
+    mProjectileManager.SaveState(snapshot);
+    mMaze.SaveState(snapshot);
+}
+
+bool Application::ApplySnapshot(const WorldSnapshot& snapshot)
+{
+    WorldSnapshot::Reader reader(snapshot);
+    CHECK(reader.Read(mRemainingTime) && reader.Read(Random::get_engine()), false, "Unable to load the timer and the random generator from the snapshot");
+    CHECK(mPlayer.LoadState(reader), false, "Unable to load the player from the snapshot");
+    CHECK(mProjectileManager.LoadState(reader), false, "Unable to load the projectiles from the snapshot");
+    CHECK(mMaze.LoadState(reader), false, "Unable to load the maze from the snapshot");
     return true;
 }
 
@@ -193,6 +736,15 @@ void Application::ReactToKeyPresses(float dt)
         PostQuitMessage(0);
     }
 
+    // Rolling back also works after dying
+    static bool quickLoadPressed = false;
+    if (kb.F9 && !quickLoadPressed)
+    {
+        LoadSnapshot(mQuickSave);
+        ExpectAllocations();
+    }
+    quickLoadPressed = kb.F9;
+
     if (mPlayer.mHealth > 0.0f)
     {
         if (kb.Up || kb.W)
@@ -232,6 +784,14 @@ void Application::ReactToKeyPresses(float dt)
             mPlayer.ResetAnimation();
         }
 
+        static bool quickSavePressed = false;
+        if (kb.F5 && !quickSavePressed)
+        {
+            SaveSnapshot(mQuickSave);
+            ExpectAllocations();
+        }
+        quickSavePressed = kb.F5;
+
         static bool spacePressed = false;
         if (kb.Space && !spacePressed)
         {
@@ -343,6 +903,71 @@ void Application::UpdateModels(FrameResources* frameResources)
 
 }
 
+void Application::UpdateTorchLights(FrameResources* frameResources)
+{
+    if (mTorches.empty())
+    {
+        return;
+    }
+
+    DirectX::XMFLOAT3 cameraPosition;
+    DirectX::XMStoreFloat3(&cameraPosition, mActiveCamera->GetPosition());
+    auto toLightCB = [&](uint32_t torchIndex)
+    {
+        const auto& torch = mTorches[torchIndex];
+        LightCB light;
+        light.Strength = { torch.Strength[0], torch.Strength[1], torch.Strength[2] };
+        light.FalloffStart = torch.FalloffStart;
+        light.FalloffEnd = torch.FalloffEnd;
+        light.Position = { torch.Position[0], torch.Position[1], torch.Position[2] };
+        return light;
+    };
+    auto* lightsBuffer = frameResources->LightsBuffer.GetMappedMemory();
+
+#if RENDERER_LIGHT_CLUSTERS
+    static_assert(LightBinner::kClustersAcross == LIGHT_CLUSTERS_ACROSS, "The light binner and the frame resources must agree on the cluster grid");
+    static_assert(sizeof(LightBinner::Cluster) == sizeof(LightCluster), "Clusters are copied as they are");
+
+    // Centered on the camera, but snapped to whole clusters so lights don't move between clusters every frame
+    float halfGridSize = TorchClusterSize * LightBinner::kClustersAcross / 2.0f;
+    float originX = std::floor((cameraPosition.x - halfGridSize) / TorchClusterSize) * TorchClusterSize;
+    float originZ = std::floor((cameraPosition.z - halfGridSize) / TorchClusterSize) * TorchClusterSize;
+    mLightBinner.Bin(mTorches.data(), (uint32_t)mTorches.size(), originX, originZ, TorchClusterSize, MAX_BINNED_LIGHTS, MAX_LIGHT_INDICES);
+
+    const auto& binnedLights = mLightBinner.GetBinnedLights();
+    auto* pointLights = frameResources->PointLightsBuffer.GetMappedMemory();
+    for (uint32_t i = 0; i < (uint32_t)binnedLights.size(); ++i)
+    {
+        pointLights[i] = toLightCB(binnedLights[i]);
+    }
+    const auto& clusters = mLightBinner.GetClusters();
+    memcpy(frameResources->LightClustersBuffer.GetMappedMemory(), clusters.data(), clusters.size() * sizeof(LightCluster));
+    const auto& lightIndices = mLightBinner.GetLightIndices();
+    memcpy(frameResources->LightIndicesBuffer.GetMappedMemory(), lightIndices.data(), lightIndices.size() * sizeof(uint32_t));
+
+    lightsBuffer->NumBinnedLights = (unsigned int)binnedLights.size();
+    lightsBuffer->ClusterOrigin = { originX, originZ };
+    lightsBuffer->ClusterSize = TorchClusterSize;
+#else
+    // The forward shader only goes through the fixed light array, so the torches closest to the camera get the slots
+    // the scene lights left. Spot lights come after point lights in there, so leave it alone when there are any
+    if (lightsBuffer->NumSpotLights > 0)
+    {
+        return;
+    }
+    // Counted here rather than read back from the buffer, which may still hold the torches of this frame resource's last use
+    uint32_t firstFreeLight = lightsBuffer->NumDirectionalLights + mNumScenePointLights;
+    uint32_t closestLights[MAX_LIGHTS];
+    uint32_t numClosest = LightBinner::FindClosestLights(mTorches.data(), (uint32_t)mTorches.size(), cameraPosition.x,
+        cameraPosition.z, MAX_LIGHTS - std::min<uint32_t>(firstFreeLight, MAX_LIGHTS), closestLights);
+    for (uint32_t i = 0; i < numClosest; ++i)
+    {
+        lightsBuffer->Lights[firstFreeLight + i] = toLightCB(closestLights[i]);
+    }
+    lightsBuffer->NumPointLights = mNumScenePointLights + numClosest;
+#endif
+}
+
 void Application::RenderModels(ID3D12GraphicsCommandList* cmdList, FrameResources* frameResources)
 {
     auto textureManager = TextureManager::Get();
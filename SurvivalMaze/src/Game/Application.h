@@ -6,17 +6,39 @@
 #include "CompositeModel.h"
 #include "Player.h"
 #include "ProjectileManager.h"
+#include "SpectatorStream.h"
+#include "TaskGraph.h"
+
+#include <chrono>
+#include <future>
 
 
 
 class Application : public Engine
 {
-    static constexpr const uint32_t MaximumProjectiles = 2;
-    static constexpr const float MaximumTime = 600.f;
+    static constexpr const uint32_t MaximumProjectiles = GameRules::kMaximumProjectiles;
+    static constexpr const float MaximumTime = GameRules::kMaximumTime;
+    // Every baked chunk mesh is a model of its own, so only bake levels that small
+    static constexpr const uint32_t MaximumBakedChunks = 1024;
+    static constexpr const uint32_t TorchSpacing = 12; // About one in this many free tiles next to a wall gets a torch
+    static constexpr const float TorchClusterSize = 20.0f;
+    // Frames after which every per frame buffer should have reached its size, so the game stops allocating
+    static constexpr const uint32_t MemoryWarmupFrames = 600;
 public:
     Application();
     ~Application() = default;
 
+    // Load a baked maze level instead of generating a random one
+    void SetLevelPath(const std::string& levelPath);
+    // Endless runner mode, the maze keeps being generated in front of the player
+    void SetEndless(bool endless);
+    // Draw the level with static meshes baked per chunk instead of one cube per tile. Needs a level path
+    void SetBakedMeshes(bool bakedMeshes);
+    // Publish observations and take actions from an external agent through the named shared memory channel
+    void SetAgentChannel(const std::string& name);
+    // Stream every tick to spectator processes connecting to this port on the loopback interface
+    void SetSpectatorPort(uint16_t port);
+
 public:
     // Inherited via Engine
     virtual bool OnInit(ID3D12GraphicsCommandList* initializationCmdList, ID3D12CommandAllocator* cmdAllocator) override;
@@ -32,11 +54,50 @@ public:
 
 private:
     bool InitModels(ID3D12GraphicsCommandList* initializationCmdList, ID3D12CommandAllocator* cmdAllocator);
+    std::string ResolveMeshPath(const std::string& sourcePath);
+    // Meshes every chunk of the level and writes them next to it, then creates their models. Only creating models
+    // touches the renderer, so baking can run next to the other models being created
+    bool BakeChunkMeshes();
+    bool CreateChunkModels();
+    // Random settings for a new level, with a random seed, so only call it from the main thread
+    Maze::MazeInitializationInfo GetMazeInitializationInfo();
+
+    std::unordered_map<uuids::uuid, uint32_t> CountInstances() const;
+
+    // Startup is a TaskGraph. InitModels waits until the meshes are uploaded, the maze is created behind a loading
+    // screen. Nothing else may touch the models in the meantime
+    bool IsLoading() const;
+    bool FinishLoading();
+    bool RenderLoadingScreen(ID3D12GraphicsCommandList* cmdList);
+    // The layout of the level after this one is built on mLevelThread while this one is played, generated mazes only
+    void PrewarmNextLevel();
+    // Moves on to the next level once the player reaches the exit
+    bool UpdateLevel();
+    void EnterLevel(DirectX::XMFLOAT3 startPosition);
 
 private:
     void ReactToKeyPresses(float dt);
     void UpdateCamera(FrameResources* frameResources);
     void UpdateModels(FrameResources* frameResources);
+    void UpdateTorchLights(FrameResources* frameResources);
+    void UpdateAgent(float dt);
+    void UpdateSpectators();
+    // Snapshots the allocation counters of every subsystem at the start of each frame and, once the game is warm,
+    // reports the subsystems that allocated during the frame before, once each. Only the tracked resources are counted:
+    // the renderer's allocations and anything left on the default heap never show up here
+    void CheckSteadyAllocations();
+    // Loading, changing level and snapshots allocate on purpose, so the warm up starts over
+    void ExpectAllocations();
+    // Compares the sizes of the loaded models with the ones in GameRules, which SimWorld runs with
+    void CheckModelSizes() const;
+
+    // Everything the simulation changes, so it can be rolled back to this point
+    void SaveSnapshot(WorldSnapshot& snapshot) const;
+    // Leaves the world as it was when the snapshot can't be loaded
+    bool LoadSnapshot(const WorldSnapshot& snapshot);
+    void WriteSnapshot(WorldSnapshot& snapshot) const;
+    // Every part applies its sections as it reads them, so this can fail halfway through
+    bool ApplySnapshot(const WorldSnapshot& snapshot);
 
     void RenderModels(ID3D12GraphicsCommandList* cmdList, FrameResources* frameResources);
     void RenderHUD(ID3D12GraphicsCommandList* cmdList, FrameResources* frameResources);
@@ -54,17 +115,56 @@ private:
     ProjectileManager mProjectileManager;
 
     SceneLight mSceneLight;
+    uint32_t mNumScenePointLights = 0; // Added to mSceneLight, keep it in step with OnInit
+    std::vector<PointLight> mTorches;
+#if RENDERER_LIGHT_CLUSTERS
+    LightBinner mLightBinner;
+#endif
 
     Maze mMaze;
+    std::string mLevelPath;
+    bool mEndless = false;
+    bool mBakedMeshes = false;
+    std::vector<std::string> mChunkMeshPaths; // Per chunk and part, empty for parts without geometry
+    std::vector<std::unique_ptr<Model>> mChunkModels;
 
     float mRemainingTime = MaximumTime;
 
+    std::string mAgentChannelName;
+    AgentChannel mAgentChannel;
+    uint64_t mAgentTick = 0;
+
+    uint16_t mSpectatorPort = 0;
+    SpectatorServer mSpectatorServer;
+    uint32_t mSpectatorTick = 0;
+
+    uint32_t mNumSteadyFrames = 0; // Since the last ExpectAllocations
+    uint64_t mFrameStartAllocations[(uint32_t)MemoryTag::Count] = {};
+    bool mReportedSteadyAllocations[(uint32_t)MemoryTag::Count] = {};
+
+    WorldSnapshot mQuickSave{ MemoryTracker::Get().GetResource(MemoryTag::Snapshots) }; // F5 saves, F9 rolls back
+    WorldSnapshot mRollback{ MemoryTracker::Get().GetResource(MemoryTag::Snapshots) }; // The world before the last load
+
+    uint32_t mLevel = 1;
+    bool mLoading = false;
+    std::chrono::steady_clock::time_point mLoadingStart;
+    std::unordered_map<uuids::uuid, uint32_t> mInstanceCountWhileLoading;
+    DirectX::XMFLOAT3 mStartPosition = { 0.0f, 0.0f, 0.0f };
+    Maze::MazeInitializationInfo mNextMazeInfo;
+    Maze::Layout mNextLayout;
+    std::future<bool> mNextLayoutBuilt;
+    TaskGraph mStartupGraph;
+    // The thread pools come after everything their tasks use, so the tasks are done before any of it is destroyed
+    std::unique_ptr<ThreadPool> mStartupThreads; // Only during startup
+    ThreadPool mLevelThread{ 1 };
+
     D3D12_VIEWPORT mViewport;
     D3D12_RECT mScissors;
 
     ThirdPersonCamera mThirdPersonCamera;
     Camera mFirstPersonCamera;
     ICamera* mActiveCamera;
+    FrustumCuller mCuller;
     OrthographicCamera mOrthograficCamera;
     
 
@@ -0,0 +1,194 @@
+#include "AsyncLogger.h"
+
+#include <chrono>
+#include <fmt/args.h>
+#include <fmt/format.h>
+
+
+AsyncLogger& AsyncLogger::Get()
+{
+    static AsyncLogger logger;
+    return logger;
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    Stop();
+}
+
+void AsyncLogger::Start(Sink sink)
+{
+    if (mRunning.exchange(true))
+    {
+        return;
+    }
+    mSink = std::move(sink);
+    mWorker = std::thread(&AsyncLogger::WorkerLoop, this);
+}
+
+void AsyncLogger::Stop()
+{
+    if (!mRunning.exchange(false))
+    {
+        return;
+    }
+    mWorker.join();
+}
+
+void AsyncLogger::LogPayload(Level level, const char* format, std::string&& payload)
+{
+    auto* record = BeginRecord();
+    if (!record)
+    {
+        return;
+    }
+    record->level = level;
+    record->format = format;
+    record->numArguments = 0;
+    record->payload = new std::string(std::move(payload));
+    EndRecord();
+}
+
+uint64_t AsyncLogger::GetDroppedCount() const
+{
+    return mDropped.load(std::memory_order_relaxed);
+}
+
+AsyncLogger::Record* AsyncLogger::BeginRecord()
+{
+    auto& ring = GetThreadRing();
+    auto head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= kRingCapacity)
+    {
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return &ring.records[head % kRingCapacity];
+}
+
+void AsyncLogger::EndRecord()
+{
+    auto& ring = GetThreadRing();
+    ring.head.store(ring.head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+AsyncLogger::AsyncLogger() :
+    // The rings are freed when the logger is destroyed at exit, so the tracker must be created first to outlive it
+    mRings(MemoryTracker::Get().GetResource(MemoryTag::Logging))
+{
+}
+
+AsyncLogger::Ring& AsyncLogger::GetThreadRing()
+{
+    // Only the first message of every thread takes the lock
+    thread_local Ring* threadRing = nullptr;
+    if (!threadRing)
+    {
+        auto ring = MakeTracked<Ring>(MemoryTag::Logging);
+        threadRing = ring.get();
+        std::unique_lock<std::mutex> lock(mRingsMutex);
+        mRings.push_back(std::move(ring));
+    }
+    return *threadRing;
+}
+
+void AsyncLogger::WorkerLoop()
+{
+    bool running = true;
+    std::pmr::vector<Ring*> rings(MemoryTracker::Get().GetResource(MemoryTag::Logging));
+    while (running)
+    {
+        // Read the flag before draining, so everything logged before Stop is written
+        running = mRunning.load(std::memory_order_acquire);
+
+        rings.clear();
+        {
+            std::unique_lock<std::mutex> lock(mRingsMutex);
+            for (auto& ring : mRings)
+            {
+                rings.push_back(ring.get());
+            }
+        }
+        uint32_t numWritten = 0;
+        for (auto* ring : rings)
+        {
+            numWritten += Drain(*ring);
+        }
+
+        auto dropped = mDropped.load(std::memory_order_relaxed);
+        if (dropped != mReportedDropped)
+        {
+            mSink(Level::Error, fmt::format("Async logger dropped {} messages because the queue was full", dropped - mReportedDropped));
+            mReportedDropped = dropped;
+        }
+
+        // Producers never wake this thread up, that would cost them a syscall
+        if (numWritten == 0 && running)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+uint32_t AsyncLogger::Drain(Ring& ring)
+{
+    auto tail = ring.tail.load(std::memory_order_relaxed);
+    auto head = ring.head.load(std::memory_order_acquire);
+    for (auto i = tail; i != head; ++i)
+    {
+        Write(ring.records[i % kRingCapacity]);
+    }
+    ring.tail.store(head, std::memory_order_release);
+    return head - tail;
+}
+
+void AsyncLogger::Write(const Record& record)
+{
+    std::string message;
+    try
+    {
+        fmt::dynamic_format_arg_store<fmt::format_context> arguments;
+        if (record.payload)
+        {
+            arguments.push_back(*record.payload);
+        }
+        for (uint32_t i = 0; i < record.numArguments; ++i)
+        {
+            const auto& argument = record.arguments[i];
+            switch (argument.type)
+            {
+            case Argument::Type::Signed:
+                arguments.push_back(argument.signedValue);
+                break;
+            case Argument::Type::Unsigned:
+                arguments.push_back(argument.unsignedValue);
+                break;
+            case Argument::Type::Floating:
+                arguments.push_back(argument.floatingValue);
+                break;
+            case Argument::Type::Boolean:
+                arguments.push_back(argument.booleanValue);
+                break;
+            case Argument::Type::String:
+            default:
+                arguments.push_back(std::string(argument.stringValue));
+                break;
+            }
+        }
+        message = fmt::vformat(record.format, arguments);
+    }
+    catch (const fmt::format_error& error)
+    {
+        message = fmt::format("Unable to format \"{}\": {}", record.format, error.what());
+    }
+    delete record.payload;
+    mSink(record.level, message);
+}
+
+void AsyncLogger::CaptureString(Argument& argument, std::string_view value)
+{
+    argument.type = Argument::Type::String;
+    auto length = std::min<std::size_t>(value.size(), kMaxStringLength);
+    memcpy(argument.stringValue, value.data(), length);
+    argument.stringValue[length] = '\0';
+}
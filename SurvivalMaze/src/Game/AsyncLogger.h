@@ -0,0 +1,165 @@
+#pragma once
+
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "MemoryTracker.h"
+
+
+// Logging for hot paths. Log only copies the format string pointer and the arguments into a ring buffer owned
+// by the calling thread (single producer, single consumer, no locks), formatting and writing happen on a
+// background thread. When a ring is full the message is dropped and counted instead of blocking.
+// Messages of one thread keep their order, messages of different threads don't.
+// Format strings must outlive the logger (string literals), string arguments are copied but truncated
+class AsyncLogger
+{
+public:
+    static constexpr const uint32_t kRingCapacity = 1024; // Records per thread, a power of two
+    static constexpr const uint32_t kMaxArguments = 4;
+    static constexpr const uint32_t kMaxStringLength = 15;
+
+    enum class Level : uint8_t {
+        Info = 0,
+        Error,
+    };
+    using Sink = std::function<void(Level level, const std::string& message)>;
+
+public:
+    static AsyncLogger& Get();
+    ~AsyncLogger();
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+public:
+    // Messages logged before Start are kept (as long as they fit) and written once it starts
+    void Start(Sink sink);
+    // Writes everything that is still queued, then stops the background thread
+    void Stop();
+
+    template <typename... Args>
+    void Log(Level level, const char* format, const Args&... args)
+    {
+        static_assert(sizeof...(Args) <= kMaxArguments, "Too many arguments for an async log message");
+        auto* record = BeginRecord();
+        if (!record)
+        {
+            return;
+        }
+        record->level = level;
+        record->format = format;
+        record->numArguments = 0;
+        record->payload = nullptr;
+        (CaptureArgument(record->arguments[record->numArguments++], args), ...);
+        EndRecord();
+    }
+
+    // For big messages that are too expensive to format inline: payload is moved to the background thread
+    // and passed to format as its only argument
+    void LogPayload(Level level, const char* format, std::string&& payload);
+
+    uint64_t GetDroppedCount() const;
+
+private:
+    struct Argument {
+        enum class Type : uint8_t {
+            Signed = 0,
+            Unsigned,
+            Floating,
+            Boolean,
+            String,
+        };
+        Type type;
+        union {
+            int64_t signedValue;
+            uint64_t unsignedValue;
+            double floatingValue;
+            bool booleanValue;
+            char stringValue[kMaxStringLength + 1];
+        };
+    };
+
+    struct Record {
+        Level level;
+        uint32_t numArguments;
+        const char* format;
+        std::string* payload;
+        Argument arguments[kMaxArguments];
+    };
+
+    struct Ring {
+        Record records[kRingCapacity];
+        alignas(64) std::atomic<uint32_t> head = 0; // Written by the owning thread only
+        alignas(64) std::atomic<uint32_t> tail = 0; // Written by the background thread only
+    };
+
+private:
+    AsyncLogger();
+
+    Record* BeginRecord();
+    void EndRecord();
+    Ring& GetThreadRing();
+
+    void WorkerLoop();
+    // Returns how many records were written
+    uint32_t Drain(Ring& ring);
+    void Write(const Record& record);
+
+    template <typename T>
+    static void CaptureArgument(Argument& argument, const T& value)
+    {
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            argument.type = Argument::Type::Boolean;
+            argument.booleanValue = value;
+        }
+        else if constexpr (std::is_enum_v<T>)
+        {
+            CaptureArgument(argument, static_cast<std::underlying_type_t<T>>(value));
+        }
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+        {
+            argument.type = Argument::Type::Signed;
+            argument.signedValue = value;
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            argument.type = Argument::Type::Unsigned;
+            argument.unsignedValue = value;
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            argument.type = Argument::Type::Floating;
+            argument.floatingValue = value;
+        }
+        else
+        {
+            CaptureString(argument, std::string_view(value));
+        }
+    }
+    static void CaptureString(Argument& argument, std::string_view value);
+
+private:
+    std::mutex mRingsMutex;
+    std::pmr::vector<TrackedPtr<Ring>> mRings;
+
+    Sink mSink;
+    std::thread mWorker;
+    std::atomic<bool> mRunning = false;
+
+    std::atomic<uint64_t> mDropped = 0;
+    uint64_t mReportedDropped = 0;
+};
+
+#define ASYNC_SHOWINFO(format, ...) AsyncLogger::Get().Log(AsyncLogger::Level::Info, format, ##__VA_ARGS__)
+#define ASYNC_CHECKCONT(condition, format, ...) \
+    if (!(condition)) { AsyncLogger::Get().Log(AsyncLogger::Level::Error, format, ##__VA_ARGS__); continue; }
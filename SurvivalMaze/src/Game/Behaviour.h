@@ -0,0 +1,48 @@
+#pragma once
+
+
+#include <cstdint>
+#include <limits>
+
+
+// Behaviour scripts that wait, written top to bottom like coroutines but in C++17: a script is a function returning
+// the time it wants to be resumed at. It starts with BEHAVIOUR_BEGIN, waits with BEHAVIOUR_WAIT and, the next time it
+// is called, carries on right after the wait it returned from. Only the resume point survives a wait, so anything else
+// a script needs across waits lives in its owner, and the arguments are whatever the next call passes.
+// The frame is part of the owner, so scripts never allocate and a waiting one costs nothing until it is resumed.
+// Every wait is named by a value of the owner's own enum, which is what snapshots store, so a resume point means the
+// same wait in every build. Waits can't be inside a switch of the script itself
+
+struct BehaviourFrame
+{
+    uint32_t ResumePoint = 0; // 0 at the start, then the point of the wait to carry on after
+};
+
+// Where a script is once it reached BEHAVIOUR_END
+constexpr const uint32_t kBehaviourEnded = ~0u;
+
+// Resume on the next tick
+constexpr const double kBehaviourNextTick = 0.0;
+// Never resume again, what BEHAVIOUR_END returns
+constexpr const double kBehaviourDone = std::numeric_limits<double>::infinity();
+
+#define BEHAVIOUR_BEGIN(frame) \
+    switch ((frame).ResumePoint) \
+    { \
+    default: \
+        return kBehaviourDone; \
+    case 0:
+
+// point can't be 0 or kBehaviourEnded, and is used once per script
+#define BEHAVIOUR_WAIT(frame, point, wakeTime) \
+    do \
+    { \
+        (frame).ResumePoint = (uint32_t)(point); \
+        return (wakeTime); \
+    case (uint32_t)(point):; \
+    } while (false)
+
+#define BEHAVIOUR_END(frame) \
+    } \
+    (frame).ResumePoint = kBehaviourEnded; \
+    return kBehaviourDone
@@ -0,0 +1,49 @@
+#include "BoxTransform.h"
+
+using namespace DirectX;
+
+
+namespace
+{
+    inline void __vectorcall TransformCenterExtents(FXMVECTOR center, FXMVECTOR extents, CXMMATRIX matrix, BoundingBox& outBox)
+    {
+        XMVECTOR newCenter = XMVectorMultiplyAdd(XMVectorSplatX(center), matrix.r[0], matrix.r[3]);
+        newCenter = XMVectorMultiplyAdd(XMVectorSplatY(center), matrix.r[1], newCenter);
+        newCenter = XMVectorMultiplyAdd(XMVectorSplatZ(center), matrix.r[2], newCenter);
+
+        XMVECTOR newExtents = XMVectorMultiply(XMVectorSplatX(extents), XMVectorAbs(matrix.r[0]));
+        newExtents = XMVectorMultiplyAdd(XMVectorSplatY(extents), XMVectorAbs(matrix.r[1]), newExtents);
+        newExtents = XMVectorMultiplyAdd(XMVectorSplatZ(extents), XMVectorAbs(matrix.r[2]), newExtents);
+
+        XMStoreFloat3(&outBox.Center, newCenter);
+        XMStoreFloat3(&outBox.Extents, newExtents);
+    }
+}
+
+BoundingBox __vectorcall BoxTransform::Transform(const BoundingBox& box, FXMMATRIX matrix)
+{
+    BoundingBox result;
+    TransformCenterExtents(XMLoadFloat3(&box.Center), XMLoadFloat3(&box.Extents), matrix, result);
+    return result;
+}
+
+void BoxTransform::Transform(const BoundingBox* boxes, const XMFLOAT4X4* matrices, BoundingBox* outBoxes, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        XMMATRIX matrix = XMLoadFloat4x4(&matrices[i]);
+        TransformCenterExtents(XMLoadFloat3(&boxes[i].Center), XMLoadFloat3(&boxes[i].Extents), matrix, outBoxes[i]);
+    }
+}
+
+void BoxTransform::Transform(const BoundingBox& box, const XMFLOAT4X4* matrices, BoundingBox* outBoxes, std::size_t count)
+{
+    // The box is the same for every matrix, so it is only loaded once
+    XMVECTOR center = XMLoadFloat3(&box.Center);
+    XMVECTOR extents = XMLoadFloat3(&box.Extents);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        XMMATRIX matrix = XMLoadFloat4x4(&matrices[i]);
+        TransformCenterExtents(center, extents, matrix, outBoxes[i]);
+    }
+}
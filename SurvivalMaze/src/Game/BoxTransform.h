@@ -0,0 +1,22 @@
+#pragma once
+
+
+#include <Oblivion.h>
+
+
+// Affine transforms of axis aligned boxes without going through the corners: the new center is the transformed
+// center and the new extents are the extents transformed by the absolute value of the 3x3 part of the matrix.
+// Gives the same box as BoundingBox::Transform, which transforms all 8 corners, as long as the matrix is affine.
+// Everything is done with DirectXMath vectors, so it uses SSE or AVX / FMA depending on what the build enables
+class BoxTransform
+{
+public:
+    static DirectX::BoundingBox __vectorcall Transform(const DirectX::BoundingBox& box, DirectX::FXMMATRIX matrix);
+
+    // outBoxes[i] = boxes[i] transformed by matrices[i]
+    static void Transform(const DirectX::BoundingBox* boxes, const DirectX::XMFLOAT4X4* matrices, DirectX::BoundingBox* outBoxes,
+        std::size_t count);
+    // outBoxes[i] = box transformed by matrices[i], for many instances of the same model
+    static void Transform(const DirectX::BoundingBox& box, const DirectX::XMFLOAT4X4* matrices, DirectX::BoundingBox* outBoxes,
+        std::size_t count);
+};
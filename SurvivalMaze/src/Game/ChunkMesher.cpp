@@ -0,0 +1,200 @@
+#include "ChunkMesher.h"
+
+#include <algorithm>
+#include <fstream>
+
+
+namespace
+{
+    struct TileBox {
+        float Min[3];
+        float Max[3];
+    };
+
+    TileBox GetTileBox(TileType type, uint32_t row, uint32_t col, uint32_t rows, uint32_t cols, float tileSize,
+        const float boxMin[3], const float boxMax[3])
+    {
+        // Tile instances only scale and translate
+        auto instance = MazeGrid::BuildTileInstance(type, row, col, rows, cols, tileSize);
+        TileBox box;
+        for (uint32_t i = 0; i < 3; ++i) {
+            box.Min[i] = instance.WorldMatrix[3][i] + instance.WorldMatrix[i][i] * boxMin[i];
+            box.Max[i] = instance.WorldMatrix[3][i] + instance.WorldMatrix[i][i] * boxMax[i];
+        }
+        return box;
+    }
+
+    // Corners are given in order around the quad, the winding is fixed so the quad faces along normal
+    void AddQuad(ChunkMesh& mesh, const float (&corners)[4][3], const float (&normal)[3])
+    {
+        float edge0[3], edge1[3];
+        for (uint32_t i = 0; i < 3; ++i) {
+            edge0[i] = corners[1][i] - corners[0][i];
+            edge1[i] = corners[2][i] - corners[0][i];
+        }
+        float cross[3] = {
+            edge0[1] * edge1[2] - edge0[2] * edge1[1],
+            edge0[2] * edge1[0] - edge0[0] * edge1[2],
+            edge0[0] * edge1[1] - edge0[1] * edge1[0],
+        };
+        // Front faces are clockwise, which with left handed coordinates means cross(edge0, edge1) points along the normal
+        bool flip = cross[0] * normal[0] + cross[1] * normal[1] + cross[2] * normal[2] < 0.0f;
+
+        auto firstVertex = (uint32_t)mesh.Vertices.size();
+        for (uint32_t i = 0; i < 4; ++i) {
+            MeshVertex vertex;
+            for (uint32_t j = 0; j < 3; ++j) {
+                vertex.Position[j] = corners[i][j];
+                vertex.Normal[j] = normal[j];
+            }
+            mesh.Vertices.push_back(vertex);
+        }
+        const uint32_t order[] = { 0, 1, 2, 0, 2, 3 };
+        const uint32_t flippedOrder[] = { 0, 2, 1, 0, 3, 2 };
+        for (uint32_t i = 0; i < 6; ++i) {
+            mesh.Indices.push_back(firstVertex + (flip ? flippedOrder[i] : order[i]));
+        }
+    }
+
+    void AddTopQuad(ChunkMesh& mesh, float minX, float maxX, float minZ, float maxZ, float y)
+    {
+        const float corners[4][3] = {
+            { minX, y, minZ }, { minX, y, maxZ }, { maxX, y, maxZ }, { maxX, y, minZ },
+        };
+        AddQuad(mesh, corners, { 0.0f, 1.0f, 0.0f });
+    }
+}
+
+uint32_t ChunkMesh::GetTriangleCount() const
+{
+    return (uint32_t)(Indices.size() / 3);
+}
+
+bool ChunkMesh::Empty() const
+{
+    return Indices.empty();
+}
+
+void ChunkMesher::Build(const TileType* tiles, uint32_t rows, uint32_t cols, const TileRect& area, float tileSize,
+    const float boxMin[3], const float boxMax[3], ChunkMesh (&parts)[kNumParts])
+{
+    for (auto& part : parts) {
+        part.Vertices.clear();
+        part.Indices.clear();
+    }
+    auto isWall = [&](int64_t row, int64_t col) {
+        if (row < 0 || col < 0 || row >= (int64_t)rows || col >= (int64_t)cols) {
+            return false;
+        }
+        return tiles[(std::size_t)row * cols + col] == TileType::Wall;
+    };
+    auto tileBox = [&](TileType type, uint32_t row, uint32_t col) {
+        return GetTileBox(type, row, col, rows, cols, tileSize, boxMin, boxMax);
+    };
+
+    // Merged tops: floors of both kinds and walls
+    std::vector<TileRect> rects;
+    const TileType topTypes[] = { TileType::Wall, TileType::Free, TileType::Enemy };
+    const ChunkMeshPart topParts[] = { ChunkMeshPart::Walls, ChunkMeshPart::Floors, ChunkMeshPart::EnemyFloors };
+    for (uint32_t i = 0; i < 3; ++i) {
+        rects.clear();
+        MazeGrid::MergeTiles(tiles, cols, area, topTypes[i], rects);
+        auto& mesh = parts[(uint32_t)topParts[i]];
+        for (const auto& rect : rects) {
+            auto first = tileBox(topTypes[i], rect.row, rect.col);
+            auto last = tileBox(topTypes[i], rect.row + rect.rows - 1, rect.col + rect.cols - 1);
+            AddTopQuad(mesh, first.Min[0], last.Max[0], first.Min[2], last.Max[2], first.Max[1]);
+        }
+    }
+
+    // Wall sides only go down to the floor, the rest is never seen
+    auto& walls = parts[(uint32_t)ChunkMeshPart::Walls];
+    auto wallBox = tileBox(TileType::Wall, 0, 0);
+    auto floorBox = tileBox(TileType::Free, 0, 0);
+    const float top = wallBox.Max[1];
+    const float bottom = std::max(wallBox.Min[1], floorBox.Max[1]);
+
+    // Sides facing -z and +z, merged along rows
+    for (int32_t side = -1; side <= 1; side += 2) {
+        const float normal[3] = { 0.0f, 0.0f, (float)side };
+        for (uint32_t i = area.row; i < area.row + area.rows; ++i) {
+            for (uint32_t j = area.col; j < area.col + area.cols;) {
+                if (!isWall(i, j) || isWall((int64_t)i + side, j)) {
+                    ++j;
+                    continue;
+                }
+                uint32_t runEnd = j + 1;
+                while (runEnd < area.col + area.cols && isWall(i, runEnd) && !isWall((int64_t)i + side, runEnd)) {
+                    runEnd++;
+                }
+                auto first = tileBox(TileType::Wall, i, j);
+                auto last = tileBox(TileType::Wall, i, runEnd - 1);
+                float z = side < 0 ? first.Min[2] : first.Max[2];
+                const float corners[4][3] = {
+                    { first.Min[0], bottom, z }, { first.Min[0], top, z }, { last.Max[0], top, z }, { last.Max[0], bottom, z },
+                };
+                AddQuad(walls, corners, normal);
+                j = runEnd;
+            }
+        }
+    }
+
+    // Sides facing -x and +x, merged along columns
+    for (int32_t side = -1; side <= 1; side += 2) {
+        const float normal[3] = { (float)side, 0.0f, 0.0f };
+        for (uint32_t j = area.col; j < area.col + area.cols; ++j) {
+            for (uint32_t i = area.row; i < area.row + area.rows;) {
+                if (!isWall(i, j) || isWall(i, (int64_t)j + side)) {
+                    ++i;
+                    continue;
+                }
+                uint32_t runEnd = i + 1;
+                while (runEnd < area.row + area.rows && isWall(runEnd, j) && !isWall(runEnd, (int64_t)j + side)) {
+                    runEnd++;
+                }
+                auto first = tileBox(TileType::Wall, i, j);
+                auto last = tileBox(TileType::Wall, runEnd - 1, j);
+                float x = side < 0 ? first.Min[0] : first.Max[0];
+                const float corners[4][3] = {
+                    { x, bottom, first.Min[2] }, { x, top, first.Min[2] }, { x, top, last.Max[2] }, { x, bottom, last.Max[2] },
+                };
+                AddQuad(walls, corners, normal);
+                i = runEnd;
+            }
+        }
+    }
+}
+
+bool ChunkMesher::WriteObj(const std::string& path, const ChunkMesh& mesh)
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    // Written like any other OBJ export: right handed with counter clockwise front faces, so the importer's
+    // left handed conversion (which mirrors z and flips the winding) brings back the mesh as it was built
+    for (const auto& vertex : mesh.Vertices) {
+        file << "v " << vertex.Position[0] << " " << vertex.Position[1] << " " << -vertex.Position[2] << "\n";
+    }
+    for (const auto& vertex : mesh.Vertices) {
+        file << "vn " << vertex.Normal[0] << " " << vertex.Normal[1] << " " << -vertex.Normal[2] << "\n";
+    }
+    // OBJ indices start at 1
+    for (std::size_t i = 0; i + 2 < mesh.Indices.size(); i += 3) {
+        auto a = mesh.Indices[i] + 1, b = mesh.Indices[i + 2] + 1, c = mesh.Indices[i + 1] + 1;
+        file << "f " << a << "//" << a << " " << b << "//" << b << " " << c << "//" << c << "\n";
+    }
+    return (bool)file;
+}
+
+std::string ChunkMesher::GetMeshDirectory(const std::string& levelPath)
+{
+    return levelPath + ".meshes";
+}
+
+std::string ChunkMesher::GetMeshPath(const std::string& levelPath, uint32_t chunkX, uint32_t chunkY, ChunkMeshPart part)
+{
+    constexpr const char* partNames[] = { "walls", "floors", "enemies" };
+    return GetMeshDirectory(levelPath) + "/" + std::to_string(chunkX) + "_" + std::to_string(chunkY) + "_" +
+        partNames[(uint32_t)part] + ".obj";
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+
+#include <string>
+
+#include "MazeGrid.h"
+
+
+struct MeshVertex {
+    float Position[3];
+    float Normal[3];
+};
+
+struct ChunkMesh {
+    std::vector<MeshVertex> Vertices;
+    std::vector<uint32_t> Indices;
+
+    uint32_t GetTriangleCount() const;
+    bool Empty() const;
+};
+
+// Every part gets its own mesh, so it can be drawn with the color of its tile type
+enum class ChunkMeshPart : uint8_t {
+    Walls = 0,
+    Floors,
+    EnemyFloors,
+    Count,
+};
+
+// Builds the static geometry of a chunk of the maze, with tiles placed the same way as MazeGrid::BuildTileInstance places
+// instances of a model whose local bounding box is [boxMin, boxMax].
+// Faces between two walls and everything under the floor are dropped. Floors and wall tops are merged into
+// as few quads as MazeGrid::MergeTiles can, and wall sides are merged along runs of walls facing the same way
+class ChunkMesher
+{
+public:
+    static constexpr const uint32_t kNumParts = (uint32_t)ChunkMeshPart::Count;
+    static constexpr const uint32_t kTrianglesPerTile = 12; // What instancing a cube costs
+
+public:
+    static void Build(const TileType* tiles, uint32_t rows, uint32_t cols, const TileRect& area, float tileSize,
+        const float boxMin[3], const float boxMax[3], ChunkMesh (&parts)[kNumParts]);
+
+    static bool WriteObj(const std::string& path, const ChunkMesh& mesh);
+
+    // Chunk meshes of a baked level live in <levelPath>.meshes/
+    static std::string GetMeshDirectory(const std::string& levelPath);
+    static std::string GetMeshPath(const std::string& levelPath, uint32_t chunkX, uint32_t chunkY, ChunkMeshPart part);
+};
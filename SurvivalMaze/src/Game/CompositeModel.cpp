@@ -1,4 +1,5 @@
 #include "CompositeModel.h"
+#include "BoxTransform.h"
 
 
 bool CompositeModel::Create(Model* usedModel, const DirectX::XMFLOAT4& color, const DirectX::XMMATRIX& fromParent, const DirectX::XMMATRIX& transform)
@@ -19,7 +20,7 @@ bool CompositeModel::Create(Model* usedModel, const DirectX::XMFLOAT4& color, co
 
 CompositeModel* __vectorcall CompositeModel::AddChild(const DirectX::XMFLOAT4& color, const DirectX::XMMATRIX& fromParent, const DirectX::XMMATRIX& transform)
 {
-    mChildren.emplace_back(std::make_unique<CompositeModel>());
+    mChildren.emplace_back(MakeTracked<CompositeModel>(MemoryTag::CompositeModels));
     auto& child = mChildren.back();
     if (!child->Create(mUsedModel, color, fromParent, transform))
     {
@@ -53,7 +54,7 @@ void CompositeModel::UpdateBoundingBox(const DirectX::XMMATRIX& compositeTransfo
 {
     const auto& boundingBox = mUsedModel->GetBoundingBox();
     auto currentTransform = mFromParentTransformation * compositeTransform;
-    boundingBox.Transform(mBoundingBox, currentTransform);
+    mBoundingBox = BoxTransform::Transform(boundingBox, currentTransform);
     for (auto& child : mChildren)
     {
         child->UpdateBoundingBox(currentTransform);
@@ -74,9 +75,7 @@ DirectX::BoundingBox& CompositeModel::GetBoundingBox()
 
 DirectX::BoundingBox CompositeModel::GetTransformedBoundingBox() const
 {
-    DirectX::BoundingBox worldBoundingBox;
-    mBoundingBox.Transform(worldBoundingBox, mTransform);
-    return worldBoundingBox;
+    return BoxTransform::Transform(mBoundingBox, mTransform);
 }
 
 void CompositeModel::Identity()
@@ -153,3 +152,52 @@ void CompositeModel::ScaleFromParent(float scaleFactorX, float scaleFactorY, flo
 {
     mFromParentTransformation *= DirectX::XMMatrixScaling(scaleFactorX, scaleFactorY, scaleFactorZ);
 }
+
+void CompositeModel::SaveState(WorldSnapshot& snapshot) const
+{
+    auto* states = snapshot.Allocate<State>(GetNodeCount());
+    SaveNodes(states);
+}
+
+bool CompositeModel::LoadState(WorldSnapshot::Reader& reader)
+{
+    std::size_t count;
+    const auto* states = reader.Read<State>(count);
+    CHECK(states && count == GetNodeCount(), false, "Snapshot has {} composite model nodes instead of {}", count, GetNodeCount());
+    LoadNodes(states);
+    return true;
+}
+
+uint32_t CompositeModel::GetNodeCount() const
+{
+    uint32_t count = 1;
+    for (const auto& child : mChildren)
+    {
+        count += child->GetNodeCount();
+    }
+    return count;
+}
+
+void CompositeModel::SaveNodes(State*& states) const
+{
+    DirectX::XMStoreFloat4x4(&states->FromParentTransformation, mFromParentTransformation);
+    DirectX::XMStoreFloat4x4(&states->Transform, mTransform);
+    states->BoundingBox = mBoundingBox;
+    states++;
+    for (const auto& child : mChildren)
+    {
+        child->SaveNodes(states);
+    }
+}
+
+void CompositeModel::LoadNodes(const State*& states)
+{
+    mFromParentTransformation = DirectX::XMLoadFloat4x4(&states->FromParentTransformation);
+    mTransform = DirectX::XMLoadFloat4x4(&states->Transform);
+    mBoundingBox = states->BoundingBox;
+    states++;
+    for (auto& child : mChildren)
+    {
+        child->LoadNodes(states);
+    }
+}
@@ -3,10 +3,20 @@
 
 #include <Oblivion.h>
 #include <Model.h>
+#include "WorldSnapshot.h"
+#include "MemoryTracker.h"
 
 
 class CompositeModel
 {
+public:
+    struct State
+    {
+        DirectX::XMFLOAT4X4 FromParentTransformation;
+        DirectX::XMFLOAT4X4 Transform;
+        DirectX::BoundingBox BoundingBox;
+    };
+
 public:
     CompositeModel() = default;
 
@@ -39,6 +49,10 @@ public:
 
     float GetHalfHeight() const;
 
+    // The whole tree, depth first. Children are not added or removed after creation, so only their transforms are saved
+    void SaveState(WorldSnapshot& snapshot) const;
+    bool LoadState(WorldSnapshot::Reader& reader);
+
 public:
     void IdentityFromParent();
     void TranslateFromParent(float x = 0.0f, float y = 0.0f, float z = 0.0f);
@@ -49,7 +63,12 @@ public:
     void ScaleFromParent(float scaleFactorX, float scaleFactorY, float scaleFactorZ);
 
 private:
-    std::vector<std::unique_ptr<CompositeModel>> mChildren;
+    uint32_t GetNodeCount() const;
+    void SaveNodes(State*& states) const;
+    void LoadNodes(const State*& states);
+
+private:
+    std::pmr::vector<TrackedPtr<CompositeModel>> mChildren{ MemoryTracker::Get().GetResource(MemoryTag::CompositeModels) };
     Model* mUsedModel;
     uint32_t mInstanceID;
 
@@ -0,0 +1,166 @@
+#include "EllerMazeGenerator.h"
+
+#include <algorithm>
+
+
+void EllerMazeGenerator::Create(uint32_t cols, uint32_t seed, float enemyProbability)
+{
+    mCols = cols;
+    mNumCells = (cols - 1) / 2;
+    mEnemyProbability = enemyProbability;
+    mGeneratedRows = 0;
+    mGenerator.seed(seed);
+
+    mSets.assign(mNumCells, kNoSet);
+    mGoesDown.assign(mNumCells, 0);
+    mRemap.assign(mNumCells, kNoSet);
+    mSetMembers.assign(mNumCells, 0);
+    mSetCandidates.assign(mNumCells, 0);
+}
+
+void EllerMazeGenerator::NextRow(TileType* row)
+{
+    if (mGeneratedRows == 0) {
+        std::fill(row, row + mCols, TileType::Wall);
+    } else if (mGeneratedRows % 2 == 1) {
+        NextCellRow(row);
+    } else {
+        NextConnectionRow(row);
+    }
+    mGeneratedRows++;
+}
+
+uint64_t EllerMazeGenerator::GetGeneratedRows() const
+{
+    return mGeneratedRows;
+}
+
+bool EllerMazeGenerator::IsCheckpointRow(uint64_t row)
+{
+    return row % 2 == 1 && ((row - 1) / 2) % kCheckpointInterval == 0;
+}
+
+uint64_t EllerMazeGenerator::GetLastCheckpointRow(uint64_t row)
+{
+    if (row == 0) {
+        return 0;
+    }
+    constexpr uint64_t checkpointRows = 2 * kCheckpointInterval;
+    return ((row - 1) / checkpointRows) * checkpointRows + 1;
+}
+
+void EllerMazeGenerator::NextCellRow(TileType* row)
+{
+    // Compact the set ids to [0, mNumCells) and give a new set to every cell that isn't in one
+    std::fill(mRemap.begin(), mRemap.end(), kNoSet);
+    uint32_t nextSet = 0;
+    for (auto& set : mSets) {
+        if (set != kNoSet) {
+            if (mRemap[set] == kNoSet) {
+                mRemap[set] = nextSet++;
+            }
+            set = mRemap[set];
+        }
+    }
+    for (auto& set : mSets) {
+        if (set == kNoSet) {
+            set = nextSet++;
+        }
+    }
+
+    std::fill(row, row + mCols, TileType::Wall);
+    for (uint32_t i = 0; i < mNumCells; ++i) {
+        row[2 * i + 1] = RollFreeTile();
+    }
+
+    if (IsCheckpointRow(mGeneratedRows)) {
+        for (uint32_t i = 0; i + 1 < mNumCells; ++i) {
+            row[2 * i + 2] = RollFreeTile();
+        }
+        std::fill(mSets.begin(), mSets.end(), 0);
+    } else {
+        std::bernoulli_distribution joinDistribution(0.5);
+        for (uint32_t i = 0; i + 1 < mNumCells; ++i) {
+            if (mSets[i] == mSets[i + 1] || !joinDistribution(mGenerator)) {
+                continue;
+            }
+            row[2 * i + 2] = RollFreeTile();
+            auto mergedSet = mSets[i + 1];
+            for (auto& set : mSets) {
+                if (set == mergedSet) {
+                    set = mSets[i];
+                }
+            }
+        }
+    }
+
+    // Every set has to continue in the next row. Pick the cells going down randomly,
+    // then make sure each set has at least one by choosing a random member (reservoir sampling)
+    std::bernoulli_distribution downDistribution(0.5);
+    std::fill(mSetMembers.begin(), mSetMembers.end(), 0);
+    for (uint32_t i = 0; i < mNumCells; ++i) {
+        mGoesDown[i] = downDistribution(mGenerator) ? 1 : 0;
+        if (mGoesDown[i]) {
+            mSetMembers[mSets[i]] = kNoSet;
+        }
+    }
+    for (uint32_t i = 0; i < mNumCells; ++i) {
+        auto& numMembers = mSetMembers[mSets[i]];
+        if (numMembers == kNoSet) {
+            continue;
+        }
+        numMembers++;
+        std::uniform_int_distribution<uint32_t> memberDistribution(0, numMembers - 1);
+        if (memberDistribution(mGenerator) == 0) {
+            mSetCandidates[mSets[i]] = i;
+        }
+    }
+    for (uint32_t i = 0; i < mNumCells; ++i) {
+        auto set = mSets[i];
+        if (mSetMembers[set] != kNoSet && mSetMembers[set] > 0) {
+            mGoesDown[mSetCandidates[set]] = 1;
+            mSetMembers[set] = kNoSet;
+        }
+    }
+}
+
+void EllerMazeGenerator::NextConnectionRow(TileType* row)
+{
+    std::fill(row, row + mCols, TileType::Wall);
+    for (uint32_t i = 0; i < mNumCells; ++i) {
+        if (mGoesDown[i]) {
+            row[2 * i + 1] = RollFreeTile();
+        } else {
+            mSets[i] = kNoSet;
+        }
+    }
+}
+
+TileType EllerMazeGenerator::RollFreeTile()
+{
+    std::uniform_real_distribution<float> chanceDistribution(0.0f, 1.0f);
+    return chanceDistribution(mGenerator) <= mEnemyProbability ? TileType::Enemy : TileType::Free;
+}
+
+void EllerMazeGenerator::SaveState(WorldSnapshot& snapshot) const
+{
+    snapshot.Write(mGeneratedRows);
+    snapshot.Write(mGenerator);
+    snapshot.Write(mSets.data(), mSets.size());
+    snapshot.Write(mGoesDown.data(), mGoesDown.size());
+}
+
+bool EllerMazeGenerator::LoadState(WorldSnapshot::Reader& reader)
+{
+    std::size_t numSets, numGoesDown;
+    reader.Read(mGeneratedRows);
+    reader.Read(mGenerator);
+    const auto* sets = reader.Read<uint32_t>(numSets);
+    const auto* goesDown = reader.Read<uint8_t>(numGoesDown);
+    if (reader.Failed() || numSets != mNumCells || numGoesDown != mNumCells) {
+        return false;
+    }
+    std::copy(sets, sets + numSets, mSets.begin());
+    std::copy(goesDown, goesDown + numGoesDown, mGoesDown.begin());
+    return true;
+}
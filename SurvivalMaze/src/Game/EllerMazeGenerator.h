@@ -0,0 +1,60 @@
+#pragma once
+
+
+#include "MazeGrid.h"
+#include "WorldSnapshot.h"
+
+
+// Generates an endless maze one tile row at a time (Eller's algorithm) using O(cols) memory.
+// Row 0 is a border wall, after that cell rows (odd) alternate with the rows that connect them (even).
+// Every kCheckpointInterval cell rows the whole cell row is opened into a corridor. Everything
+// generated after a checkpoint is reachable without going back past it, so rows behind the
+// latest checkpoint the player crossed can be discarded without trapping the player.
+class EllerMazeGenerator
+{
+public:
+    static constexpr const uint32_t kCheckpointInterval = 8;
+
+public:
+    EllerMazeGenerator() = default;
+
+public:
+    void Create(uint32_t cols, uint32_t seed, float enemyProbability = 0.1f);
+
+    // Writes the next cols tiles
+    void NextRow(TileType* row);
+
+    uint64_t GetGeneratedRows() const;
+
+    // Everything that decides the rows to come. Loading only works on a generator created with the same cols
+    void SaveState(WorldSnapshot& snapshot) const;
+    bool LoadState(WorldSnapshot::Reader& reader);
+
+    static bool IsCheckpointRow(uint64_t row);
+    // Latest checkpoint row <= row, 0 when there isn't any
+    static uint64_t GetLastCheckpointRow(uint64_t row);
+
+private:
+    void NextCellRow(TileType* row);
+    void NextConnectionRow(TileType* row);
+
+    TileType RollFreeTile();
+
+private:
+    static constexpr const uint32_t kNoSet = ~0u;
+
+    uint32_t mCols = 0;
+    uint32_t mNumCells = 0;
+    float mEnemyProbability = 0.1f;
+    uint64_t mGeneratedRows = 0;
+
+    std::mt19937 mGenerator;
+
+    std::vector<uint32_t> mSets;
+    std::vector<uint8_t> mGoesDown;
+
+    // Scratch memory, kept around so generating rows doesn't allocate
+    std::vector<uint32_t> mRemap;
+    std::vector<uint32_t> mSetMembers;
+    std::vector<uint32_t> mSetCandidates;
+};
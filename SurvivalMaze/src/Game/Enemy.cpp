@@ -1,13 +1,9 @@
 #include "Enemy.h"
+#include "BoxTransform.h"
+#include "GameRules.h"
 
 using namespace DirectX;
 
-const XMVECTOR Enemy::directions[] = {
-    XMVectorSet(1.0f, 0.0f, 0.0f, 1.0f),
-    XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f),
-    XMVectorSet(1.0f, 0.0f, 1.0f, 1.0f),
-};
-
 bool Enemy::Create(Model* enemyModel, XMFLOAT3 position, float range)
 {
     CHECK(enemyModel, false, "Unable to create an enemy with an empty model");
@@ -21,10 +17,8 @@ bool Enemy::Create(Model* enemyModel, XMFLOAT3 position, float range)
     InstanceInfo instanceInfo;
     instanceInfo.Color = { 0.0f, 1.0f, 0.0f,1.0f };
     instanceInfo.WorldMatrix = XMMatrixTranslation(position.x, position.y, position.z);
-    
-    mInitialPosition = XMLoadFloat3(&position);
-    
-    mAnimationTime = 1.0f; // Count on Update to update everything
+
+    mBehaviour.Spawn(&position.x);
 
     auto instanceResult = enemyModel->AddInstance(instanceInfo);
     CHECK(instanceResult.Valid(), false, "Cannot add new instance to enemy model");
@@ -34,57 +28,133 @@ bool Enemy::Create(Model* enemyModel, XMFLOAT3 position, float range)
     return true;
 }
 
-void Enemy::Update(float dt)
+void Enemy::Respawn(XMFLOAT3 position)
 {
-    if (mDying)
-    {
-        mAnimationTime += dt * 2.0f;
+    position.y += mModel->GetBoundingBox().Extents.y;
+    mBehaviour.Spawn(&position.x);
 
-        InstanceInfo& instanceInfo = mModel->GetInstanceInfo(mInstanceID);
-        instanceInfo.AnimationTime = mAnimationTime;
+    mModel->GetInstanceInfo(mInstanceID).AnimationTime = 0.0f;
+    UpdateInstanceMotion();
+}
+
+void Enemy::Resume(double time)
+{
+    mBehaviour.Resume(time, Random::get_engine());
+    if (mBehaviour.IsDying())
+    {
+        mModel->GetInstanceInfo(mInstanceID).AnimationTime = mBehaviour.GetAnimationTime();
     }
     else
     {
-        if (mAnimationTime >= 1.0f)
-        {
-            uint32_t nextDirectionIndex = Random::get(0u, (uint32_t)ARRAYSIZE(directions) - 1);
-            mDirection = directions[nextDirectionIndex];
-            mAnimationTime = 0.0f;
-        }
-        mAnimationTime += dt * Random::get(0.0001f, 1.0f / 3.0f); // speed between 0.0001f and 1/3
-
-        InstanceInfo& instanceInfo = mModel->GetInstanceInfo(mInstanceID);
-
-        XMVECTOR position = mInitialPosition + mDirection * sin(mAnimationTime * XM_2PI);
-        instanceInfo.WorldMatrix = XMMatrixTranslation(XMVectorGetX(position), XMVectorGetY(position), XMVectorGetZ(position));
+        // Patrolling enemies are only resumed to start a new patrol
+        UpdateInstanceMotion();
     }
 }
 
-void Enemy::Render()
+double Enemy::GetWakeTime() const
+{
+    return mBehaviour.GetWakeTime();
+}
+
+void Enemy::UpdateInstanceMotion()
+{
+    InstanceInfo& instanceInfo = mModel->GetInstanceInfo(mInstanceID);
+    const float* position = mBehaviour.GetPatrolPosition();
+    instanceInfo.WorldMatrix = XMMatrixTranslation(position[0], position[1], position[2]);
+#if RENDERER_INSTANCE_MOTION
+    const float* direction = mBehaviour.GetPatrolDirection();
+    instanceInfo.MotionDirection = { direction[0], direction[1], direction[2] };
+    instanceInfo.MotionStartTime = mBehaviour.GetPatrolStart();
+    instanceInfo.MotionSpeed = mBehaviour.GetPatrolSpeed();
+#endif
+}
+
+void Enemy::SetUpdateTime(double time)
+{
+    mBehaviour.SetUpdateTime(time);
+}
+
+void Enemy::Render([[maybe_unused]] const XMFLOAT4X4& worldMatrix)
 {
+#if !RENDERER_INSTANCE_MOTION
+    // Drawn where its world matrix is, so a walking enemy is moved here every frame it's seen
+    mModel->GetInstanceInfo(mInstanceID).WorldMatrix = XMLoadFloat4x4(&worldMatrix);
+#endif
     mModel->AddCurrentInstance(mInstanceID);
 }
 
-void Enemy::Die()
+void Enemy::Die(float time)
 {
-    mDying = true;
-    mAnimationTime = 0.0f;
+    mBehaviour.Die(time);
+    UpdateInstanceMotion();
 }
 
-bool Enemy::CollisionWithBoundingBox(const DirectX::BoundingBox& bb) const
+bool Enemy::CollisionWithBoundingBox(const DirectX::BoundingBox& bb, float time) const
 {
-    if (mDying)
+    if (mBehaviour.IsDying())
         return false;
 
-    InstanceInfo& instanceInfo = mModel->GetInstanceInfo(mInstanceID);
-    const auto& boundingBox = mModel->GetBoundingBox();
-    BoundingBox currentBoundingBox;
-    boundingBox.Transform(currentBoundingBox, instanceInfo.WorldMatrix);
+    auto box = GetBoundingBox(time);
+    return GameRules::Touches({ box.Center.x, box.Center.z, box.Extents.x, box.Extents.z },
+        { bb.Center.x, bb.Center.z, bb.Extents.x, bb.Extents.z });
+}
 
-    return currentBoundingBox.Intersects(bb);
+BoundingBox Enemy::GetBoundingBox(float time) const
+{
+    XMFLOAT4X4 worldMatrix;
+    GetWorldMatrix(worldMatrix, time);
+    return BoxTransform::Transform(mModel->GetBoundingBox(), XMLoadFloat4x4(&worldMatrix));
+}
+
+void Enemy::GetWorldMatrix(XMFLOAT4X4& worldMatrix, float time) const
+{
+    // The same motion the vertex shader evaluates, so collisions happen where the enemy is drawn
+    float position[3];
+    mBehaviour.GetPosition(time, position);
+    XMStoreFloat4x4(&worldMatrix, XMMatrixTranslation(position[0], position[1], position[2]));
+}
+
+XMFLOAT3 Enemy::GetInitialPosition() const
+{
+    const float* position = mBehaviour.GetInitialPosition();
+    return { position[0], position[1], position[2] };
+}
+
+uint32_t Enemy::GetInstanceID() const
+{
+    return mInstanceID;
 }
 
 bool Enemy::ShouldDie() const
 {
-    return mDying && mAnimationTime >= 1.0f;
+    return mBehaviour.ShouldDie();
+}
+
+bool Enemy::IsDying() const
+{
+    return mBehaviour.IsDying();
+}
+
+void Enemy::SaveState(State& state) const
+{
+    mBehaviour.SaveState(state.Behaviour);
+    state.Range = mRange;
+    state.InstanceAnimationTime = mModel->GetInstanceInfo(mInstanceID).AnimationTime;
+    state.InstanceID = mInstanceID;
+}
+
+bool Enemy::IsValidState(const State& state)
+{
+    return EnemyBehaviour::IsValidState(state.Behaviour);
+}
+
+void Enemy::LoadState(const State& state, Model* enemyModel)
+{
+    mModel = enemyModel;
+    mBehaviour.LoadState(state.Behaviour);
+    mRange = state.Range;
+    mInstanceID = state.InstanceID;
+
+    mModel->GetInstanceInfo(mInstanceID).AnimationTime = state.InstanceAnimationTime;
+    UpdateInstanceMotion();
 }
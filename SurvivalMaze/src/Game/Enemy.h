@@ -3,36 +3,67 @@
 
 
 #include "Model.h"
+#include "EnemyBehaviour.h"
 
 
 class Enemy
 {
-    static const DirectX::XMVECTOR directions[];
+public:
+    // Everything Update changes, including what it writes to the model instance
+    struct State
+    {
+        EnemyBehaviour::State Behaviour;
+        float Range;
+        float InstanceAnimationTime;
+        uint32_t InstanceID;
+    };
+
 public:
     Enemy() = default;
 
     bool Create(Model* enemyModel, DirectX::XMFLOAT3 position, float range);
+    // Brings a dead or pooled enemy back at a new position, reusing its instance
+    void Respawn(DirectX::XMFLOAT3 position);
 
-    void Update(float dt);
-    void Render();
-    void Die();
+    // Runs the enemy's behaviour until it waits again, see EnemyBehaviour::Resume and GetWakeTime
+    void Resume(double time);
+    // When the behaviour wants to be resumed next, kBehaviourNextTick for every tick. Nothing changes before then
+    double GetWakeTime() const;
+    // Without advancing it, for enemies that were just brought to life
+    void SetUpdateTime(double time);
+    // worldMatrix is from GetWorldMatrix at the time of the last update
+    void Render(const DirectX::XMFLOAT4X4& worldMatrix);
+    // Stops it where it is at time and switches it to the dying behaviour, which wants to be resumed at once
+    void Die(float time);
 
     bool ShouldDie() const;
+    bool IsDying() const;
+
+    // Where the enemy is drawn at time, which should be the time of the last update. See GameRules::Touches
+    bool CollisionWithBoundingBox(const DirectX::BoundingBox& bb, float time) const;
+    DirectX::BoundingBox GetBoundingBox(float time) const;
+    // For transforming the boxes of many enemies at once, see BoxTransform
+    void GetWorldMatrix(DirectX::XMFLOAT4X4& worldMatrix, float time) const;
 
-    bool CollisionWithBoundingBox(const DirectX::BoundingBox& bb) const;
+    DirectX::XMFLOAT3 GetInitialPosition() const;
+    // Stays the same for the enemy's whole life, pooled enemies keep theirs
+    uint32_t GetInstanceID() const;
+
+    void SaveState(State& state) const;
+    // Whether LoadState can resume the behaviour of the state
+    static bool IsValidState(const State& state);
+    // The instance is taken from the state, so every enemy must be loaded from a state of the same world
+    void LoadState(const State& state, Model* enemyModel);
+
+private:
+    // Writes the patrol to the instance, where the renderer moves it if it supports RENDERER_INSTANCE_MOTION
+    void UpdateInstanceMotion();
 
 private:
     Model* mModel;
     float mRange;
 
-    float mAnimationTime;
-
-    bool mDying = false;
-
-    DirectX::XMVECTOR mInitialPosition;
-    DirectX::XMVECTOR mPosition;
-    DirectX::XMVECTOR mDirection;
+    EnemyBehaviour mBehaviour;
 
     uint32_t mInstanceID;
 };
-
@@ -0,0 +1,177 @@
+#include "EnemyBehaviour.h"
+#include "GameRules.h"
+
+#include <algorithm>
+#include <iterator>
+
+
+void EnemyBehaviour::Spawn(const float position[3])
+{
+    std::copy(position, position + 3, mInitialPosition);
+    std::copy(position, position + 3, mPosition);
+    std::fill(std::begin(mDirection), std::end(mDirection), 0.0f);
+    mSpeed = 0.0f;
+    mPatrolStart = 0.0f;
+    mAnimationTime = 0.0f;
+    mDying = false;
+    mBehaviour = {};
+    mWakeTime = kBehaviourNextTick;
+}
+
+void EnemyBehaviour::Resume(double time, std::mt19937& random)
+{
+    float dt = time > mUpdateTime ? (float)(time - mUpdateTime) : 0.0f;
+    mUpdateTime = time;
+    mWakeTime = mDying ? Dying(dt) : Patrol(time, random);
+}
+
+double EnemyBehaviour::GetWakeTime() const
+{
+    return mWakeTime;
+}
+
+double EnemyBehaviour::Patrol(double time, std::mt19937& random)
+{
+    BEHAVIOUR_BEGIN(mBehaviour);
+    for (;;)
+    {
+        // Each patrol ends back at the initial position, where the next one starts
+        StartPatrol((float)time, random);
+        BEHAVIOUR_WAIT(mBehaviour, BehaviourPoint::PatrolEnd, mPatrolStart + 1.0 / mSpeed);
+    }
+    BEHAVIOUR_END(mBehaviour);
+}
+
+double EnemyBehaviour::Dying(float dt)
+{
+    BEHAVIOUR_BEGIN(mBehaviour);
+    for (;;)
+    {
+        mAnimationTime += dt * 2.0f;
+        if (mAnimationTime >= 1.0f)
+        {
+            break;
+        }
+        BEHAVIOUR_WAIT(mBehaviour, BehaviourPoint::DyingTick, kBehaviourNextTick);
+    }
+    BEHAVIOUR_END(mBehaviour);
+}
+
+void EnemyBehaviour::StartPatrol(float time, std::mt19937& random)
+{
+    // The distributions Random::get uses, so the game draws the same patrols from the same engine state
+    std::uniform_int_distribution<uint32_t> directionDistribution(0, (uint32_t)std::size(GameRules::kPatrolDirections) - 1);
+    const auto* direction = GameRules::kPatrolDirections[directionDistribution(random)];
+    std::copy(direction, direction + 3, mDirection);
+    mSpeed = std::uniform_real_distribution<float>(GameRules::kMinPatrolSpeed, GameRules::kMaxPatrolSpeed)(random);
+    mPatrolStart = time;
+}
+
+void EnemyBehaviour::SetUpdateTime(double time)
+{
+    mUpdateTime = time;
+}
+
+void EnemyBehaviour::Die(float time)
+{
+    GetPosition(time, mPosition);
+    mSpeed = 0.0f;
+
+    mDying = true;
+    mAnimationTime = 0.0f;
+    mBehaviour = {};
+    mWakeTime = kBehaviourNextTick;
+}
+
+bool EnemyBehaviour::ShouldDie() const
+{
+    return mDying && mAnimationTime >= 1.0f;
+}
+
+bool EnemyBehaviour::IsDying() const
+{
+    return mDying;
+}
+
+float EnemyBehaviour::GetAnimationTime() const
+{
+    return mAnimationTime;
+}
+
+void EnemyBehaviour::GetPosition(float time, float position[3]) const
+{
+    float offset = GameRules::GetPatrolOffset(mPatrolStart, mSpeed, time);
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        position[i] = mPosition[i] + mDirection[i] * offset;
+    }
+}
+
+const float* EnemyBehaviour::GetInitialPosition() const
+{
+    return mInitialPosition;
+}
+
+const float* EnemyBehaviour::GetPatrolPosition() const
+{
+    return mPosition;
+}
+
+const float* EnemyBehaviour::GetPatrolDirection() const
+{
+    return mDirection;
+}
+
+float EnemyBehaviour::GetPatrolStart() const
+{
+    return mPatrolStart;
+}
+
+float EnemyBehaviour::GetPatrolSpeed() const
+{
+    return mSpeed;
+}
+
+void EnemyBehaviour::SaveState(State& state) const
+{
+    std::copy(std::begin(mInitialPosition), std::end(mInitialPosition), state.InitialPosition);
+    state.AnimationTime = mAnimationTime;
+    std::copy(std::begin(mPosition), std::end(mPosition), state.Position);
+    state.Speed = mSpeed;
+    std::copy(std::begin(mDirection), std::end(mDirection), state.Direction);
+    state.PatrolStart = mPatrolStart;
+    state.Dying = mDying ? 1 : 0;
+    state.ResumePoint = mBehaviour.ResumePoint;
+    state.UpdateTime = mUpdateTime;
+    state.WakeTime = mWakeTime;
+}
+
+bool EnemyBehaviour::IsValidState(const State& state)
+{
+    switch ((BehaviourPoint)state.ResumePoint)
+    {
+    case BehaviourPoint::Start:
+    case BehaviourPoint::Ended:
+        return true;
+    case BehaviourPoint::PatrolEnd:
+        return state.Dying == 0;
+    case BehaviourPoint::DyingTick:
+        return state.Dying != 0;
+    default:
+        return false;
+    }
+}
+
+void EnemyBehaviour::LoadState(const State& state)
+{
+    std::copy(std::begin(state.InitialPosition), std::end(state.InitialPosition), mInitialPosition);
+    mAnimationTime = state.AnimationTime;
+    std::copy(std::begin(state.Position), std::end(state.Position), mPosition);
+    mSpeed = state.Speed;
+    std::copy(std::begin(state.Direction), std::end(state.Direction), mDirection);
+    mPatrolStart = state.PatrolStart;
+    mDying = state.Dying != 0;
+    mBehaviour.ResumePoint = state.ResumePoint;
+    mUpdateTime = state.UpdateTime;
+    mWakeTime = state.WakeTime;
+}
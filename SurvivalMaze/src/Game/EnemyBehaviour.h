@@ -0,0 +1,95 @@
+#pragma once
+
+
+#include <cstdint>
+#include <random>
+
+#include "Behaviour.h"
+
+
+// The renderer independent part of an enemy: it patrols around its tile (see GameRules::GetPatrolOffset) until it is
+// hit, then dies. Enemy draws it and SimWorld runs it headless, so both follow the same rules
+class EnemyBehaviour
+{
+public:
+    // Everything Resume changes
+    struct State
+    {
+        float InitialPosition[3];
+        float AnimationTime;
+        float Position[3]; // What the patrol is relative to
+        float Speed;
+        float Direction[3];
+        float PatrolStart;
+        uint32_t Dying;
+        uint32_t ResumePoint; // Of the behaviour, a BehaviourPoint
+        double UpdateTime;
+        double WakeTime;
+    };
+
+public:
+    EnemyBehaviour() = default;
+
+    // Starts over at position, which is where it patrols around
+    void Spawn(const float position[3]);
+
+    // Runs the behaviour (patrolling, then dying once hit) until it waits again, see GetWakeTime. Whatever time passed
+    // since it was last resumed is caught up in one step. The patrol is a function of time, so a walking enemy only
+    // wakes up to start a new patrol. New patrols are picked with random
+    void Resume(double time, std::mt19937& random);
+    // When the behaviour wants to be resumed next, kBehaviourNextTick for every tick. Nothing changes before then
+    double GetWakeTime() const;
+    // Without advancing it, for enemies that were just brought to life
+    void SetUpdateTime(double time);
+    // Stops it where it is at time and switches it to the dying behaviour, which wants to be resumed at once
+    void Die(float time);
+
+    bool ShouldDie() const;
+    bool IsDying() const;
+    // Of dying, from 0 to 1
+    float GetAnimationTime() const;
+
+    // Where it is at time, which should be the time of the last update
+    void GetPosition(float time, float position[3]) const;
+    const float* GetInitialPosition() const;
+    // The current patrol, 0 speed when there is none
+    const float* GetPatrolPosition() const;
+    const float* GetPatrolDirection() const;
+    float GetPatrolStart() const;
+    float GetPatrolSpeed() const;
+
+    void SaveState(State& state) const;
+    // Whether LoadState can resume the behaviour of the state
+    static bool IsValidState(const State& state);
+    void LoadState(const State& state);
+
+private:
+    // Where the behaviours wait, stored in snapshots, so never renumbered
+    enum class BehaviourPoint : uint32_t {
+        Start = 0,
+        PatrolEnd = 1,
+        DyingTick = 2,
+        Ended = kBehaviourEnded,
+    };
+
+private:
+    // The behaviours, see Behaviour.h
+    double Patrol(double time, std::mt19937& random);
+    double Dying(float dt);
+    void StartPatrol(float time, std::mt19937& random);
+
+private:
+    float mInitialPosition[3] = {};
+    float mPosition[3] = {};
+    float mDirection[3] = {};
+    // Patrols a second, 0 until the first update picks a patrol and once dying
+    float mSpeed = 0.0f;
+    float mPatrolStart = 0.0f;
+
+    float mAnimationTime = 0.0f; // Of dying
+    bool mDying = false;
+
+    double mUpdateTime = 0.0;
+    BehaviourFrame mBehaviour;
+    double mWakeTime = kBehaviourNextTick;
+};
@@ -0,0 +1,116 @@
+#include "FrameArena.h"
+#include "MemoryTracker.h"
+
+#include <algorithm>
+
+
+static std::size_t AlignUp(std::size_t value, std::size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+FrameArena::FrameArena(std::size_t capacity, std::pmr::memory_resource* upstream) :
+    // Getting the tracker first also makes sure it outlives the arenas of threads that exit late
+    mUpstream(upstream ? upstream : MemoryTracker::Get().GetResource(MemoryTag::FrameArenas))
+{
+    mCapacity = AlignUp(std::max(capacity, kBlockAlignment), kBlockAlignment);
+    mBlock = static_cast<uint8_t*>(mUpstream->allocate(mCapacity, kBlockAlignment));
+}
+
+FrameArena::~FrameArena()
+{
+    FreeSpilledBlocks();
+    mUpstream->deallocate(mBlock, mCapacity, kBlockAlignment);
+}
+
+FrameArena& FrameArena::Get()
+{
+    thread_local FrameArena arena;
+    return arena;
+}
+
+void FrameArena::Reset()
+{
+    std::size_t usedBytes = GetUsedBytes();
+    mPeakBytes = std::max(mPeakBytes, usedBytes);
+    if (mSpilledBlocks)
+    {
+        FreeSpilledBlocks();
+        // Room for the whole frame and some more, so the next ones fit in one block
+        std::size_t capacity = mCapacity;
+        while (capacity < usedBytes + usedBytes / 4)
+        {
+            capacity *= 2;
+        }
+        mUpstream->deallocate(mBlock, mCapacity, kBlockAlignment);
+        mBlock = static_cast<uint8_t*>(mUpstream->allocate(capacity, kBlockAlignment));
+        mCapacity = capacity;
+    }
+    mOffset = 0;
+    mLastOffset = 0;
+}
+
+std::size_t FrameArena::GetCapacity() const
+{
+    return mCapacity;
+}
+
+std::size_t FrameArena::GetUsedBytes() const
+{
+    return mOffset + mSpilledBytes;
+}
+
+std::size_t FrameArena::GetPeakBytes() const
+{
+    return std::max(mPeakBytes, GetUsedBytes());
+}
+
+void* FrameArena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    if (alignment <= kBlockAlignment)
+    {
+        std::size_t offset = AlignUp(mOffset, alignment);
+        if (offset + bytes <= mCapacity)
+        {
+            mLastOffset = offset;
+            mOffset = offset + bytes;
+            return mBlock + offset;
+        }
+    }
+
+    // The block is full, keep going in a block of its own until the next Reset
+    alignment = std::max(alignment, alignof(SpilledBlock));
+    std::size_t headerSize = AlignUp(sizeof(SpilledBlock), alignment);
+    std::size_t size = headerSize + bytes;
+    auto* block = static_cast<SpilledBlock*>(mUpstream->allocate(size, alignment));
+    block->next = mSpilledBlocks;
+    block->size = size;
+    block->alignment = alignment;
+    mSpilledBlocks = block;
+    mSpilledBytes += bytes;
+    return reinterpret_cast<uint8_t*>(block) + headerSize;
+}
+
+void FrameArena::do_deallocate(void* pointer, std::size_t bytes, std::size_t)
+{
+    if (pointer == mBlock + mLastOffset && mLastOffset + bytes == mOffset)
+    {
+        mOffset = mLastOffset;
+    }
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+void FrameArena::FreeSpilledBlocks()
+{
+    while (mSpilledBlocks)
+    {
+        auto* next = mSpilledBlocks->next;
+        mUpstream->deallocate(mSpilledBlocks, mSpilledBlocks->size, mSpilledBlocks->alignment);
+        mSpilledBlocks = next;
+    }
+    mSpilledBytes = 0;
+}
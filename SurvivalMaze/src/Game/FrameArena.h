@@ -0,0 +1,76 @@
+#pragma once
+
+
+#include <cstdint>
+#include <memory_resource>
+#include <type_traits>
+
+
+// Bump allocator for data that only lives until the end of the frame, one per thread. Allocating is a pointer bump
+// and freeing does nothing (except for the last allocation, which is rewound, so scratch freed in reverse order is
+// reused right away), then Reset drops everything at once. A frame that doesn't fit spills into blocks of the
+// upstream resource, and the next Reset grows the arena to hold the whole frame, so after warm up a frame never
+// touches the heap.
+// Use it directly for scratch arrays or as the resource of std::pmr containers. Each thread resets its own arena at
+// its own frame boundary, the main thread at the start of Application::OnUpdate
+
+class FrameArena : public std::pmr::memory_resource
+{
+public:
+    static constexpr const std::size_t kInitialCapacity = 1 << 20;
+    static constexpr const std::size_t kBlockAlignment = 64;
+
+public:
+    explicit FrameArena(std::size_t capacity = kInitialCapacity, std::pmr::memory_resource* upstream = nullptr);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+public:
+    // The calling thread's arena, its memory is tracked under MemoryTag::FrameArenas
+    static FrameArena& Get();
+
+    void Reset();
+
+    // Uninitialized, valid until the next Reset
+    template <typename T>
+    T* AllocateArray(std::size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>,
+            "Nothing in the arena is ever destroyed");
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    std::size_t GetCapacity() const;
+    // Since the last Reset, spilled bytes included
+    std::size_t GetUsedBytes() const;
+    // Most bytes a frame has used
+    std::size_t GetPeakBytes() const;
+
+private:
+    struct SpilledBlock
+    {
+        SpilledBlock* next;
+        std::size_t size;
+        std::size_t alignment;
+    };
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    void FreeSpilledBlocks();
+
+private:
+    std::pmr::memory_resource* mUpstream;
+    uint8_t* mBlock = nullptr;
+    std::size_t mCapacity = 0;
+    std::size_t mOffset = 0;
+    std::size_t mLastOffset = 0; // Where the last allocation starts
+
+    SpilledBlock* mSpilledBlocks = nullptr;
+    std::size_t mSpilledBytes = 0;
+    std::size_t mPeakBytes = 0;
+};
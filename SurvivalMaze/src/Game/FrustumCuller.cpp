@@ -0,0 +1,149 @@
+#include "FrustumCuller.h"
+
+using namespace DirectX;
+
+
+void __vectorcall FrustumCuller::Update(FXMMATRIX view, CXMMATRIX projection)
+{
+    XMFLOAT4X4 viewProjection;
+    XMStoreFloat4x4(&viewProjection, XMMatrixMultiply(view, projection));
+    const auto& m = viewProjection.m;
+
+    // Gribb & Hartmann, for row vectors and a [0, 1] depth range
+    mPlanes[0] = { m[0][3] + m[0][0], m[1][3] + m[1][0], m[2][3] + m[2][0], m[3][3] + m[3][0] }; // Left
+    mPlanes[1] = { m[0][3] - m[0][0], m[1][3] - m[1][0], m[2][3] - m[2][0], m[3][3] - m[3][0] }; // Right
+    mPlanes[2] = { m[0][3] + m[0][1], m[1][3] + m[1][1], m[2][3] + m[2][1], m[3][3] + m[3][1] }; // Bottom
+    mPlanes[3] = { m[0][3] - m[0][1], m[1][3] - m[1][1], m[2][3] - m[2][1], m[3][3] - m[3][1] }; // Top
+    mPlanes[4] = { m[0][2], m[1][2], m[2][2], m[3][2] };                                           // Near
+    mPlanes[5] = { m[0][3] - m[0][2], m[1][3] - m[1][2], m[2][3] - m[2][2], m[3][3] - m[3][2] }; // Far
+
+    for (uint32_t i = 0; i < kNumPlanes; ++i)
+    {
+        auto& plane = mPlanes[i];
+        float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+        if (length > 0.0f)
+        {
+            plane.x /= length;
+            plane.y /= length;
+            plane.z /= length;
+            plane.w /= length;
+        }
+
+        mPlaneX[i] = XMVectorReplicate(plane.x);
+        mPlaneY[i] = XMVectorReplicate(plane.y);
+        mPlaneZ[i] = XMVectorReplicate(plane.z);
+        mPlaneD[i] = XMVectorReplicate(plane.w);
+        mAbsPlaneX[i] = XMVectorReplicate(std::fabs(plane.x));
+        mAbsPlaneY[i] = XMVectorReplicate(std::fabs(plane.y));
+        mAbsPlaneZ[i] = XMVectorReplicate(std::fabs(plane.z));
+    }
+
+    mStatistics = {};
+}
+
+ContainmentType FrustumCuller::Classify(const BoundingBox& box) const
+{
+    bool intersects = false;
+    for (uint32_t i = 0; i < kNumPlanes; ++i)
+    {
+        const auto& plane = mPlanes[i];
+        float distance = plane.x * box.Center.x + plane.y * box.Center.y + plane.z * box.Center.z + plane.w;
+        float radius = std::fabs(plane.x) * box.Extents.x + std::fabs(plane.y) * box.Extents.y + std::fabs(plane.z) * box.Extents.z;
+        if (distance < -radius)
+        {
+            return DISJOINT;
+        }
+        intersects |= distance < radius;
+    }
+    return intersects ? INTERSECTS : CONTAINS;
+}
+
+ContainmentType FrustumCuller::ClassifyChunk(const BoundingBox& box, uint32_t numInstances)
+{
+    auto containment = Classify(box);
+    switch (containment)
+    {
+    case DISJOINT:
+        mStatistics.CulledChunks++;
+        mStatistics.CulledInstances += numInstances;
+        break;
+    case CONTAINS:
+        mStatistics.VisibleChunks++;
+        mStatistics.VisibleInstances += numInstances;
+        break;
+    default:
+        mStatistics.VisibleChunks++;
+        break;
+    }
+    return containment;
+}
+
+bool FrustumCuller::IsVisible(const BoundingBox& box)
+{
+    bool visible = Classify(box) != DISJOINT;
+    if (visible)
+    {
+        mStatistics.VisibleInstances++;
+    }
+    else
+    {
+        mStatistics.CulledInstances++;
+    }
+    return visible;
+}
+
+uint32_t FrustumCuller::CullBoxes(const BoundingBox* boxes, uint32_t count, uint32_t* visibleIndices)
+{
+    uint32_t numVisible = 0;
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const auto* batch = boxes + i;
+        XMVECTOR centerX = XMVectorSet(batch[0].Center.x, batch[1].Center.x, batch[2].Center.x, batch[3].Center.x);
+        XMVECTOR centerY = XMVectorSet(batch[0].Center.y, batch[1].Center.y, batch[2].Center.y, batch[3].Center.y);
+        XMVECTOR centerZ = XMVectorSet(batch[0].Center.z, batch[1].Center.z, batch[2].Center.z, batch[3].Center.z);
+        XMVECTOR extentsX = XMVectorSet(batch[0].Extents.x, batch[1].Extents.x, batch[2].Extents.x, batch[3].Extents.x);
+        XMVECTOR extentsY = XMVectorSet(batch[0].Extents.y, batch[1].Extents.y, batch[2].Extents.y, batch[3].Extents.y);
+        XMVECTOR extentsZ = XMVectorSet(batch[0].Extents.z, batch[1].Extents.z, batch[2].Extents.z, batch[3].Extents.z);
+
+        XMVECTOR outside = XMVectorFalseInt();
+        for (uint32_t plane = 0; plane < kNumPlanes; ++plane)
+        {
+            XMVECTOR distance = XMVectorMultiplyAdd(centerX, mPlaneX[plane], mPlaneD[plane]);
+            distance = XMVectorMultiplyAdd(centerY, mPlaneY[plane], distance);
+            distance = XMVectorMultiplyAdd(centerZ, mPlaneZ[plane], distance);
+
+            XMVECTOR radius = XMVectorMultiply(extentsX, mAbsPlaneX[plane]);
+            radius = XMVectorMultiplyAdd(extentsY, mAbsPlaneY[plane], radius);
+            radius = XMVectorMultiplyAdd(extentsZ, mAbsPlaneZ[plane], radius);
+
+            outside = XMVectorOrInt(outside, XMVectorLess(XMVectorAdd(distance, radius), XMVectorZero()));
+        }
+
+        uint32_t outsideMask[4];
+        XMStoreInt4(outsideMask, outside);
+        for (uint32_t lane = 0; lane < 4; ++lane)
+        {
+            if (!outsideMask[lane])
+            {
+                visibleIndices[numVisible++] = i + lane;
+            }
+        }
+    }
+    for (; i < count; ++i)
+    {
+        if (Classify(boxes[i]) != DISJOINT)
+        {
+            visibleIndices[numVisible++] = i;
+        }
+    }
+
+    mStatistics.VisibleInstances += numVisible;
+    mStatistics.CulledInstances += count - numVisible;
+    return numVisible;
+}
+
+const FrustumCuller::Statistics& FrustumCuller::GetStatistics() const
+{
+    return mStatistics;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+
+#include <Oblivion.h>
+
+
+// CPU only view frustum culling. Planes are extracted from the camera's view * projection in world space,
+// so nothing here needs a device. Chunks are classified first, so instances are only tested one by one
+// when their chunk straddles the frustum. Instances are tested four at a time with SIMD.
+class FrustumCuller
+{
+public:
+    struct Statistics
+    {
+        uint32_t VisibleChunks;
+        uint32_t CulledChunks;
+        uint32_t VisibleInstances;
+        uint32_t CulledInstances;
+    };
+
+public:
+    FrustumCuller() = default;
+
+public:
+    // Also resets the statistics, so call it once per frame
+    void __vectorcall Update(DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection);
+
+    DirectX::ContainmentType Classify(const DirectX::BoundingBox& box) const;
+
+    // Classifies a group of numInstances instances bounded by box. Instances of rejected or fully
+    // contained chunks are counted here, the ones of intersecting chunks should go through CullBoxes
+    DirectX::ContainmentType ClassifyChunk(const DirectX::BoundingBox& box, uint32_t numInstances);
+
+    bool IsVisible(const DirectX::BoundingBox& box);
+
+    // Writes the indices of the visible boxes to visibleIndices (at least count elements) and returns how many there are
+    uint32_t CullBoxes(const DirectX::BoundingBox* boxes, uint32_t count, uint32_t* visibleIndices);
+
+    const Statistics& GetStatistics() const;
+
+private:
+    static constexpr const uint32_t kNumPlanes = 6;
+
+    // Planes point inwards: a point p is inside when dot(normal, p) + distance >= 0
+    DirectX::XMFLOAT4 mPlanes[kNumPlanes];
+
+    // Each plane component replicated in all lanes, for the SIMD path
+    DirectX::XMVECTOR mPlaneX[kNumPlanes];
+    DirectX::XMVECTOR mPlaneY[kNumPlanes];
+    DirectX::XMVECTOR mPlaneZ[kNumPlanes];
+    DirectX::XMVECTOR mPlaneD[kNumPlanes];
+    DirectX::XMVECTOR mAbsPlaneX[kNumPlanes];
+    DirectX::XMVECTOR mAbsPlaneY[kNumPlanes];
+    DirectX::XMVECTOR mAbsPlaneZ[kNumPlanes];
+
+    Statistics mStatistics = {};
+};
@@ -0,0 +1,70 @@
+#include "GameRules.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+
+namespace {
+    constexpr float kTwoPi = 6.28318530718f;
+}
+
+namespace GameRules {
+    float GetPatrolOffset(float startTime, float speed, float time)
+    {
+        float phase = speed * (time - startTime);
+        if (speed == 0.0f || phase <= 0.0f || phase >= 1.0f) {
+            return 0.0f;
+        }
+        return std::sin(phase * kTwoPi);
+    }
+
+    bool Touches(const Footprint& a, const Footprint& b)
+    {
+        return std::fabs(a.x - b.x) <= a.halfWidth + b.halfWidth && std::fabs(a.z - b.z) <= a.halfDepth + b.halfDepth;
+    }
+
+    GridLayout GetWallLayout(uint32_t rows, uint32_t cols, float tileSize, const float boxMin[3], const float boxMax[3])
+    {
+        // Walls are all the same box, so take its footprint relative to the center of the first tile once
+        auto wall = MazeGrid::BuildTileInstance(TileType::Wall, 0, 0, rows, cols, tileSize);
+        float firstTileX = -(float)cols / 2.0f * tileSize, firstTileZ = -(float)rows / 2.0f * tileSize;
+        float scaleX = wall.WorldMatrix[0][0], scaleZ = wall.WorldMatrix[2][2];
+        return { rows, cols, tileSize, tileSize,
+            scaleX * (boxMin[0] + boxMax[0]) / 2.0f + wall.WorldMatrix[3][0] - firstTileX,
+            scaleZ * (boxMin[2] + boxMax[2]) / 2.0f + wall.WorldMatrix[3][2] - firstTileZ,
+            std::fabs(scaleX) * (boxMax[0] - boxMin[0]) / 2.0f, std::fabs(scaleZ) * (boxMax[2] - boxMin[2]) / 2.0f };
+    }
+
+    TileCoordinates GetChunk(const TileCoordinates& tile)
+    {
+        return { std::max(tile.x, 0) / (int32_t)kChunkSize, std::max(tile.y, 0) / (int32_t)kChunkSize };
+    }
+
+    SimulationLevel GetSimulationLevel(const TileCoordinates& chunk, const TileCoordinates& focusChunk, uint32_t nearRadius,
+        uint32_t midRadius)
+    {
+        auto distance = (uint32_t)std::max(std::abs(chunk.x - focusChunk.x), std::abs(chunk.y - focusChunk.y));
+        if (distance <= nearRadius) {
+            return SimulationLevel::Near;
+        }
+        if (distance <= midRadius) {
+            return SimulationLevel::Mid;
+        }
+        return SimulationLevel::Far;
+    }
+
+    double GetResumeTime(SimulationLevel level, double wakeTime)
+    {
+        switch (level) {
+        case SimulationLevel::Near:
+            return wakeTime;
+        case SimulationLevel::Mid: {
+            constexpr double kMidTime = kMidSimulationInterval * kTimerTickTime;
+            return std::ceil(wakeTime / kMidTime) * kMidTime;
+        }
+        default:
+            return kBehaviourDone;
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+
+#include <cstdint>
+
+#include "Behaviour.h"
+#include "GridCollision.h"
+#include "MazeGrid.h"
+
+
+// The gameplay rules that don't need a renderer, shared by the game and the headless SimWorld so the two can't drift
+// apart. Whatever depends on a model, like the size of the player or of an enemy, is measured on the model by the game
+namespace GameRules {
+    constexpr const float kTileSize = 5.0f;
+    constexpr const float kEnemyProbability = 0.1f;  // Of a free tile, see MazeGrid::Lee
+    constexpr const float kMaximumTime = 600.0f;     // To get out, in seconds
+    constexpr const uint32_t kMaximumProjectiles = 2; // In flight at once
+    constexpr const float kPlayerSpeed = 3.0f;
+    constexpr const float kTouchDamage = 1.0f / 3.0f; // Health lost for every enemy the player walks into
+    constexpr const float kProjectileSpeed = 5.0f;
+    constexpr const float kProjectileLifetime = 5.0f;
+
+    // Sizes of the models, which the game measures once they are loaded and compares with these, see
+    // Application::CheckModelSizes. SimWorld has no models and uses these as they are
+    constexpr const float kPlayerRadius = 2.2f;         // Of the player capsule, see Player::Create
+    constexpr const float kEnemyHalfExtent = 1.0f;      // Of the sphere model the enemies are drawn with
+    constexpr const float kProjectileHalfExtent = 0.5f; // Of the sphere model, scaled by Projectile::scale
+    constexpr const float kWallHalfExtent = 0.5f;       // Of the cube model, before BuildTileInstance scales it to the tile
+    constexpr const float kModelSizeTolerance = 0.01f;
+
+    // Enemies patrol along one of these, back and forth through their tile and back to it once a patrol.
+    // Not normalized on purpose, the diagonal goes further
+    constexpr const float kPatrolDirections[][3] = {
+        { 1.0f, 0.0f, 0.0f },
+        { 0.0f, 0.0f, 1.0f },
+        { 1.0f, 0.0f, 1.0f },
+    };
+    // Patrols a second, picked with the direction and kept for the whole patrol, so a patrol is a closed function of
+    // time the vertex shader and SimWorld evaluate alike. Enemies used to draw a new speed from [0.0001, 1/3] every
+    // update; this range has the same mean, and keeps one patrol between 4 and 12 seconds instead of up to hours
+    constexpr const float kMinPatrolSpeed = 1.0f / 12.0f;
+    constexpr const float kMaxPatrolSpeed = 1.0f / 4.0f;
+
+    // Enemies are resumed by timers of this resolution, on the first tick at or after their wake time
+    constexpr const double kTimerTickTime = 1.0 / 60.0;
+    // Simulation levels are by distance in chunks of kChunkSize x kChunkSize tiles, see GetSimulationLevel
+    constexpr const uint32_t kChunkSize = 16;
+    constexpr const uint32_t kSimulationNearRadius = 1;
+    constexpr const uint32_t kSimulationMidRadius = 3;
+    // Enemies in the mid simulation range are only resumed on timer ticks that are a multiple of this
+    constexpr const uint32_t kMidSimulationInterval = 4;
+
+    enum class SimulationLevel {
+        Near = 0, // Resumed on the tick they asked for
+        Mid,      // Up to kMidSimulationInterval ticks later
+        Far,      // Not at all, and neither drawn nor collided with
+    };
+
+    // Rectangle on the XZ plane. Everything moves on the floor and the enemy, player and projectile boxes always
+    // overlap in height, so hits don't look at it. This used to be a 3D DirectX::BoundingBox::Intersects
+    struct Footprint {
+        float x, z;
+        float halfWidth, halfDepth;
+    };
+
+    // Offset along the patrol direction at time: one period of sin(2 pi phase), phase = speed * (time - startTime),
+    // and none outside of it, so whoever is late to start the next patrol waits where the last one ended
+    float GetPatrolOffset(float startTime, float speed, float time);
+
+    // Touching counts, like DirectX::BoundingBox::Intersects
+    bool Touches(const Footprint& a, const Footprint& b);
+
+    // The wall of every tile is the model box boxMin, boxMax placed by MazeGrid::BuildTileInstance
+    GridLayout GetWallLayout(uint32_t rows, uint32_t cols, float tileSize, const float boxMin[3], const float boxMax[3]);
+
+    // Tiles before the first row or column are in the first chunk
+    TileCoordinates GetChunk(const TileCoordinates& tile);
+    // Of an enemy whose tile is in chunk, with the player in focusChunk
+    SimulationLevel GetSimulationLevel(const TileCoordinates& chunk, const TileCoordinates& focusChunk, uint32_t nearRadius,
+        uint32_t midRadius);
+    // When an enemy of level that wants to be resumed at wakeTime is, kBehaviourDone for never
+    double GetResumeTime(SimulationLevel level, double wakeTime);
+}
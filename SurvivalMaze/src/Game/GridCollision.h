@@ -0,0 +1,95 @@
+#pragma once
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+
+// Renderer independent capsule vs tile grid collisions, shared by Maze and the headless SimWorld.
+// Tile (row, col) is centered on ((col - cols / 2) * tileWidth, (row - rows / 2) * tileDepth) in the XZ plane,
+// like everywhere else in the game, and a wall fills footprint around that center
+struct GridLayout {
+    uint32_t rows, cols;
+    float tileWidth, tileDepth;
+    // Wall box in the XZ plane, relative to the center of its tile
+    float footprintCenterX, footprintCenterZ;
+    float footprintHalfWidth, footprintHalfDepth;
+};
+
+namespace GridCollision {
+    inline int64_t GetCol(const GridLayout& layout, float x)
+    {
+        return (int64_t)std::floor(x / layout.tileWidth + (float)layout.cols / 2.0f + 0.5f);
+    }
+
+    inline int64_t GetRow(const GridLayout& layout, float z)
+    {
+        return (int64_t)std::floor(z / layout.tileDepth + (float)layout.rows / 2.0f + 0.5f);
+    }
+
+    // Pushes the circle out of the walls around it, returns false when it didn't touch any.
+    // isWall(row, col) must accept coordinates outside of the grid
+    template <typename IsWall>
+    bool ResolveCircle(const GridLayout& layout, const IsWall& isWall, float& x, float& z, float radius)
+    {
+        // A wall can reach a bit past its tile, hence the extra tile on every side
+        int64_t firstRow = GetRow(layout, z - radius) - 1, lastRow = GetRow(layout, z + radius) + 1;
+        int64_t firstCol = GetCol(layout, x - radius) - 1, lastCol = GetCol(layout, x + radius) + 1;
+        bool touched = false;
+        for (int64_t row = firstRow; row <= lastRow; ++row) {
+            for (int64_t col = firstCol; col <= lastCol; ++col) {
+                if (!isWall(row, col)) {
+                    continue;
+                }
+                float centerX = ((float)col - (float)layout.cols / 2.0f) * layout.tileWidth + layout.footprintCenterX;
+                float centerZ = ((float)row - (float)layout.rows / 2.0f) * layout.tileDepth + layout.footprintCenterZ;
+                float minX = centerX - layout.footprintHalfWidth, maxX = centerX + layout.footprintHalfWidth;
+                float minZ = centerZ - layout.footprintHalfDepth, maxZ = centerZ + layout.footprintHalfDepth;
+
+                float offsetX = x - std::clamp(x, minX, maxX);
+                float offsetZ = z - std::clamp(z, minZ, maxZ);
+                float distanceSquared = offsetX * offsetX + offsetZ * offsetZ;
+                if (distanceSquared >= radius * radius) {
+                    continue;
+                }
+                touched = true;
+                if (distanceSquared > 1e-8f) {
+                    // Push out along the normal of the closest point, the tangential part of the move is kept
+                    float distance = std::sqrt(distanceSquared);
+                    float push = (radius - distance) / distance;
+                    x += offsetX * push;
+                    z += offsetZ * push;
+                } else {
+                    // The center is inside the wall, leave through the closest side
+                    float pushes[] = { minX - radius - x, maxX + radius - x, minZ - radius - z, maxZ + radius - z };
+                    uint32_t closest = 0;
+                    for (uint32_t i = 1; i < 4; ++i) {
+                        if (std::fabs(pushes[i]) < std::fabs(pushes[closest])) {
+                            closest = i;
+                        }
+                    }
+                    (closest < 2 ? x : z) += pushes[closest];
+                }
+            }
+        }
+        return touched;
+    }
+
+    // Moves the circle by (dx, dz), sliding along the walls it runs into. Steps no longer than the radius
+    // can't go through a wall, and pushing out of one wall can push into another one in corners, so it iterates a few times
+    template <typename IsWall>
+    void MoveCircle(const GridLayout& layout, const IsWall& isWall, float& x, float& z, float radius, float dx, float dz)
+    {
+        float length = std::sqrt(dx * dx + dz * dz);
+        uint32_t numSteps = std::max(1u, (uint32_t)std::ceil(length / radius));
+        dx /= (float)numSteps;
+        dz /= (float)numSteps;
+        for (uint32_t step = 0; step < numSteps; ++step) {
+            x += dx;
+            z += dz;
+            for (uint32_t iteration = 0; iteration < 4 && ResolveCircle(layout, isWall, x, z, radius); ++iteration) {
+            }
+        }
+    }
+}
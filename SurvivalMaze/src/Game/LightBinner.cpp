@@ -0,0 +1,134 @@
+#include "LightBinner.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+void LightBinner::Bin(const PointLight* lights, uint32_t numLights, float originX, float originZ, float clusterSize,
+    uint32_t maxLights, uint32_t maxIndices)
+{
+    mOriginX = originX;
+    mOriginZ = originZ;
+    mClusterSize = clusterSize;
+    mClusters.assign(kNumClusters, { 0, 0 });
+    mBinnedLights.clear();
+    mBinnedRanges.clear();
+
+    // Counting sort: count the lights of every cluster, turn the counts into offsets, then scatter the indices
+    uint32_t firstX, firstZ, lastX, lastZ;
+    for (uint32_t i = 0; i < numLights && mBinnedLights.size() < maxLights; ++i)
+    {
+        if (!GetClusterRange(lights[i], firstX, firstZ, lastX, lastZ))
+        {
+            continue;
+        }
+        mBinnedLights.push_back(i);
+        mBinnedRanges.push_back({ firstX, firstZ, lastX, lastZ });
+        for (uint32_t z = firstZ; z <= lastZ; ++z)
+        {
+            for (uint32_t x = firstX; x <= lastX; ++x)
+            {
+                if (ReachesCluster(lights[i], x, z))
+                {
+                    mClusters[z * kClustersAcross + x].Count++;
+                }
+            }
+        }
+    }
+
+    uint32_t offset = 0;
+    for (auto& cluster : mClusters)
+    {
+        cluster.Offset = offset;
+        cluster.Count = std::min(cluster.Count, maxIndices - offset);
+        offset += cluster.Count;
+    }
+    mLightIndices.resize(offset);
+
+    mFilled.assign(kNumClusters, 0);
+    for (uint32_t binned = 0; binned < (uint32_t)mBinnedLights.size(); ++binned)
+    {
+        const auto& light = lights[mBinnedLights[binned]];
+        const auto& range = mBinnedRanges[binned];
+        for (uint32_t z = range.FirstZ; z <= range.LastZ; ++z)
+        {
+            for (uint32_t x = range.FirstX; x <= range.LastX; ++x)
+            {
+                auto clusterIndex = z * kClustersAcross + x;
+                const auto& cluster = mClusters[clusterIndex];
+                if (mFilled[clusterIndex] < cluster.Count && ReachesCluster(light, x, z))
+                {
+                    mLightIndices[cluster.Offset + mFilled[clusterIndex]++] = binned;
+                }
+            }
+        }
+    }
+}
+
+const std::vector<uint32_t>& LightBinner::GetBinnedLights() const
+{
+    return mBinnedLights;
+}
+
+const std::vector<LightBinner::Cluster>& LightBinner::GetClusters() const
+{
+    return mClusters;
+}
+
+const std::vector<uint32_t>& LightBinner::GetLightIndices() const
+{
+    return mLightIndices;
+}
+
+uint32_t LightBinner::FindClosestLights(const PointLight* lights, uint32_t numLights, float x, float z, uint32_t maxLights,
+    uint32_t* closestLights)
+{
+    auto distance = [&](uint32_t light)
+    {
+        float dx = lights[light].Position[0] - x, dz = lights[light].Position[2] - z;
+        return dx * dx + dz * dz;
+    };
+    // Insertion into the closest ones so far, maxLights is small
+    uint32_t numClosest = 0;
+    for (uint32_t i = 0; i < numLights && maxLights > 0; ++i)
+    {
+        float lightDistance = distance(i);
+        if (lightDistance > lights[i].FalloffEnd * lights[i].FalloffEnd ||
+            (numClosest == maxLights && lightDistance >= distance(closestLights[numClosest - 1])))
+        {
+            continue;
+        }
+        uint32_t j = numClosest < maxLights ? numClosest++ : numClosest - 1;
+        for (; j > 0 && distance(closestLights[j - 1]) > lightDistance; --j)
+        {
+            closestLights[j] = closestLights[j - 1];
+        }
+        closestLights[j] = i;
+    }
+    return numClosest;
+}
+
+bool LightBinner::GetClusterRange(const PointLight& light, uint32_t& firstX, uint32_t& firstZ, uint32_t& lastX, uint32_t& lastZ) const
+{
+    const float gridSize = mClusterSize * kClustersAcross;
+    float minX = light.Position[0] - light.FalloffEnd - mOriginX, maxX = light.Position[0] + light.FalloffEnd - mOriginX;
+    float minZ = light.Position[2] - light.FalloffEnd - mOriginZ, maxZ = light.Position[2] + light.FalloffEnd - mOriginZ;
+    if (maxX < 0.0f || maxZ < 0.0f || minX >= gridSize || minZ >= gridSize)
+    {
+        return false;
+    }
+    firstX = (uint32_t)std::max(minX / mClusterSize, 0.0f);
+    firstZ = (uint32_t)std::max(minZ / mClusterSize, 0.0f);
+    lastX = std::min((uint32_t)(maxX / mClusterSize), kClustersAcross - 1);
+    lastZ = std::min((uint32_t)(maxZ / mClusterSize), kClustersAcross - 1);
+    return true;
+}
+
+bool LightBinner::ReachesCluster(const PointLight& light, uint32_t clusterX, uint32_t clusterZ) const
+{
+    // Distance from the light to the closest point of the cluster
+    float minX = mOriginX + clusterX * mClusterSize, minZ = mOriginZ + clusterZ * mClusterSize;
+    float dx = light.Position[0] - std::clamp(light.Position[0], minX, minX + mClusterSize);
+    float dz = light.Position[2] - std::clamp(light.Position[2], minZ, minZ + mClusterSize);
+    return dx * dx + dz * dz <= light.FalloffEnd * light.FalloffEnd;
+}
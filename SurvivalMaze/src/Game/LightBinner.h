@@ -0,0 +1,68 @@
+#pragma once
+
+
+#include <cstdint>
+#include <vector>
+
+
+struct PointLight {
+    float Position[3];
+    float FalloffStart;
+    float Strength[3];
+    float FalloffEnd;
+};
+
+// Bins point lights into a square grid of clusters over the XZ plane, so shading a point only has to go
+// through the lights of its cluster. The grid covers kClustersAcross x kClustersAcross clusters starting at
+// an origin that follows the camera, lights that don't reach it are dropped.
+// The result is the list of lights that reach the grid, which is what gets uploaded, and a compact index list
+// per cluster (offset and count into one array of indices into that list)
+class LightBinner
+{
+public:
+    static constexpr const uint32_t kClustersAcross = 64;
+    static constexpr const uint32_t kNumClusters = kClustersAcross * kClustersAcross;
+
+    struct Cluster {
+        uint32_t Offset;
+        uint32_t Count;
+    };
+
+public:
+    LightBinner() = default;
+
+public:
+    // maxLights and maxIndices are the sizes of the buffers the result is uploaded to, whatever doesn't fit is dropped
+    void Bin(const PointLight* lights, uint32_t numLights, float originX, float originZ, float clusterSize,
+        uint32_t maxLights, uint32_t maxIndices);
+
+    // Indices into the lights given to Bin
+    const std::vector<uint32_t>& GetBinnedLights() const;
+    const std::vector<Cluster>& GetClusters() const;
+    // Indices into GetBinnedLights
+    const std::vector<uint32_t>& GetLightIndices() const;
+
+    // Without binning, for a handful of lights: the lights that reach x, z sorted by distance to it, as indices into
+    // lights. Returns how many were written
+    static uint32_t FindClosestLights(const PointLight* lights, uint32_t numLights, float x, float z, uint32_t maxLights,
+        uint32_t* closestLights);
+
+private:
+    // Returns false if the light doesn't reach the grid
+    bool GetClusterRange(const PointLight& light, uint32_t& firstX, uint32_t& firstZ, uint32_t& lastX, uint32_t& lastZ) const;
+    bool ReachesCluster(const PointLight& light, uint32_t clusterX, uint32_t clusterZ) const;
+
+private:
+    float mOriginX = 0.0f, mOriginZ = 0.0f;
+    float mClusterSize = 1.0f;
+
+    struct ClusterRange {
+        uint32_t FirstX, FirstZ;
+        uint32_t LastX, LastZ;
+    };
+    std::vector<uint32_t> mBinnedLights;
+    std::vector<ClusterRange> mBinnedRanges;
+    std::vector<Cluster> mClusters;
+    std::vector<uint32_t> mFilled;
+    std::vector<uint32_t> mLightIndices;
+};
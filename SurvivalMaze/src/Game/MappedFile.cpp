@@ -0,0 +1,126 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    mFileHandle = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        Close();
+        return false;
+    }
+    mSize = (uint64_t)fileSize.QuadPart;
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        Close();
+        return false;
+    }
+    mMappingHandle = mapping;
+
+    mData = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    mFileDescriptor = open(path.c_str(), O_RDONLY);
+    if (mFileDescriptor < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStats;
+    if (fstat(mFileDescriptor, &fileStats) != 0 || fileStats.st_size == 0)
+    {
+        Close();
+        return false;
+    }
+    mSize = (uint64_t)fileStats.st_size;
+
+    void* data = mmap(nullptr, (size_t)mSize, PROT_READ, MAP_SHARED, mFileDescriptor, 0);
+    mData = data == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(data);
+#endif
+
+    if (mData == nullptr)
+    {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close()
+{
+#if defined(_WIN32)
+    if (mData)
+    {
+        UnmapViewOfFile(mData);
+    }
+    if (mMappingHandle)
+    {
+        CloseHandle((HANDLE)mMappingHandle);
+        mMappingHandle = nullptr;
+    }
+    if (mFileHandle)
+    {
+        CloseHandle((HANDLE)mFileHandle);
+        mFileHandle = nullptr;
+    }
+#else
+    if (mData)
+    {
+        munmap((void*)mData, (size_t)mSize);
+    }
+    if (mFileDescriptor >= 0)
+    {
+        close(mFileDescriptor);
+        mFileDescriptor = -1;
+    }
+#endif
+    mData = nullptr;
+    mSize = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+    return mData != nullptr;
+}
+
+const uint8_t* MappedFile::GetData() const
+{
+    return mData;
+}
+
+uint64_t MappedFile::GetSize() const
+{
+    return mSize;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+
+#include <cstdint>
+#include <string>
+
+
+// Read-only view of a whole file. Works on both Windows and POSIX, so the offline tools can use it too
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+public:
+    bool Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const;
+    const uint8_t* GetData() const;
+    uint64_t GetSize() const;
+
+    template <typename T>
+    const T* GetAt(uint64_t offset) const
+    {
+        return reinterpret_cast<const T*>(mData + offset);
+    }
+
+private:
+    const uint8_t* mData = nullptr;
+    uint64_t mSize = 0;
+
+#if defined(_WIN32)
+    void* mFileHandle = nullptr;
+    void* mMappingHandle = nullptr;
+#else
+    int mFileDescriptor = -1;
+#endif
+};
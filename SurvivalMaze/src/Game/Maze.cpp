@@ -1,29 +1,105 @@
 #include "Maze.h"
 
-Result<DirectX::XMFLOAT3> Maze::Create(const MazeInitializationInfo& info)
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+static void CopyTileInstance(const TileInstance& tileInstance, InstanceInfo& instanceInfo)
+{
+    instanceInfo.WorldMatrix = DirectX::XMLoadFloat4x4(reinterpret_cast<const DirectX::XMFLOAT4X4*>(&tileInstance.WorldMatrix));
+    instanceInfo.Color = { tileInstance.Color[0], tileInstance.Color[1], tileInstance.Color[2], tileInstance.Color[3] };
+}
+
+// Generators leave exactly one opening in the border of the maze
+static DirectX::XMINT2 FindExit(const MazeGrid& grid, const TileCoordinates& start)
+{
+    const TileType* tiles = grid.GetTiles();
+    uint32_t rows = grid.GetRows(), cols = grid.GetCols();
+    for (uint32_t i = 0; i < rows; ++i)
+    {
+        for (uint32_t j = 0; j < cols; ++j)
+        {
+            bool border = i == 0 || j == 0 || i == rows - 1 || j == cols - 1;
+            bool isStart = (int32_t)i == start.y && (int32_t)j == start.x;
+            if (border && !isStart && tiles[(std::size_t)i * cols + j] != TileType::Wall)
+            {
+                return { (int32_t)j, (int32_t)i };
+            }
+        }
+    }
+    return { -1, -1 };
+}
+
+bool Maze::BuildLayout(const MazeInitializationInfo& info, Layout& layout)
 {
-    CHECK(info.rows >= 3 && info.cols >= 3, std::nullopt,
+    CHECK(!info.endless && info.levelPath.empty(), false, "Only generated mazes have a layout");
+    CHECK(info.rows >= 3 && info.cols >= 3, false,
         "Can't create a maze with {} rows and {} cols. There should be at least 3 rows and at least 3 columns", info.rows, info.cols);
+    CHECK(info.tileWidthDepth >= 1.0f, false,
+        "Can't create a maze with tile size = ({}, {}). Both coordinates should be greater than 1", info.tileWidthDepth, info.tileWidthDepth);
+
+    layout.grid = MazeGrid(info.rows, info.cols, TileType::Wall, MemoryTracker::Get().GetResource(MemoryTag::Maze));
+    TileCoordinates startPosition;
+    if (info.generator == Generator::Regions) {
+        ThreadPool threadPool;
+        startPosition = RegionMazeGenerator::Generate(layout.grid, info.seed, threadPool);
+    } else {
+        std::mt19937 generator(info.seed);
+        startPosition = layout.grid.Lee(generator, GameRules::kEnemyProbability);
+    }
+    SHOWINFO("Done generating maze");
+    layout.start = { startPosition.x, startPosition.y };
+    layout.exit = FindExit(layout.grid, startPosition);
+
+    layout.visibility = MazeVisibility();
+    if (info.visibilityRadius > 0)
+    {
+        CHECKSHOW(BuildVisibility(layout.grid.GetTiles(), layout.grid.GetRows(), layout.grid.GetCols(), info.visibilityRadius,
+            layout.visibility), "Unable to build the visible sets, rendering without them");
+    }
+    return true;
+}
+
+Result<DirectX::XMFLOAT3> Maze::Create(const MazeInitializationInfo& info)
+{
+    if (!info.endless && info.levelPath.empty())
+    {
+        Layout layout;
+        CHECK(BuildLayout(info, layout), std::nullopt, "Unable to generate the maze");
+        return Create(info, std::move(layout));
+    }
+
     CHECK(info.cubeModel != nullptr, std::nullopt, "A valid cube model is expected");
     CHECK(info.enemyModel != nullptr, std::nullopt, "A valid enemy model is expected");
-    CHECK(info.tileWidthDepth >= 1.0f, std::nullopt,
-        "Can't create a maze with tile size = ({}, {}). Both coordinates should be greater than 1", info.tileWidthDepth, info.tileWidthDepth);
-    mTileWidth = info.tileWidthDepth;
-    mTileDepth = info.tileWidthDepth;
-    mTiles.resize(info.rows);
-    for (auto& row : mTiles) {
-        row.resize(info.cols, TileType::Wall);
+    mEnemyModel = info.enemyModel;
+    mSimulationNearRadius = info.simulationNearRadius;
+    mSimulationMidRadius = std::max({ info.simulationMidRadius, info.simulationNearRadius, info.residencyRadius });
+
+    auto result = info.endless ? CreateEndless(info) : LoadLevel(info);
+    CHECK(result.Valid(), std::nullopt, "Unable to create maze tiles");
+
+    if (!info.endless)
+    {
+        MergeWalls();
     }
 
-    auto result = Lee();
+    if (info.visibilityRadius > 0)
+    {
+        if (info.endless)
+        {
+            SHOWINFO("Visible sets are not supported in endless mode, rendering without them");
+        }
+        else
+        {
+            CHECKSHOW(BuildVisibility(mTiles, mRows, mCols, info.visibilityRadius, mVisibility),
+                "Unable to build the visible sets, rendering without them");
+        }
+    }
 
 #if DEBUG || _DEBUG
     PrintMazeToLogger();
 #endif
 
-    mCubeModel = info.cubeModel;
-    AddModelInstances((uint32_t)info.tileWidthDepth, (uint32_t)info.tileWidthDepth, info.enemyModel);
-
     auto& coordinates = result.Get();
 
     return GetPositionFromCoordinates(coordinates);
@@ -31,74 +107,435 @@ Result<DirectX::XMFLOAT3> Maze::Create(const MazeInitializationInfo& info)
 
 void Maze::Update(float dt)
 {
-    mEnemies.erase(std::remove_if(mEnemies.begin(), mEnemies.end(),
-        [&](Enemy& enemy)
+    mSimulationTime += dt;
+    // Enemies only change level when the player changes chunk, so most ticks don't look at the far ones at all
+    if (!mSchedulesAreValid || mScheduledFocusChunk.x != mSimulationFocusChunk.x || mScheduledFocusChunk.y != mSimulationFocusChunk.y)
+    {
+        ScheduleEnemies();
+    }
+
+    mNumSimulatedEnemies = 0;
+    mTimers.Advance(mSimulationTime);
+}
+
+void __vectorcall Maze::UpdateStreaming(const DirectX::XMVECTOR& focusPosition)
+{
+    DirectX::XMFLOAT3 position;
+    DirectX::XMStoreFloat3(&position, focusPosition);
+    auto focusTile = GetCoordinatesFromPosition(position);
+    mSimulationFocusChunk = GameRules::GetChunk({ focusTile.x, focusTile.y });
+
+    if (!mChunkModels.empty())
+    {
+        return;
+    }
+    if (!mEndless)
+    {
+        UpdateResidency(GetCoordinatesFromPosition(position));
+        return;
+    }
+
+    auto focusRow = (uint64_t)std::max(GetCoordinatesFromPosition(position).y, 0);
+
+    // Rows behind the last checkpoint the player crossed are never needed again
+    auto lastCheckpointRow = EllerMazeGenerator::GetLastCheckpointRow(focusRow);
+    while (mNextRow < focusRow + mRows / 2)
+    {
+        if (mNextRow - mFirstRow == mRows)
         {
-            enemy.Update(dt);
-            return enemy.ShouldDie();
-        }), mEnemies.end());
+            if (mFirstRow >= lastCheckpointRow)
+            {
+                break;
+            }
+            EvictRow();
+        }
+        StreamRow();
+    }
 }
 
-void Maze::Render()
+void Maze::Render(FrustumCuller& culler)
 {
-    for (const auto instance : mTileInstances)
+    mNumOccludedInstances = 0;
+    for (std::size_t chunk = 0; chunk < mChunkBounds.size(); ++chunk)
     {
-        mCubeModel->AddCurrentInstance(instance);
+        auto chunkX = (uint32_t)(chunk % mNumChunksX), chunkY = (uint32_t)(chunk / mNumChunksX);
+        if (mHasVisibleSet && !mVisibleSet.Overlaps(chunkY * kChunkSize, chunkX * kChunkSize,
+            (chunkY + 1) * kChunkSize - 1, (chunkX + 1) * kChunkSize - 1))
+        {
+            continue;
+        }
+        auto* models = &mChunkModels[chunk * ChunkMesher::kNumParts];
+        auto numParts = (uint32_t)std::count_if(models, models + ChunkMesher::kNumParts, [](Model* model) { return model != nullptr; });
+        if (culler.ClassifyChunk(mChunkBounds[chunk], numParts) == DirectX::DISJOINT)
+        {
+            continue;
+        }
+        for (uint32_t part = 0; part < ChunkMesher::kNumParts; ++part)
+        {
+            if (models[part])
+            {
+                models[part]->AddCurrentInstance(mChunkModelInstances[chunk * ChunkMesher::kNumParts + part]);
+            }
+        }
     }
-    for (auto& enemy : mEnemies)
+    if (!mTileInstances.empty())
     {
-        enemy.Render();
+        RenderVisibleInstances(culler, mTileInstances.data(), mTileBoxes.data(), (uint32_t)mTileInstances.size(), nullptr);
+    }
+    for (const auto& chunk : mResidentChunks)
+    {
+        const auto* instances = &mSlotInstances[(std::size_t)chunk.slot * kChunkTiles];
+        if (mHasVisibleSet && !mVisibleSet.Overlaps(chunk.chunkY * kChunkSize, chunk.chunkX * kChunkSize,
+            (chunk.chunkY + 1) * kChunkSize - 1, (chunk.chunkX + 1) * kChunkSize - 1))
+        {
+            mNumOccludedInstances += chunk.numTiles;
+            continue;
+        }
+        switch (culler.ClassifyChunk(chunk.bounds, chunk.numTiles))
+        {
+        case DirectX::DISJOINT:
+            break;
+        case DirectX::CONTAINS:
+            for (uint32_t i = 0; i < chunk.numTiles; ++i)
+            {
+                if (IsChunkTileVisible(chunk, i))
+                {
+                    mCubeModel->AddCurrentInstance(instances[i]);
+                }
+            }
+            break;
+        default:
+            RenderVisibleInstances(culler, instances, &mSlotBoxes[(std::size_t)chunk.slot * kChunkTiles], chunk.numTiles, &chunk);
+            break;
+        }
+    }
+
+    auto& frameArena = FrameArena::Get();
+    auto* matrices = frameArena.AllocateArray<DirectX::XMFLOAT4X4>(mEnemies.size());
+    auto* enemyBoxes = frameArena.AllocateArray<DirectX::BoundingBox>(mEnemies.size());
+    auto* visibleIndices = frameArena.AllocateArray<uint32_t>(mEnemies.size());
+    for (std::size_t i = 0; i < mEnemies.size(); ++i)
+    {
+        mEnemies[i].GetWorldMatrix(matrices[i], (float)mSimulationTime);
+    }
+    BoxTransform::Transform(mEnemyModel->GetBoundingBox(), matrices, enemyBoxes, mEnemies.size());
+    auto numVisibleEnemies = culler.CullBoxes(enemyBoxes, (uint32_t)mEnemies.size(), visibleIndices);
+    for (uint32_t i = 0; i < numVisibleEnemies; ++i)
+    {
+        auto& enemy = mEnemies[visibleIndices[i]];
+        // Not simulated, so not where it would be
+        if (GetSimulationLevel(visibleIndices[i]) == SimulationLevel::Far)
+        {
+            continue;
+        }
+        if (mHasVisibleSet)
+        {
+            const auto& center = enemyBoxes[visibleIndices[i]].Center;
+            auto tile = GetCoordinatesFromPosition(center);
+            if (!mVisibleSet.Contains(tile.y, tile.x))
+            {
+                mNumOccludedInstances++;
+                continue;
+            }
+        }
+        enemy.Render(matrices[visibleIndices[i]]);
     }
 }
 
-void Maze::RenderDebug(BatchRenderer& batchRenderer)
+void Maze::RenderVisibleInstances(FrustumCuller& culler, const uint32_t* instances, const DirectX::BoundingBox* boxes, uint32_t count,
+    const ResidentChunk* chunk)
 {
-    const auto& boundingBox = mCubeModel->GetBoundingBox();
-    for (const auto instance : mTileInstances)
+    // Freed right away, so every chunk reuses the same indices
+    auto& frameArena = FrameArena::Get();
+    auto* visibleIndices = frameArena.AllocateArray<uint32_t>(count);
+    auto numVisible = culler.CullBoxes(boxes, count, visibleIndices);
+    for (uint32_t i = 0; i < numVisible; ++i)
+    {
+        if (chunk && !IsChunkTileVisible(*chunk, visibleIndices[i]))
+        {
+            continue;
+        }
+        mCubeModel->AddCurrentInstance(instances[visibleIndices[i]]);
+    }
+    frameArena.deallocate(visibleIndices, count * sizeof(uint32_t), alignof(uint32_t));
+}
+
+bool Maze::IsChunkTileVisible(const ResidentChunk& chunk, uint32_t index)
+{
+    if (!mHasVisibleSet)
+    {
+        return true;
+    }
+    // Chunk instances are laid out row by row, see MakeChunkResident
+    uint32_t chunkWidth = std::min(kChunkSize, mCols - chunk.chunkX * kChunkSize);
+    int32_t row = (int32_t)(chunk.chunkY * kChunkSize + index / chunkWidth);
+    int32_t col = (int32_t)(chunk.chunkX * kChunkSize + index % chunkWidth);
+    if (mVisibleSet.Contains(row, col))
     {
-        const auto& instanceInfo = mCubeModel->GetInstanceInfo(instance);
+        return true;
+    }
+    mNumOccludedInstances++;
+    return false;
+}
 
-        DirectX::BoundingBox box;
-        boundingBox.Transform(box, instanceInfo.WorldMatrix);
+void Maze::RenderDebug(BatchRenderer& batchRenderer)
+{
+    for (const auto& box : mTileBoxes)
+    {
         batchRenderer.BoundingBox(box, DirectX::XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f));
     }
+    // Only the merged walls of the resident chunks, since those are the ones collisions are tested against
+    for (const auto& chunk : mResidentChunks)
+    {
+        auto chunkIndex = (std::size_t)chunk.chunkY * mNumChunksX + chunk.chunkX;
+        for (uint32_t i = mChunkWallBoxes[chunkIndex]; i < mChunkWallBoxes[chunkIndex + 1]; ++i)
+        {
+            batchRenderer.BoundingBox(mWallBoxes[i], DirectX::XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f));
+        }
+    }
+}
+
+void __vectorcall Maze::UpdateVisibility(const DirectX::XMVECTOR& viewPosition)
+{
+    if (!mVisibility.IsBuilt())
+    {
+        return;
+    }
+    DirectX::XMFLOAT3 position;
+    DirectX::XMStoreFloat3(&position, viewPosition);
+    auto tile = GetCoordinatesFromPosition(position);
+    if (tile.x == mVisibleSetTile.x && tile.y == mVisibleSetTile.y)
+    {
+        return;
+    }
+    mVisibleSetTile = tile;
+    // Walls and the outside of the maze have no set, so everything is rendered from there
+    mHasVisibleSet = mVisibility.Decode(tile.y, tile.x, mVisibleSet);
+}
+
+void Maze::DisableVisibility()
+{
+    mHasVisibleSet = false;
+    mVisibleSetTile = { -1, -1 };
+}
+
+DirectX::XMINT2 Maze::GetExitCoordinates() const
+{
+    return mExit;
+}
+
+uint32_t Maze::GetNumSimulatedEnemies() const
+{
+    return mNumSimulatedEnemies;
+}
+
+double Maze::GetSimulationTime() const
+{
+    return mSimulationTime;
+}
+
+uint32_t Maze::GetNumOccludedInstances() const
+{
+    return mNumOccludedInstances;
+}
+
+void Maze::Observe(const DirectX::XMFLOAT3& playerPosition, AgentObservation& observation) const
+{
+    auto playerTile = GetCoordinatesFromPosition(playerPosition);
+    observation.PlayerX = playerPosition.x;
+    observation.PlayerZ = playerPosition.z;
+    observation.PlayerRow = playerTile.y;
+    observation.PlayerCol = playerTile.x;
+
+    for (int32_t i = 0; i < (int32_t)kObservationWidth; ++i)
+    {
+        int64_t row = (int64_t)playerTile.y + i - kObservationRadius;
+        // World rows in endless mode, only the ones still in the ring exist
+        bool rowExists = mEndless ? row >= (int64_t)mFirstRow && row < (int64_t)mNextRow : row >= 0 && row < (int64_t)mRows;
+        for (int32_t j = 0; j < (int32_t)kObservationWidth; ++j)
+        {
+            int64_t col = (int64_t)playerTile.x + j - kObservationRadius;
+            auto& tile = observation.Tiles[i * kObservationWidth + j];
+            if (!rowExists || col < 0 || col >= (int64_t)mCols)
+            {
+                tile = kObservedOutside;
+                continue;
+            }
+            tile = (uint8_t)GetTile((uint32_t)(mEndless ? row % mRows : row), (uint32_t)col);
+        }
+    }
+
+    observation.NumEnemies = 0;
+    for (const auto& enemy : mEnemies)
+    {
+        if (enemy.IsDying())
+        {
+            continue;
+        }
+        auto box = enemy.GetBoundingBox((float)mSimulationTime);
+        AgentChannel::AddEnemy(observation, box.Center.x, box.Center.z);
+    }
+}
+
+void Maze::Spectate(SpectatorFrame& frame) const
+{
+    DirectX::XMFLOAT4X4 worldMatrix;
+    for (const auto& enemy : mEnemies)
+    {
+        // Enemies are only ever translated
+        enemy.GetWorldMatrix(worldMatrix, (float)mSimulationTime);
+        frame.Entities.push_back({ SpectatorEntity::MakeId(SpectatorEntityKind::Enemy, enemy.GetInstanceID()),
+            enemy.IsDying() ? 1u : 0u, worldMatrix.m[3][0], worldMatrix.m[3][1], worldMatrix.m[3][2], 0.0f });
+    }
+}
+
+void Maze::PlaceTorches(uint32_t spacing, std::vector<PointLight>& torches) const
+{
+    if (mEndless || spacing == 0)
+    {
+        return;
+    }
+    constexpr int32_t dirY[] = { -1, 1, 0, 0 };
+    constexpr int32_t dirX[] = { 0, 0, -1, 1 };
+
+    // Hung at three quarters of the wall's height
+    auto wallBox = GetTileBoundingBox(MazeGrid::BuildTileInstance(TileType::Wall, 0, 0, mRows, mCols, mTileWidth));
+    float height = wallBox.Center.y + wallBox.Extents.y * 0.5f;
+
+    for (uint32_t i = 0; i < mRows; ++i)
+    {
+        for (uint32_t j = 0; j < mCols; ++j)
+        {
+            // Hashing the coordinates spreads the torches evenly without keeping any state between tiles
+            uint32_t hash = (i * 73856093u) ^ (j * 19349663u);
+            if (GetTile(i, j) == TileType::Wall || hash % spacing != 0)
+            {
+                continue;
+            }
+            for (uint32_t direction = 0; direction < std::size(dirY); ++direction)
+            {
+                if (!IsWall((int64_t)i + dirY[direction], (int64_t)j + dirX[direction]))
+                {
+                    continue;
+                }
+                auto position = GetPositionFromCoordinates({ (int32_t)j, (int32_t)i });
+                PointLight torch = {};
+                torch.Position[0] = position.x + dirX[direction] * mTileWidth * 0.4f;
+                torch.Position[1] = height;
+                torch.Position[2] = position.z + dirY[direction] * mTileDepth * 0.4f;
+                torch.Strength[0] = 1.0f;
+                torch.Strength[1] = 0.6f;
+                torch.Strength[2] = 0.25f;
+                torch.FalloffStart = mTileWidth * 0.5f;
+                torch.FalloffEnd = mTileWidth * 2.5f;
+                torches.push_back(torch);
+                break;
+            }
+        }
+    }
 }
 
 DirectX::XMFLOAT3 Maze::GetPositionFromCoordinates(const DirectX::XMINT2& coordinates) const
 {
     DirectX::XMFLOAT3 finalPosition;
-    finalPosition.x = ((float)coordinates.x - (float)mTiles[0].size() / 2.0f) * mTileWidth;
-    finalPosition.z = ((float)coordinates.y - (float)mTiles.size() / 2.0f) * mTileDepth;
+    finalPosition.x = ((float)coordinates.x - (float)mCols / 2.0f) * mTileWidth;
+    finalPosition.z = ((float)coordinates.y - (float)mRows / 2.0f) * mTileDepth;
     finalPosition.y = 0.0f;
     return finalPosition;
 }
 
+DirectX::XMINT2 Maze::GetCoordinatesFromPosition(const DirectX::XMFLOAT3& position) const
+{
+    DirectX::XMINT2 coordinates;
+    coordinates.x = (int32_t)std::floor(position.x / mTileWidth + (float)mCols / 2.0f + 0.5f);
+    coordinates.y = (int32_t)std::floor(position.z / mTileDepth + (float)mRows / 2.0f + 0.5f);
+    return coordinates;
+}
+
 bool Maze::BoundingBoxCollidesWithWalls(const DirectX::BoundingBox& boundingBox) const
 {
     bool result = false;
-    for (const auto wallInstanceID : mWallInstances)
+    if (mEndless)
     {
-        auto& wallInstance = mCubeModel->GetInstanceInfo(wallInstanceID);
-        auto& wallBoundingBox = mCubeModel->GetBoundingBox();
-        DirectX::BoundingBox currentBoundingBox;
-        wallBoundingBox.Transform(currentBoundingBox, wallInstance.WorldMatrix);
+        // Evicted rows are gone, so there is an invisible wall behind the oldest row
+        float backWall = ((float)mFirstRow - (float)mRows / 2.0f - 0.5f) * mTileDepth;
+        if (boundingBox.Center.z - boundingBox.Extents.z < backWall)
+        {
+            return true;
+        }
+    }
 
-        if (boundingBox.Intersects(currentBoundingBox))
+    // Walls never reach past their tile, so only the tiles under the box (plus one for rounding) can touch it
+    auto minTile = GetCoordinatesFromPosition({ boundingBox.Center.x - boundingBox.Extents.x, 0.0f, boundingBox.Center.z - boundingBox.Extents.z });
+    auto maxTile = GetCoordinatesFromPosition({ boundingBox.Center.x + boundingBox.Extents.x, 0.0f, boundingBox.Center.z + boundingBox.Extents.z });
+    if (!mChunkWallBoxes.empty())
+    {
+        int32_t firstChunkX = Math::clamp(minTile.x - 1, 0, (int32_t)mCols - 1) / (int32_t)kChunkSize;
+        int32_t lastChunkX = Math::clamp(maxTile.x + 1, 0, (int32_t)mCols - 1) / (int32_t)kChunkSize;
+        int32_t firstChunkY = Math::clamp(minTile.y - 1, 0, (int32_t)mRows - 1) / (int32_t)kChunkSize;
+        int32_t lastChunkY = Math::clamp(maxTile.y + 1, 0, (int32_t)mRows - 1) / (int32_t)kChunkSize;
+        for (int32_t chunkY = firstChunkY; chunkY <= lastChunkY; ++chunkY)
         {
-            result = true;
-            break;
+            for (int32_t chunkX = firstChunkX; chunkX <= lastChunkX; ++chunkX)
+            {
+                auto chunkIndex = (std::size_t)chunkY * mNumChunksX + chunkX;
+                for (uint32_t i = mChunkWallBoxes[chunkIndex]; i < mChunkWallBoxes[chunkIndex + 1]; ++i)
+                {
+                    if (boundingBox.Intersects(mWallBoxes[i]))
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    for (int64_t row = (int64_t)minTile.y - 1; row <= (int64_t)maxTile.y + 1 && !result; ++row)
+    {
+        for (int64_t col = (int64_t)minTile.x - 1; col <= (int64_t)maxTile.x + 1; ++col)
+        {
+            if (!IsWall(row, col))
+            {
+                continue;
+            }
+            auto wallInstance = MazeGrid::BuildTileInstance(TileType::Wall, (uint32_t)row, (uint32_t)col, mRows, mCols, mTileWidth);
+            if (boundingBox.Intersects(GetTileBoundingBox(wallInstance)))
+            {
+                result = true;
+                break;
+            }
         }
     }
     return result;
 }
 
+DirectX::XMVECTOR __vectorcall Maze::MoveCapsule(const DirectX::XMVECTOR& position, float radius, const DirectX::XMVECTOR& displacement) const
+{
+    const auto& cubeBox = mCubeModel->GetBoundingBox();
+    float boxMin[3] = { cubeBox.Center.x - cubeBox.Extents.x, cubeBox.Center.y - cubeBox.Extents.y, cubeBox.Center.z - cubeBox.Extents.z };
+    float boxMax[3] = { cubeBox.Center.x + cubeBox.Extents.x, cubeBox.Center.y + cubeBox.Extents.y, cubeBox.Center.z + cubeBox.Extents.z };
+    auto layout = GameRules::GetWallLayout(mRows, mCols, mTileWidth, boxMin, boxMax);
+
+    float x = DirectX::XMVectorGetX(position), z = DirectX::XMVectorGetZ(position);
+    GridCollision::MoveCircle(layout, [this](int64_t row, int64_t col) { return IsWall(row, col); },
+        x, z, radius, DirectX::XMVectorGetX(displacement), DirectX::XMVectorGetZ(displacement));
+    if (mEndless)
+    {
+        // Evicted rows are gone, so there is an invisible wall behind the oldest row
+        float backWall = ((float)mFirstRow - (float)mRows / 2.0f - 0.5f) * mTileDepth;
+        z = std::max(z, backWall + radius);
+    }
+    return DirectX::XMVectorSet(x, DirectX::XMVectorGetY(position), z, 1.0f);
+}
+
 bool Maze::BoundingBoxCollidesWithEnemy(const DirectX::BoundingBox& boundingBox) const
 {
     bool result = false;
 
-    for (const auto& enemy : mEnemies)
+    for (uint32_t i = 0; i < (uint32_t)mEnemies.size(); ++i)
     {
-        if (enemy.CollisionWithBoundingBox(boundingBox))
+        if (GetSimulationLevel(i) != SimulationLevel::Far && mEnemies[i].CollisionWithBoundingBox(boundingBox, (float)mSimulationTime))
         {
             result = true;
             break;
@@ -111,175 +548,662 @@ bool Maze::BoundingBoxCollidesWithEnemy(const DirectX::BoundingBox& boundingBox)
 bool Maze::HandleCollisionBetweenBoundingBoxAndEnemies(const DirectX::BoundingBox& boundingBox)
 {
     uint32_t numCollisions = 0;
-    for (auto& enemy : mEnemies)
+    for (uint32_t i = 0; i < (uint32_t)mEnemies.size(); ++i)
     {
-        if (enemy.CollisionWithBoundingBox(boundingBox))
+        auto& enemy = mEnemies[i];
+        if (GetSimulationLevel(i) != SimulationLevel::Far && enemy.CollisionWithBoundingBox(boundingBox, (float)mSimulationTime))
         {
             numCollisions++;
-            enemy.Die();
+            enemy.Die((float)mSimulationTime);
+            // Dying takes the same time wherever the enemy is, whatever patrol it missed doesn't matter anymore
+            enemy.SetUpdateTime(mSimulationTime);
+            if (mSchedulesAreValid)
+            {
+                Unschedule(i);
+                Schedule(i);
+            }
         }
     }
     return numCollisions > 0;
 }
 
-Result<DirectX::XMINT2> Maze::Lee()
+Result<DirectX::XMFLOAT3> Maze::Create(const MazeInitializationInfo& info, Layout&& layout)
 {
-    DirectX::XMINT2 startPosition = {
-        (int32_t)mTiles[0].size() / 2,
-        (int32_t)mTiles.size() / 2,
-    };
-    std::vector<decltype(startPosition)> st;
-    st.push_back(startPosition);
+    CHECK(info.cubeModel != nullptr, std::nullopt, "A valid cube model is expected");
+    CHECK(info.enemyModel != nullptr, std::nullopt, "A valid enemy model is expected");
+    CHECK(!mEndless && mChunkModels.empty(), std::nullopt, "Endless mazes and mazes with baked meshes can't be replaced");
+    CHECK(layout.grid.GetRows() == info.rows && layout.grid.GetCols() == info.cols, std::nullopt,
+        "The layout was built with other settings");
+    mEnemyModel = info.enemyModel;
+    mCubeModel = info.cubeModel;
+    mSimulationNearRadius = info.simulationNearRadius;
+    mSimulationMidRadius = std::max({ info.simulationMidRadius, info.simulationNearRadius, info.residencyRadius });
+    mTileWidth = info.tileWidthDepth;
+    mTileDepth = info.tileWidthDepth;
 
-    std::unordered_set<std::pair<uint32_t, uint32_t>, PairHash> visitedTiles;
-    visitedTiles.insert({ startPosition.y, startPosition.x });
-    bool foundExit = false;
+    mGrid = std::move(layout.grid);
+    mTiles = mGrid.GetTiles();
+    mRows = mGrid.GetRows();
+    mCols = mGrid.GetCols();
+    mPrecomputedInstances = nullptr;
+    mExit = layout.exit;
 
-    while (!st.empty()) {
-        auto currentPositionIndex = Random::get((size_t)0, st.size() - 1);
-        auto currentPosition = st[currentPositionIndex];
-        st.erase(st.begin() + currentPositionIndex);
+    CHECK(CreateChunkSlots(info.residencyRadius), std::nullopt, "Unable to create tile instances");
+    UpdateResidency(layout.start);
+    auto enemySpawns = mGrid.GetEnemySpawns();
+    SpawnEnemies(enemySpawns.data(), enemySpawns.size(), info.enemyModel);
+    MergeWalls();
 
-        if (currentPosition.x == 0 || currentPosition.y == 0 || currentPosition.x == (mTiles[0].size() - 1) || currentPosition.y == (mTiles.size() - 1)) {
-            mTiles[currentPosition.y][currentPosition.x] = TileType::Free;
-            foundExit = true;
-            break;
+    mVisibility = std::move(layout.visibility);
+    mHasVisibleSet = false;
+    mVisibleSetTile = { -1, -1 };
+    mSimulationFocusChunk = { -1, -1 };
+
+#if DEBUG || _DEBUG
+    PrintMazeToLogger();
+#endif
+
+    return GetPositionFromCoordinates(layout.start);
+}
+
+Result<DirectX::XMINT2> Maze::LoadLevel(const MazeInitializationInfo& info)
+{
+    CHECK(mLevelFile.Open(info.levelPath), std::nullopt, "Unable to open maze level {}", info.levelPath);
+    const auto& header = mLevelFile.GetHeader();
+    CHECK(header.TileWidthDepth >= 1.0f, std::nullopt,
+        "Maze level {} has an invalid tile size = {}", info.levelPath, header.TileWidthDepth);
+
+    mTileWidth = header.TileWidthDepth;
+    mTileDepth = header.TileWidthDepth;
+    mCubeModel = info.cubeModel;
+
+    mTiles = mLevelFile.GetTiles();
+    mRows = header.Rows;
+    mCols = header.Cols;
+
+    if (!info.chunkModels.empty())
+    {
+        CHECK(UseChunkModels(info.chunkModels), std::nullopt, "Unable to use the baked chunk meshes of {}", info.levelPath);
+    }
+    else
+    {
+        mPrecomputedInstances = mLevelFile.GetTileInstances();
+        CHECK(CreateChunkSlots(info.residencyRadius), std::nullopt, "Unable to create tile instances");
+        UpdateResidency({ header.StartX, header.StartY });
+    }
+    SpawnEnemies(mLevelFile.GetEnemySpawns(), (std::size_t)header.NumEnemies, info.enemyModel);
+
+    SHOWINFO("Loaded maze level {} with {} rows and {} cols", info.levelPath, mRows, mCols);
+
+    return DirectX::XMINT2{ header.StartX, header.StartY };
+}
+
+Result<DirectX::XMINT2> Maze::CreateEndless(const MazeInitializationInfo& info)
+{
+    // The ring must be able to hold the rows between two checkpoints behind the player plus the rows ahead
+    constexpr uint32_t minimumRows = 8 * EllerMazeGenerator::kCheckpointInterval;
+    CHECK(info.rows >= minimumRows && info.cols >= 3, std::nullopt,
+        "Can't create an endless maze with {} rows and {} cols. There should be at least {} rows and at least 3 columns",
+        info.rows, info.cols, minimumRows);
+    CHECK(info.tileWidthDepth >= 1.0f, std::nullopt,
+        "Can't create a maze with tile size = ({}, {}). Both coordinates should be greater than 1", info.tileWidthDepth, info.tileWidthDepth);
+    mTileWidth = info.tileWidthDepth;
+    mTileDepth = info.tileWidthDepth;
+    mCubeModel = info.cubeModel;
+    mEndless = true;
+
+    mGrid = MazeGrid(info.rows, info.cols, TileType::Wall, MemoryTracker::Get().GetResource(MemoryTag::Maze));
+    mTiles = mGrid.GetTiles();
+    mRows = mGrid.GetRows();
+    mCols = mGrid.GetCols();
+
+    // Every instance and enemy is created once here and recycled from then on
+    AddModelInstances();
+    CHECK(mTileInstances.size() == (std::size_t)mRows * mCols, std::nullopt, "Unable to create the endless maze tiles");
+
+    auto maximumEnemies = (std::size_t)mRows * mCols / 4;
+    mEnemies.reserve(maximumEnemies);
+    mEnemyPool.reserve(maximumEnemies);
+    for (std::size_t i = 0; i < maximumEnemies; ++i)
+    {
+        mEnemyPool.emplace_back();
+        CHECK(mEnemyPool.back().Create(info.enemyModel, GetPositionFromCoordinates({ 0, 0 }), mTileWidth), std::nullopt,
+            "Cannot create pooled enemy");
+    }
+
+    mStreamGenerator.Create(mCols, info.seed);
+    mFirstRow = 0;
+    mNextRow = 0;
+    while (mNextRow < mRows)
+    {
+        StreamRow();
+    }
+
+    // The first cell row is a checkpoint, so the start is connected to everything after it
+    return DirectX::XMINT2{ 2 * (int32_t)((mCols - 1) / 4) + 1, 1 };
+}
+
+void Maze::StreamRow()
+{
+    auto ringRow = (uint32_t)(mNextRow % mRows);
+    TileType* row = mGrid.GetTiles() + (std::size_t)ringRow * mCols;
+    mStreamGenerator.NextRow(row);
+    UpdateRingRowInstances(mNextRow);
+
+    for (uint32_t j = 0; j < mCols; ++j)
+    {
+        if (row[j] == TileType::Enemy)
+        {
+            ASYNC_CHECKCONT(!mEnemyPool.empty(), "Enemy pool is empty, skipping enemy on coordinates = ({}, {})", j, mNextRow);
+            mEnemyPool.back().Respawn(GetPositionFromCoordinates({ (int32_t)j, (int32_t)mNextRow }));
+            mEnemyPool.back().SetUpdateTime(mSimulationTime);
+            mEnemies.push_back(mEnemyPool.back());
+            mEnemyPool.pop_back();
+            mSchedulesAreValid = false;
         }
+    }
+    mNextRow++;
+}
+
+void Maze::UpdateRingRowInstances(uint64_t worldRow)
+{
+    auto ringRow = (uint32_t)(worldRow % mRows);
+    const TileType* row = mGrid.GetTiles() + (std::size_t)ringRow * mCols;
+    auto& frameArena = FrameArena::Get();
+    auto* matrices = frameArena.AllocateArray<DirectX::XMFLOAT4X4>(mCols);
+    for (uint32_t j = 0; j < mCols; ++j)
+    {
+        auto tileInstance = MazeGrid::BuildTileInstance(row[j], (uint32_t)worldRow, j, mRows, mCols, mTileWidth);
+        CopyTileInstance(tileInstance, mCubeModel->GetInstanceInfo(mTileInstances[(std::size_t)ringRow * mCols + j]));
+        memcpy(&matrices[j], tileInstance.WorldMatrix, sizeof(tileInstance.WorldMatrix));
+    }
+    BoxTransform::Transform(mCubeModel->GetBoundingBox(), matrices, &mTileBoxes[(std::size_t)ringRow * mCols], mCols);
+    frameArena.deallocate(matrices, mCols * sizeof(DirectX::XMFLOAT4X4), alignof(DirectX::XMFLOAT4X4));
+}
 
-        auto neighbours = GetNeighbours(currentPosition, visitedTiles);
-        unsigned int freeTiles = 0;
-        std::vector<DirectX::XMINT2> availableNeighbours;
-        for (const auto& neighbour : neighbours) {
-            const auto tile = mTiles[neighbour.y][neighbour.x];
-            if (tile == TileType::Free) {
-                freeTiles++;
-            } else if (tile == TileType::Wall) {
-                availableNeighbours.push_back(neighbour);
+void Maze::SaveState(WorldSnapshot& snapshot) const
+{
+    StateHeader header = { mRows, mCols, mEndless ? 1u : 0u, (uint32_t)(mEnemies.size() + mEnemyPool.size()), mFirstRow, mNextRow,
+        mSimulationTime };
+    snapshot.Write(header);
+
+    auto* enemies = snapshot.Allocate<Enemy::State>(mEnemies.size());
+    for (std::size_t i = 0; i < mEnemies.size(); ++i)
+    {
+        mEnemies[i].SaveState(enemies[i]);
+    }
+    auto* pooledEnemies = snapshot.Allocate<Enemy::State>(mEnemyPool.size());
+    for (std::size_t i = 0; i < mEnemyPool.size(); ++i)
+    {
+        mEnemyPool[i].SaveState(pooledEnemies[i]);
+    }
+
+    // Fixed mazes never change their tiles
+    if (mEndless)
+    {
+        snapshot.Write(mGrid.GetTiles(), (std::size_t)mRows * mCols);
+        mStreamGenerator.SaveState(snapshot);
+    }
+}
+
+bool Maze::LoadState(WorldSnapshot::Reader& reader)
+{
+    StateHeader header;
+    CHECK(reader.Read(header) && header.Rows == mRows && header.Cols == mCols && (header.Endless != 0) == mEndless &&
+        header.NumEnemies == mEnemies.size() + mEnemyPool.size(), false, "Snapshot was taken in another maze");
+
+    std::size_t numEnemies, numPooledEnemies;
+    const auto* enemies = reader.Read<Enemy::State>(numEnemies);
+    const auto* pooledEnemies = reader.Read<Enemy::State>(numPooledEnemies);
+    CHECK(enemies && pooledEnemies && numEnemies + numPooledEnemies == header.NumEnemies, false, "Snapshot has no enemies");
+    CHECK(std::all_of(enemies, enemies + numEnemies, Enemy::IsValidState) &&
+        std::all_of(pooledEnemies, pooledEnemies + numPooledEnemies, Enemy::IsValidState), false,
+        "Snapshot has enemies with unknown behaviours");
+    // Every section is read before anything changes, the endless maze generator is the only one loaded in place
+    const TileType* tiles = nullptr;
+    if (mEndless)
+    {
+        std::size_t numTiles;
+        tiles = reader.Read<TileType>(numTiles);
+        CHECK(tiles && numTiles == (std::size_t)mRows * mCols, false, "Snapshot has no endless rows");
+        CHECK(mStreamGenerator.LoadState(reader), false, "Snapshot has no endless maze generator");
+    }
+
+    mEnemies.resize(numEnemies);
+    for (std::size_t i = 0; i < numEnemies; ++i)
+    {
+        mEnemies[i].LoadState(enemies[i], mEnemyModel);
+    }
+    mEnemyPool.resize(numPooledEnemies);
+    for (std::size_t i = 0; i < numPooledEnemies; ++i)
+    {
+        mEnemyPool[i].LoadState(pooledEnemies[i], mEnemyModel);
+    }
+    mSimulationTime = header.SimulationTime;
+    // The timers were set for another time, the enemies get new ones on the next Update
+    mTimers.Reset(mSimulationTime);
+    mSchedulesAreValid = false;
+
+    if (mEndless)
+    {
+        std::copy(tiles, tiles + (std::size_t)mRows * mCols, mGrid.GetTiles());
+        mFirstRow = header.FirstRow;
+        mNextRow = header.NextRow;
+        for (auto row = mFirstRow; row < mNextRow; ++row)
+        {
+            UpdateRingRowInstances(row);
+        }
+    }
+    return true;
+}
+
+void Maze::EvictRow()
+{
+    auto firstEvictedEnemy = std::partition(mEnemies.begin(), mEnemies.end(),
+        [&](const Enemy& enemy)
+        {
+            return (uint64_t)GetCoordinatesFromPosition(enemy.GetInitialPosition()).y != mFirstRow;
+        });
+    mEnemyPool.insert(mEnemyPool.end(), firstEvictedEnemy, mEnemies.end());
+    mEnemies.erase(firstEvictedEnemy, mEnemies.end());
+    mSchedulesAreValid = false;
+    mFirstRow++;
+}
+
+bool Maze::CreateChunkSlots(uint32_t residencyRadius)
+{
+    mResidencyRadius = residencyRadius;
+    mNumChunksX = (mCols + kChunkSize - 1) / kChunkSize;
+    mNumChunksY = (mRows + kChunkSize - 1) / kChunkSize;
+    mChunkIsResident.assign((std::size_t)mNumChunksX * mNumChunksY, 0);
+
+    // Everything is allocated up front, so the number of instances only depends on the radius. A maze created again
+    // keeps the instances it already has
+    uint32_t chunksAcross = 2 * residencyRadius + 1;
+    uint32_t numSlots = std::min(chunksAcross, mNumChunksX) * std::min(chunksAcross, mNumChunksY);
+    mSlotInstances.reserve((std::size_t)numSlots * kChunkTiles);
+    mSlotBoxes.resize((std::size_t)numSlots * kChunkTiles);
+    while (mSlotInstances.size() < (std::size_t)numSlots * kChunkTiles)
+    {
+        auto instanceResult = mCubeModel->AddInstance(InstanceInfo());
+        CHECK(instanceResult.Valid(), false, "Cannot add tile instance");
+        mSlotInstances.push_back(instanceResult.Get());
+    }
+    mFreeSlots.clear();
+    for (uint32_t i = 0; i < numSlots; ++i)
+    {
+        mFreeSlots.push_back(numSlots - i - 1);
+    }
+    mResidentChunks.clear();
+    mResidentChunks.reserve(numSlots);
+    mFocusChunk = { -1, -1 };
+
+    SHOWINFO("Created {} tile instances for {} resident chunks", mSlotInstances.size(), numSlots);
+    return true;
+}
+
+bool Maze::UseChunkModels(const std::vector<Model*>& chunkModels)
+{
+    mNumChunksX = (mCols + kChunkSize - 1) / kChunkSize;
+    mNumChunksY = (mRows + kChunkSize - 1) / kChunkSize;
+    auto numChunks = (std::size_t)mNumChunksX * mNumChunksY;
+    CHECK(chunkModels.size() == numChunks * ChunkMesher::kNumParts, false,
+        "Expected {} chunk meshes, got {}", numChunks * ChunkMesher::kNumParts, chunkModels.size());
+
+    const TileType partTypes[] = { TileType::Wall, TileType::Free, TileType::Enemy };
+    static_assert(std::size(partTypes) == ChunkMesher::kNumParts, "Every chunk mesh part needs a tile type");
+
+    mChunkModels.assign(chunkModels.begin(), chunkModels.end());
+    mChunkModelInstances.assign(chunkModels.size(), 0);
+    mChunkBounds.resize(numChunks);
+    for (std::size_t chunk = 0; chunk < numChunks; ++chunk)
+    {
+        for (uint32_t part = 0; part < ChunkMesher::kNumParts; ++part)
+        {
+            auto index = chunk * ChunkMesher::kNumParts + part;
+            if (!mChunkModels[index])
+            {
+                continue;
             }
+            // The meshes are in world space already
+            auto color = MazeGrid::BuildTileInstance(partTypes[part], 0, 0, mRows, mCols, mTileWidth).Color;
+            InstanceInfo instanceInfo;
+            instanceInfo.WorldMatrix = DirectX::XMMatrixIdentity();
+            instanceInfo.Color = { color[0], color[1], color[2], color[3] };
+            auto instanceResult = mChunkModels[index]->AddInstance(instanceInfo);
+            CHECK(instanceResult.Valid(), false, "Cannot add chunk mesh instance");
+            mChunkModelInstances[index] = instanceResult.Get();
+        }
+
+        // Walls are the tallest tiles and floors the lowest, so their corner tiles bound the chunk
+        auto firstRow = (uint32_t)(chunk / mNumChunksX) * kChunkSize, firstCol = (uint32_t)(chunk % mNumChunksX) * kChunkSize;
+        auto lastRow = std::min(firstRow + kChunkSize, mRows) - 1, lastCol = std::min(firstCol + kChunkSize, mCols) - 1;
+        auto& bounds = mChunkBounds[chunk];
+        bounds = GetTileBoundingBox(MazeGrid::BuildTileInstance(TileType::Wall, firstRow, firstCol, mRows, mCols, mTileWidth));
+        const DirectX::BoundingBox corners[] = {
+            GetTileBoundingBox(MazeGrid::BuildTileInstance(TileType::Wall, lastRow, lastCol, mRows, mCols, mTileWidth)),
+            GetTileBoundingBox(MazeGrid::BuildTileInstance(TileType::Free, firstRow, firstCol, mRows, mCols, mTileWidth)),
+            GetTileBoundingBox(MazeGrid::BuildTileInstance(TileType::Free, lastRow, lastCol, mRows, mCols, mTileWidth)),
+        };
+        for (const auto& corner : corners)
+        {
+            DirectX::BoundingBox::CreateMerged(bounds, bounds, corner);
         }
-        if (freeTiles > 2) {
+    }
+
+    SHOWINFO("Rendering {} chunks with baked meshes", numChunks);
+    return true;
+}
+
+void Maze::UpdateResidency(const DirectX::XMINT2& focusTile)
+{
+    DirectX::XMINT2 focusChunk = {
+        Math::clamp(focusTile.x, 0, (int32_t)mCols - 1) / (int32_t)kChunkSize,
+        Math::clamp(focusTile.y, 0, (int32_t)mRows - 1) / (int32_t)kChunkSize,
+    };
+    if (focusChunk.x == mFocusChunk.x && focusChunk.y == mFocusChunk.y)
+    {
+        return;
+    }
+    mFocusChunk = focusChunk;
+
+    int32_t radius = (int32_t)mResidencyRadius;
+    int32_t firstChunkX = std::max(focusChunk.x - radius, 0);
+    int32_t lastChunkX = std::min(focusChunk.x + radius, (int32_t)mNumChunksX - 1);
+    int32_t firstChunkY = std::max(focusChunk.y - radius, 0);
+    int32_t lastChunkY = std::min(focusChunk.y + radius, (int32_t)mNumChunksY - 1);
+
+    for (std::size_t i = 0; i < mResidentChunks.size();)
+    {
+        const auto& chunk = mResidentChunks[i];
+        if ((int32_t)chunk.chunkX >= firstChunkX && (int32_t)chunk.chunkX <= lastChunkX &&
+            (int32_t)chunk.chunkY >= firstChunkY && (int32_t)chunk.chunkY <= lastChunkY)
+        {
+            ++i;
             continue;
         }
+        mChunkIsResident[(std::size_t)chunk.chunkY * mNumChunksX + chunk.chunkX] = 0;
+        mFreeSlots.push_back(chunk.slot);
+        mResidentChunks[i] = mResidentChunks.back();
+        mResidentChunks.pop_back();
+    }
 
-        if (Random::get(0.0f, 1.0f) <= 0.1f) {
-            mTiles[currentPosition.y][currentPosition.x] = TileType::Enemy;
-        } else {
-            mTiles[currentPosition.y][currentPosition.x] = TileType::Free;
+    for (int32_t chunkY = firstChunkY; chunkY <= lastChunkY; ++chunkY)
+    {
+        for (int32_t chunkX = firstChunkX; chunkX <= lastChunkX; ++chunkX)
+        {
+            if (mChunkIsResident[(std::size_t)chunkY * mNumChunksX + chunkX])
+            {
+                continue;
+            }
+            ASYNC_CHECKCONT(MakeChunkResident((uint32_t)chunkX, (uint32_t)chunkY), "Unable to make chunk ({}, {}) resident", chunkX, chunkY);
         }
+    }
+}
 
-        if (availableNeighbours.size() > 1) {
-            st.push_back(currentPosition);
+bool Maze::MakeChunkResident(uint32_t chunkX, uint32_t chunkY)
+{
+    CHECK(!mFreeSlots.empty(), false, "No free slot for chunk ({}, {})", chunkX, chunkY);
+    ResidentChunk chunk = { chunkX, chunkY, mFreeSlots.back(), 0 };
+    mFreeSlots.pop_back();
+
+    const auto* instances = &mSlotInstances[(std::size_t)chunk.slot * kChunkTiles];
+    auto* boxes = &mSlotBoxes[(std::size_t)chunk.slot * kChunkTiles];
+    // Also called while creating the maze, before the first frame, freeing the matrices keeps the arena from piling them up
+    auto& frameArena = FrameArena::Get();
+    auto* matrices = frameArena.AllocateArray<DirectX::XMFLOAT4X4>(kChunkTiles);
+    uint32_t lastRow = std::min((chunkY + 1) * kChunkSize, mRows);
+    uint32_t lastCol = std::min((chunkX + 1) * kChunkSize, mCols);
+    for (uint32_t i = chunkY * kChunkSize; i < lastRow; ++i)
+    {
+        for (uint32_t j = chunkX * kChunkSize; j < lastCol; ++j)
+        {
+            const auto tileInstance = mPrecomputedInstances ?
+                mPrecomputedInstances[(std::size_t)i * mCols + j] :
+                MazeGrid::BuildTileInstance(GetTile(i, j), i, j, mRows, mCols, mTileWidth);
+            CopyTileInstance(tileInstance, mCubeModel->GetInstanceInfo(instances[chunk.numTiles]));
+            memcpy(&matrices[chunk.numTiles], tileInstance.WorldMatrix, sizeof(tileInstance.WorldMatrix));
+            chunk.numTiles++;
         }
-        for (const auto nextNeighbour : availableNeighbours) {
-            st.push_back(nextNeighbour);
-            visitedTiles.insert({ nextNeighbour.y, nextNeighbour.x });
+    }
+    BoxTransform::Transform(mCubeModel->GetBoundingBox(), matrices, boxes, chunk.numTiles);
+    frameArena.deallocate(matrices, kChunkTiles * sizeof(DirectX::XMFLOAT4X4), alignof(DirectX::XMFLOAT4X4));
+    chunk.bounds = boxes[0];
+    for (uint32_t i = 1; i < chunk.numTiles; ++i)
+    {
+        DirectX::BoundingBox::CreateMerged(chunk.bounds, chunk.bounds, boxes[i]);
+    }
+
+    mChunkIsResident[(std::size_t)chunkY * mNumChunksX + chunkX] = 1;
+    mResidentChunks.push_back(chunk);
+    return true;
+}
+
+bool Maze::IsWall(int64_t row, int64_t col) const
+{
+    if (col < 0 || col >= (int64_t)mCols)
+    {
+        return false;
+    }
+    if (mEndless)
+    {
+        if (row < (int64_t)mFirstRow || row >= (int64_t)mNextRow)
+        {
+            return false;
         }
+        return GetTile((uint32_t)(row % mRows), (uint32_t)col) == TileType::Wall;
+    }
+    if (row < 0 || row >= (int64_t)mRows)
+    {
+        return false;
     }
-    mTiles[startPosition.y][startPosition.x] = TileType::Free;
+    return GetTile((uint32_t)row, (uint32_t)col) == TileType::Wall;
+}
 
-    SHOWINFO("Done generating maze");
+bool Maze::BuildVisibility(const TileType* tiles, uint32_t rows, uint32_t cols, uint32_t radius, MazeVisibility& visibility)
+{
+    CHECK(radius <= MazeVisibility::kMaximumRadius, false,
+        "Visibility radius {} is too big, the maximum is {}", radius, MazeVisibility::kMaximumRadius);
+
+    auto start = std::chrono::steady_clock::now();
+    ThreadPool threadPool;
+    CHECK(visibility.Build(tiles, rows, cols, radius, threadPool), false, "Unable to build the visible sets");
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 
-    return startPosition;
+    SHOWINFO("Built the visible sets of {} tiles in {:.2f} ms on {} threads. They use {:.2f} MB for {} visible pairs",
+        (uint64_t)rows * cols, elapsed, threadPool.GetThreadCount() + 1,
+        (double)visibility.GetMemoryUsage() / (1024.0 * 1024.0), visibility.GetNumVisiblePairs());
+    return true;
 }
 
-void Maze::AddModelInstances(uint32_t tileWidth, uint32_t tileDepth, Model* enemyModel)
+void Maze::MergeWalls()
 {
-    mTileInstances.reserve(mTiles.size() * mTiles[0].size());
+    std::vector<TileRect> rects;
+    mWallBoxes.clear();
+    mChunkWallBoxes.clear();
+    mChunkWallBoxes.reserve((std::size_t)mNumChunksX * mNumChunksY + 1);
+    for (uint32_t chunkY = 0; chunkY < mNumChunksY; ++chunkY)
+    {
+        for (uint32_t chunkX = 0; chunkX < mNumChunksX; ++chunkX)
+        {
+            mChunkWallBoxes.push_back((uint32_t)mWallBoxes.size());
 
-    for (std::size_t i = 0; i < mTiles.size(); ++i) {
-        for (std::size_t j = 0; j < mTiles[0].size(); ++j) {
-            DirectX::XMFLOAT3 position;
-            DirectX::XMFLOAT3 scale = { (float)tileWidth, 2.0f, (float)tileDepth };
-            DirectX::XMFLOAT4 color = { 0.0f, 1.0f, 0.0f, 1.0f };
-            position.x = ((float)j - (float)mTiles[0].size() / 2.0f) * tileWidth;
-            position.z = ((float)i - (float)mTiles.size() / 2.0f) * tileDepth;
+            TileRect area = { chunkY * kChunkSize, chunkX * kChunkSize, 0, 0 };
+            area.rows = std::min(kChunkSize, mRows - area.row);
+            area.cols = std::min(kChunkSize, mCols - area.col);
+            rects.clear();
+            MazeGrid::MergeTiles(mTiles, mCols, area, TileType::Wall, rects);
 
-            switch (mTiles[i][j]) {
-            case TileType::Enemy:
-                color.z = 1.0f;
-                __fallthrough;
-            case TileType::Free:
-                position.y = -1.0f;
-                break;
-            case TileType::Wall:
-                position.y = 1.0f;
-                scale.y = 5.0f;
-                color.x = 1.0f;
-                color.y = 0.0f;
-                color.z = 0.0f;
-                break;
-            default:
-                break;
+            // Every wall box is the same box moved around, so the corners are enough
+            for (const auto& rect : rects)
+            {
+                auto firstBox = GetTileBoundingBox(MazeGrid::BuildTileInstance(TileType::Wall, rect.row, rect.col, mRows, mCols, mTileWidth));
+                auto lastBox = GetTileBoundingBox(MazeGrid::BuildTileInstance(TileType::Wall,
+                    rect.row + rect.rows - 1, rect.col + rect.cols - 1, mRows, mCols, mTileWidth));
+                DirectX::BoundingBox box;
+                DirectX::BoundingBox::CreateMerged(box, firstBox, lastBox);
+                mWallBoxes.push_back(box);
             }
+        }
+    }
+    mChunkWallBoxes.push_back((uint32_t)mWallBoxes.size());
 
+    SHOWINFO("Merged the walls into {} boxes", mWallBoxes.size());
+}
+
+DirectX::BoundingBox Maze::GetTileBoundingBox(const TileInstance& tileInstance) const
+{
+    return BoxTransform::Transform(mCubeModel->GetBoundingBox(),
+        DirectX::XMLoadFloat4x4(reinterpret_cast<const DirectX::XMFLOAT4X4*>(&tileInstance.WorldMatrix)));
+}
+
+void Maze::AddModelInstances()
+{
+    mTileInstances.reserve((std::size_t)mRows * mCols);
+    mTileBoxes.resize((std::size_t)mRows * mCols);
+
+    for (uint32_t i = 0; i < mRows; ++i) {
+        for (uint32_t j = 0; j < mCols; ++j) {
             InstanceInfo instanceInfo;
-            instanceInfo.WorldMatrix = DirectX::XMMatrixScaling(scale.x, scale.y, scale.z) * DirectX::XMMatrixTranslation(position.x, position.y, position.z);
-            instanceInfo.Color = color;
+            CopyTileInstance(MazeGrid::BuildTileInstance(GetTile(i, j), i, j, mRows, mCols, mTileWidth), instanceInfo);
             auto instanceResult = mCubeModel->AddInstance(instanceInfo);
-            CHECKCONT(instanceResult.Valid(), "Cannot add tile instance");
-            auto instanceID = instanceResult.Get();
-            mTileInstances.push_back(instanceID);
-            if (mTiles[i][j] == TileType::Wall)
-            {
-                mWallInstances.push_back(instanceID);
-            }
-            else if (mTiles[i][j] == TileType::Enemy)
-            {
-                mEnemies.emplace_back();
-                DirectX::XMFLOAT3 position = GetPositionFromCoordinates({ (int32_t)j, (int32_t)i });
-                CHECKCONT(mEnemies.back().Create(enemyModel, position, mTileWidth), "Cannot create enemy on coordinates = ({}, {})", j, i);
-            }
+            ASYNC_CHECKCONT(instanceResult.Valid(), "Cannot add tile instance");
+            mTileInstances.push_back(instanceResult.Get());
+        }
+    }
+}
 
+void Maze::SpawnEnemies(const TileCoordinates* spawns, std::size_t numSpawns, Model* enemyModel)
+{
+    // The enemies of the maze this one replaces come back before new ones are created, with their instances
+    mEnemyPool.insert(mEnemyPool.end(), mEnemies.begin(), mEnemies.end());
+    mEnemies.clear();
+    mEnemies.reserve(numSpawns);
+    for (std::size_t i = 0; i < numSpawns; ++i)
+    {
+        const auto& spawn = spawns[i];
+        ASYNC_CHECKCONT(spawn.x >= 0 && spawn.y >= 0 && spawn.x < (int32_t)mCols && spawn.y < (int32_t)mRows,
+            "Enemy spawn on coordinates = ({}, {}) is outside of the maze", spawn.x, spawn.y);
+        DirectX::XMFLOAT3 position = GetPositionFromCoordinates({ spawn.x, spawn.y });
+        if (!mEnemyPool.empty())
+        {
+            mEnemyPool.back().Respawn(position);
+            mEnemies.push_back(mEnemyPool.back());
+            mEnemyPool.pop_back();
         }
+        else
+        {
+            mEnemies.emplace_back();
+            ASYNC_CHECKCONT(mEnemies.back().Create(enemyModel, position, mTileWidth), "Cannot create enemy on coordinates = ({}, {})", spawn.x, spawn.y);
+        }
+        mEnemies.back().SetUpdateTime(mSimulationTime);
+    }
+    mSchedulesAreValid = false;
+}
+
+void Maze::ScheduleEnemies()
+{
+    // The old timers may belong to enemies that have moved since
+    for (auto timer : mEnemyTimers)
+    {
+        mTimers.Cancel(timer);
+    }
+    mEnemyTimers.assign(mEnemies.size(), TimerWheel::kNoTimer);
+    for (uint32_t i = 0; i < (uint32_t)mEnemies.size(); ++i)
+    {
+        Schedule(i);
+    }
+    mScheduledFocusChunk = mSimulationFocusChunk;
+    mSchedulesAreValid = true;
+}
+
+Maze::SimulationLevel Maze::GetSimulationLevel(uint32_t enemyIndex) const
+{
+    const auto& enemy = mEnemies[enemyIndex];
+    if (enemy.IsDying() || mSimulationFocusChunk.x < 0)
+    {
+        return SimulationLevel::Near;
+    }
+    // By where it patrols around, so an enemy doesn't change level back and forth at a chunk border
+    auto tile = GetCoordinatesFromPosition(enemy.GetInitialPosition());
+    return GameRules::GetSimulationLevel(GameRules::GetChunk({ tile.x, tile.y }), mSimulationFocusChunk,
+        mSimulationNearRadius, mSimulationMidRadius);
+}
+
+void Maze::Schedule(uint32_t enemyIndex)
+{
+    mEnemyTimers[enemyIndex] = TimerWheel::kNoTimer;
+    double wakeTime = GameRules::GetResumeTime(GetSimulationLevel(enemyIndex), mEnemies[enemyIndex].GetWakeTime());
+    if (wakeTime == kBehaviourDone)
+    {
+        return;
+    }
+    mEnemyTimers[enemyIndex] = mTimers.Add(wakeTime, [this, enemyIndex]() { ResumeEnemy(enemyIndex); });
+}
+
+void Maze::Unschedule(uint32_t enemyIndex)
+{
+    mTimers.Cancel(mEnemyTimers[enemyIndex]);
+    mEnemyTimers[enemyIndex] = TimerWheel::kNoTimer;
+}
+
+void Maze::ResumeEnemy(uint32_t enemyIndex)
+{
+    mEnemyTimers[enemyIndex] = TimerWheel::kNoTimer;
+    auto& enemy = mEnemies[enemyIndex];
+    enemy.Resume(mSimulationTime);
+    mNumSimulatedEnemies++;
+    if (enemy.ShouldDie())
+    {
+        RemoveEnemy(enemyIndex);
+        return;
+    }
+    // A wake time already passed fires on the next tick
+    Schedule(enemyIndex);
+}
+
+void Maze::RemoveEnemy(uint32_t enemyIndex)
+{
+    Unschedule(enemyIndex);
+    mEnemyPool.push_back(mEnemies[enemyIndex]);
+    auto lastEnemy = (uint32_t)mEnemies.size() - 1;
+    bool moved = enemyIndex != lastEnemy && mEnemyTimers[lastEnemy] != TimerWheel::kNoTimer;
+    if (enemyIndex != lastEnemy)
+    {
+        // Its timer knows it by its index, so it gets a new one at the same wake time
+        Unschedule(lastEnemy);
+        mEnemies[enemyIndex] = mEnemies[lastEnemy];
+    }
+    mEnemies.pop_back();
+    mEnemyTimers.pop_back();
+    if (moved)
+    {
+        Schedule(enemyIndex);
     }
 }
 
 void Maze::PrintMazeToLogger()
 {
-    std::ostringstream mazeString;
-    mazeString << "\n";
-    for (const auto& row : mTiles) {
-        for (const auto& col : row) {
-            switch (col) {
+    // Two characters per tile plus the line breaks, written straight into one buffer that the async logger takes over
+    auto mazeString = fmt::format("Generated maze with {} rows and {} cols is \n", mRows, mCols);
+    mazeString.reserve(mazeString.size() + (std::size_t)mRows * (2 * mCols + 1));
+    for (uint32_t i = 0; i < mRows; ++i) {
+        for (uint32_t j = 0; j < mCols; ++j) {
+            switch (GetTile(i, j)) {
             case TileType::Free:
-                mazeString << ". ";
+                mazeString += ". ";
                 break;
             case TileType::Wall:
-                mazeString << "# ";
+                mazeString += "# ";
                 break;
             case TileType::Enemy:
-                mazeString << "? ";
+                mazeString += "? ";
                 break;
             default:
                 break;
             }
         }
-        mazeString << "\n";
+        mazeString += '\n';
     }
-    SHOWINFO("Generated maze with {} rows and {} cols is {}", mTiles.size(), mTiles[0].size(), mazeString.str());
-}
-
-std::vector<DirectX::XMINT2> Maze::GetNeighbours(const DirectX::XMINT2& tile, std::unordered_set<std::pair<uint32_t, uint32_t>, PairHash>& visitedTiles)
-{
-    constexpr int dirY[] = { 1, -1, 0, 0 };
-    constexpr int dirX[] = { 0, 0, 1, -1 };
-    static_assert(ARRAYSIZE(dirY) == ARRAYSIZE(dirX), "Direction arrays must have the same size");
-
-    std::vector<DirectX::XMINT2> neighbours;
-    for (uint32_t i = 0; i < ARRAYSIZE(dirY); ++i) {
-        DirectX::XMINT2 newTile = tile;
-        newTile.x += dirX[i];
-        newTile.y += dirY[i];
-
-        if (newTile.x < 0 || newTile.y < 0 || newTile.x > (mTiles[0].size() - 1) || newTile.y > (mTiles.size() - 1)) {
-            continue;
-        }
-        if (visitedTiles.find({ newTile.y, newTile.x }) != visitedTiles.end()) {
-            continue;
-        }
-
-        neighbours.push_back(newTile);
-    }
-
-    return neighbours;
+    AsyncLogger::Get().LogPayload(AsyncLogger::Level::Info, "{}", std::move(mazeString));
 }
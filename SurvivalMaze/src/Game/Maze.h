@@ -3,68 +3,272 @@
 #include "Oblivion.h"
 #include "Model.h"
 #include "Enemy.h"
+#include "MazeGrid.h"
+#include "GridCollision.h"
+#include "MazeFile.h"
+#include "RegionMazeGenerator.h"
+#include "EllerMazeGenerator.h"
+#include "FrustumCuller.h"
+#include "MazeVisibility.h"
+#include "ChunkMesher.h"
+#include "LightBinner.h"
+#include "AsyncLogger.h"
+#include "AgentChannel.h"
+#include "SpectatorCodec.h"
+#include "BoxTransform.h"
+#include "MemoryTracker.h"
+#include "FrameArena.h"
+#include "TimerWheel.h"
+#include "GameRules.h"
 
 class Maze {
 public:
+    // Tiles are instanced per chunk of kChunkSize x kChunkSize tiles, and only around the player
+    static constexpr const uint32_t kChunkSize = GameRules::kChunkSize;
+    static constexpr const uint32_t kChunkTiles = kChunkSize * kChunkSize;
+    // Enemies are resumed by timers of this resolution, see GameRules
+    static constexpr const double kTimerTickTime = GameRules::kTimerTickTime;
+
+    enum class Generator {
+        Lee = 0,
+        Regions, // Perfect maze carved in parallel, see RegionMazeGenerator
+    };
+
     struct MazeInitializationInfo {
+        Generator generator = Generator::Lee;
+        // Of the generator, or of the rows in endless mode. The same seed and settings always make the same maze
+        uint32_t seed = 0;
+
         unsigned int rows = 10;
         unsigned int cols = 10;
 
-        float tileWidthDepth = 10.f;
+        float tileWidthDepth = GameRules::kTileSize;
+
+        // Endless mode streams rows ahead of the player (see UpdateStreaming) and only keeps
+        // the last rows rows in memory. Neither the generator nor levelPath are used
+        bool endless = false;
+
+        // When set, the maze is loaded from this baked level (see MazeFile) instead of being generated.
+        // rows, cols and tileWidthDepth are then taken from the file
+        std::string levelPath;
+
+        // Chunks at most this many chunks away from the player have their tile instances created
+        unsigned int residencyRadius = 2;
+
+        // Simulation levels of the enemies, by chunk distance from the player: up to simulationNearRadius chunks away
+        // they are resumed on the tick they asked for, up to simulationMidRadius up to GameRules::kMidSimulationInterval timer
+        // ticks later, and further away not at all. Whatever an enemy missed is caught up on the next time it is resumed.
+        // Mid enemies still move smoothly, their patrol is a function of time, they only start the next one late.
+        // Far enemies are neither drawn nor collided with, so simulationMidRadius is at least residencyRadius
+        unsigned int simulationNearRadius = GameRules::kSimulationNearRadius;
+        unsigned int simulationMidRadius = GameRules::kSimulationMidRadius;
+
+        // Radius, in tiles, of the potentially visible sets built after the maze is created. 0 disables them.
+        // Not used in endless mode
+        unsigned int visibilityRadius = 0;
+
+        // Static meshes baked by ChunkMesher for the level, ChunkMesher::kNumParts per chunk in row major order,
+        // null for empty parts. When set, tiles are not instanced. Only used with levelPath
+        std::vector<Model*> chunkModels;
 
         Model* cubeModel;
         Model* enemyModel;
     };
 
+    // The part of a generated maze that doesn't need the models: its tiles and visible sets. It is most of the work
+    // of creating a maze, and it can be built on any thread, see BuildLayout
+    struct Layout {
+        MazeGrid grid{ MemoryTracker::Get().GetResource(MemoryTag::Maze) };
+        DirectX::XMINT2 start;
+        DirectX::XMINT2 exit;
+        MazeVisibility visibility; // Not built when the visibility radius is 0
+    };
+
 public:
     Maze() = default;
 
 public:
     Result<DirectX::XMFLOAT3> Create(const MazeInitializationInfo& info);
+    // Generated mazes only. Safe to call from any thread, nothing but the layout is touched
+    static bool BuildLayout(const MazeInitializationInfo& info, Layout& layout);
+    // Creates the instances and enemies of a generated maze on top of its layout. Models are not thread safe, so
+    // call it where the models are used. Can be called again to replace the maze, which reuses its instances
+    Result<DirectX::XMFLOAT3> Create(const MazeInitializationInfo& info, Layout&& layout);
+    // Only resumes the enemies whose wake time has come, see MazeInitializationInfo::simulationNearRadius
     void Update(float dt);
-    void Render();
+    // Makes the chunks around focusPosition resident. In endless mode it generates the rows ahead
+    // of focusPosition instead, recycling the ones far behind it. focusPosition is also what the enemies' simulation
+    // levels are measured from
+    void __vectorcall UpdateStreaming(const DirectX::XMVECTOR& focusPosition);
+    // Only the instances inside the culler's frustum are submitted
+    void Render(FrustumCuller& culler);
     void RenderDebug(BatchRenderer& batchRenderer);
 
+    // Render only keeps the tiles and enemies in the visible set of the tile viewPosition is in.
+    // Only valid for views from inside the maze, so disable it for cameras that look over the walls
+    void __vectorcall UpdateVisibility(const DirectX::XMVECTOR& viewPosition);
+    void DisableVisibility();
+    uint32_t GetNumOccludedInstances() const;
+    // Resumed by the last Update
+    uint32_t GetNumSimulatedEnemies() const;
+    // What the enemies' patrols are evaluated at, see Enemy::GetWorldMatrix
+    double GetSimulationTime() const;
+    // The opening in the border of a generated maze, (-1, -1) for the other ones
+    DirectX::XMINT2 GetExitCoordinates() const;
+
+    // Fills the tiles around the player and the closest enemies, the caller takes care of the rest
+    void Observe(const DirectX::XMFLOAT3& playerPosition, AgentObservation& observation) const;
+    // Adds the enemies, dying ones included
+    void Spectate(SpectatorFrame& frame) const;
+
+    // Puts a torch on about one in spacing free tiles next to a wall, against that wall. Not supported in endless mode
+    void PlaceTorches(uint32_t spacing, std::vector<PointLight>& torches) const;
+
     DirectX::XMFLOAT3 GetPositionFromCoordinates(const DirectX::XMINT2& coordinates) const;
+    DirectX::XMINT2 GetCoordinatesFromPosition(const DirectX::XMFLOAT3& position) const;
 
     bool BoundingBoxCollidesWithWalls(const DirectX::BoundingBox& boundingBox) const;
+    // Moves a vertical capsule of the given radius standing at position by displacement, in the XZ plane. Instead of rejecting
+    // the whole move on contact, penetration is pushed out along the wall normals, so the capsule slides along walls.
+    // Only the wall tiles around the capsule are looked at. Returns the new position
+    DirectX::XMVECTOR __vectorcall MoveCapsule(const DirectX::XMVECTOR& position, float radius, const DirectX::XMVECTOR& displacement) const;
     bool BoundingBoxCollidesWithEnemy(const DirectX::BoundingBox& boundingBox) const;
 
     bool HandleCollisionBetweenBoundingBoxAndEnemies(const DirectX::BoundingBox& boundingBox);
 
+    // Enemies, and in endless mode the rows and the generator. Loading only works in the maze the snapshot was taken in
+    void SaveState(WorldSnapshot& snapshot) const;
+    bool LoadState(WorldSnapshot::Reader& reader);
+
 private:
-    Result<DirectX::XMINT2> Lee();
+    struct StateHeader {
+        uint32_t Rows, Cols;
+        uint32_t Endless;
+        uint32_t NumEnemies; // Including the pooled ones
+        uint64_t FirstRow, NextRow;
+        double SimulationTime;
+    };
 
-    void AddModelInstances(uint32_t tileWidth, uint32_t tileDepth, Model* enemyModel);
+    using SimulationLevel = GameRules::SimulationLevel;
 
-    void PrintMazeToLogger();
+    struct ResidentChunk {
+        uint32_t chunkX, chunkY;
+        uint32_t slot;
+        uint32_t numTiles;
+        DirectX::BoundingBox bounds;
+    };
 
 private:
-    struct PairHash {
-        inline std::size_t operator()(const std::pair<int, int>& v) const
-        {
-            return v.first * 31 + v.second;
-        }
-    };
+    Result<DirectX::XMINT2> LoadLevel(const MazeInitializationInfo& info);
+    Result<DirectX::XMINT2> CreateEndless(const MazeInitializationInfo& info);
+
+    void StreamRow();
+    void EvictRow();
+    // Rebuilds the tile instances and boxes of a row of the ring from its tiles
+    void UpdateRingRowInstances(uint64_t worldRow);
+
+    bool CreateChunkSlots(uint32_t residencyRadius);
+    bool UseChunkModels(const std::vector<Model*>& chunkModels);
+    void UpdateResidency(const DirectX::XMINT2& focusTile);
+    bool MakeChunkResident(uint32_t chunkX, uint32_t chunkY);
+
+    void AddModelInstances();
+    DirectX::BoundingBox GetTileBoundingBox(const TileInstance& tileInstance) const;
+    static bool BuildVisibility(const TileType* tiles, uint32_t rows, uint32_t cols, uint32_t radius, MazeVisibility& visibility);
+    void MergeWalls();
+    // chunk is used to find the tile of each instance when there is a visible set
+    void RenderVisibleInstances(FrustumCuller& culler, const uint32_t* instances, const DirectX::BoundingBox* boxes, uint32_t count,
+        const ResidentChunk* chunk);
+    // Counts the tile as occluded when it is not
+    bool IsChunkTileVisible(const ResidentChunk& chunk, uint32_t index);
+    void SpawnEnemies(const TileCoordinates* spawns, std::size_t numSpawns, Model* enemyModel);
 
-    std::vector<DirectX::XMINT2> GetNeighbours(const DirectX::XMINT2& tile, std::unordered_set<std::pair<uint32_t, uint32_t>, PairHash>& visitedTiles);
+    // Gives every enemy a timer for its wake time, depending on its simulation level
+    void ScheduleEnemies();
+    SimulationLevel GetSimulationLevel(uint32_t enemyIndex) const;
+    void Schedule(uint32_t enemyIndex);
+    void Unschedule(uint32_t enemyIndex);
+    // Called by the enemy's timer
+    void ResumeEnemy(uint32_t enemyIndex);
+    // The last enemy takes its place
+    void RemoveEnemy(uint32_t enemyIndex);
+
+    void PrintMazeToLogger();
+
+    inline TileType GetTile(uint32_t row, uint32_t col) const
+    {
+        return mTiles[(std::size_t)row * mCols + col];
+    }
+    // Takes world rows in endless mode. Anything outside of the maze is not a wall
+    bool IsWall(int64_t row, int64_t col) const;
 
 private:
-    enum class TileType : unsigned char {
-        Free = 0,
-        Wall,
-        Enemy,
-    };
     DirectX::XMFLOAT2 mStartPosition;
+    DirectX::XMINT2 mExit = { -1, -1 };
 
     Model* mCubeModel = nullptr;
+    Model* mEnemyModel = nullptr;
 
     float mTileWidth, mTileDepth;
     
 
-    std::vector<uint32_t> mTileInstances;
-    std::vector<uint32_t> mWallInstances;
+    // Endless mode only, one instance per tile of the ring
+    std::pmr::vector<uint32_t> mTileInstances{ MemoryTracker::Get().GetResource(MemoryTag::Maze) };
+    std::pmr::vector<DirectX::BoundingBox> mTileBoxes{ MemoryTracker::Get().GetResource(MemoryTag::Maze) };
+
+    // Instances are preallocated in slots of kChunkTiles instances, enough for every chunk in the residency radius
+    std::pmr::vector<uint32_t> mSlotInstances{ MemoryTracker::Get().GetResource(MemoryTag::Maze) };
+    // World space box of every slot instance, for culling
+    std::pmr::vector<DirectX::BoundingBox> mSlotBoxes{ MemoryTracker::Get().GetResource(MemoryTag::Maze) };
+    std::pmr::vector<uint32_t> mFreeSlots{ MemoryTracker::Get().GetResource(MemoryTag::Maze) };
+    std::pmr::vector<ResidentChunk> mResidentChunks{ MemoryTracker::Get().GetResource(MemoryTag::Maze) };
+    std::pmr::vector<uint8_t> mChunkIsResident{ MemoryTracker::Get().GetResource(MemoryTag::Maze) };
+    uint32_t mNumChunksX = 0, mNumChunksY = 0;
+    uint32_t mResidencyRadius = 0;
+    DirectX::XMINT2 mFocusChunk = { -1, -1 };
+    const TileInstance* mPrecomputedInstances = nullptr;
+
+    // Baked static meshes, used instead of the slots when present
+    std::pmr::vector<Model*> mChunkModels{ MemoryTracker::Get().GetResource(MemoryTag::Maze) };
+    std::pmr::vector<uint32_t> mChunkModelInstances{ MemoryTracker::Get().GetResource(MemoryTag::Maze) };
+    std::pmr::vector<DirectX::BoundingBox> mChunkBounds{ MemoryTracker::Get().GetResource(MemoryTag::Maze) };
+
+    std::pmr::vector<Enemy> mEnemies{ MemoryTracker::Get().GetResource(MemoryTag::Enemies) };
+    // Dead enemies and, in endless mode, enemies of evicted rows. Reused before creating new ones
+    std::pmr::vector<Enemy> mEnemyPool{ MemoryTracker::Get().GetResource(MemoryTag::Enemies) };
+
+    TimerWheel mTimers{ kTimerTickTime, MemoryTracker::Get().GetResource(MemoryTag::Enemies) };
+    // One per enemy, only valid while mSchedulesAreValid. Changing mEnemies other than through RemoveEnemy invalidates them.
+    // Far enemies have no timer. Dying enemies are always near, so they die on time
+    std::pmr::vector<TimerWheel::TimerId> mEnemyTimers{ MemoryTracker::Get().GetResource(MemoryTag::Enemies) };
+    bool mSchedulesAreValid = false;
+    uint32_t mSimulationNearRadius = GameRules::kSimulationNearRadius, mSimulationMidRadius = GameRules::kSimulationMidRadius;
+    TileCoordinates mSimulationFocusChunk = { -1, -1 }; // Unknown until the first UpdateStreaming, everything is near
+    TileCoordinates mScheduledFocusChunk = { -1, -1 };
+    double mSimulationTime = 0.0;
+    uint32_t mNumSimulatedEnemies = 0;
+
+    // Walls merged into boxes, bucketed by chunk: the boxes of a chunk are [mChunkWallBoxes[chunk], mChunkWallBoxes[chunk + 1]).
+    // Not used in endless mode, where the walls keep changing
+    std::pmr::vector<DirectX::BoundingBox> mWallBoxes{ MemoryTracker::Get().GetResource(MemoryTag::Maze) };
+    std::pmr::vector<uint32_t> mChunkWallBoxes{ MemoryTracker::Get().GetResource(MemoryTag::Maze) };
+
+    MazeVisibility mVisibility;
+    MazeVisibility::VisibleSet mVisibleSet;
+    bool mHasVisibleSet = false;
+    DirectX::XMINT2 mVisibleSetTile = { -1, -1 };
+    uint32_t mNumOccludedInstances = 0;
+
+    // Points either into mGrid or into the mapped mLevelFile
+    const TileType* mTiles = nullptr;
+    uint32_t mRows = 0, mCols = 0;
+
+    MazeGrid mGrid{ MemoryTracker::Get().GetResource(MemoryTag::Maze) };
+    MazeFile mLevelFile;
 
-    std::vector<Enemy> mEnemies;
-    std::vector<std::vector<TileType>> mTiles;
+    // In endless mode mGrid is a ring of rows: world row r lives in row r % mRows
+    bool mEndless = false;
+    EllerMazeGenerator mStreamGenerator;
+    uint64_t mFirstRow = 0; // Oldest row still in the ring
+    uint64_t mNextRow = 0; // Next row to generate
 };
@@ -0,0 +1,156 @@
+#include "MazeFile.h"
+
+#include <fstream>
+
+
+static_assert(sizeof(MazeFileHeader) == 72, "MazeFileHeader is part of the file format and must not change size");
+static_assert(sizeof(TileCoordinates) == 8, "TileCoordinates is part of the file format and must not change size");
+static_assert(sizeof(TileInstance) == 80, "TileInstance is part of the file format and must not change size");
+
+static uint64_t AlignSection(uint64_t offset)
+{
+    return (offset + MazeFile::kSectionAlignment - 1) & ~(MazeFile::kSectionAlignment - 1);
+}
+
+// Whether count elements of elementSize fit in [offset, end) starting on a section boundary, without overflowing
+static bool SectionFits(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t end)
+{
+    return offset % MazeFile::kSectionAlignment == 0 && offset <= end && count <= (end - offset) / elementSize;
+}
+
+// Whether every tile is a TileType the game knows, the rest of the game switches on them unchecked
+static bool TilesAreValid(const TileType* tiles, uint64_t count)
+{
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        if ((uint8_t)tiles[i] > (uint8_t)TileType::Enemy)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void PadTo(std::ofstream& stream, uint64_t& written, uint64_t offset)
+{
+    static const char zeros[MazeFile::kSectionAlignment] = {};
+    stream.write(zeros, (std::streamsize)(offset - written));
+    written = offset;
+}
+
+bool MazeFile::Write(const std::string& path, const MazeGrid& grid, const TileCoordinates& startPosition, float tileWidthDepth)
+{
+    const uint64_t numTiles = (uint64_t)grid.GetRows() * grid.GetCols();
+    const auto enemySpawns = grid.GetEnemySpawns();
+
+    MazeFileHeader header = {};
+    header.Magic = kMagic;
+    header.Version = kVersion;
+    header.Rows = grid.GetRows();
+    header.Cols = grid.GetCols();
+    header.TileWidthDepth = tileWidthDepth;
+    header.StartX = startPosition.x;
+    header.StartY = startPosition.y;
+    header.NumEnemies = enemySpawns.size();
+    header.TilesOffset = AlignSection(sizeof(MazeFileHeader));
+    header.EnemiesOffset = AlignSection(header.TilesOffset + numTiles * sizeof(TileType));
+    header.InstancesOffset = AlignSection(header.EnemiesOffset + header.NumEnemies * sizeof(TileCoordinates));
+    header.FileSize = header.InstancesOffset + numTiles * sizeof(TileInstance);
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream)
+    {
+        return false;
+    }
+
+    uint64_t written = 0;
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    written += sizeof(header);
+
+    PadTo(stream, written, header.TilesOffset);
+    stream.write(reinterpret_cast<const char*>(grid.GetTiles()), (std::streamsize)(numTiles * sizeof(TileType)));
+    written += numTiles * sizeof(TileType);
+
+    PadTo(stream, written, header.EnemiesOffset);
+    stream.write(reinterpret_cast<const char*>(enemySpawns.data()), (std::streamsize)(enemySpawns.size() * sizeof(TileCoordinates)));
+    written += enemySpawns.size() * sizeof(TileCoordinates);
+
+    // Instances are by far the biggest section, so stream them one row at a time
+    PadTo(stream, written, header.InstancesOffset);
+    std::vector<TileInstance> rowInstances(header.Cols);
+    for (uint32_t i = 0; i < header.Rows && stream; ++i)
+    {
+        for (uint32_t j = 0; j < header.Cols; ++j)
+        {
+            rowInstances[j] = MazeGrid::BuildTileInstance(grid.Get(i, j), i, j, header.Rows, header.Cols, tileWidthDepth);
+        }
+        stream.write(reinterpret_cast<const char*>(rowInstances.data()), (std::streamsize)(rowInstances.size() * sizeof(TileInstance)));
+    }
+
+    stream.flush();
+    return (bool)stream;
+}
+
+bool MazeFile::Open(const std::string& path)
+{
+    Close();
+    if (!mFile.Open(path))
+    {
+        return false;
+    }
+
+    bool valid = mFile.GetSize() >= sizeof(MazeFileHeader);
+    if (valid)
+    {
+        const auto* header = mFile.GetAt<MazeFileHeader>(0);
+        // Rows and cols are 32 bits, so their product can't overflow, but everything multiplied by it can
+        const uint64_t numTiles = (uint64_t)header->Rows * header->Cols;
+        valid = header->Magic == kMagic && header->Version == kVersion &&
+            header->Rows >= 3 && header->Cols >= 3 &&
+            header->StartX >= 0 && header->StartX < (int64_t)header->Cols &&
+            header->StartY >= 0 && header->StartY < (int64_t)header->Rows &&
+            header->FileSize == mFile.GetSize() &&
+            header->TilesOffset >= sizeof(MazeFileHeader) &&
+            header->NumEnemies <= numTiles &&
+            SectionFits(header->TilesOffset, numTiles, sizeof(TileType), header->EnemiesOffset) &&
+            SectionFits(header->EnemiesOffset, header->NumEnemies, sizeof(TileCoordinates), header->InstancesOffset) &&
+            SectionFits(header->InstancesOffset, numTiles, sizeof(TileInstance), header->FileSize) &&
+            TilesAreValid(mFile.GetAt<TileType>(header->TilesOffset), numTiles);
+        if (valid)
+        {
+            mHeader = header;
+        }
+    }
+
+    if (!valid)
+    {
+        Close();
+    }
+    return valid;
+}
+
+void MazeFile::Close()
+{
+    mFile.Close();
+    mHeader = nullptr;
+}
+
+const MazeFileHeader& MazeFile::GetHeader() const
+{
+    return *mHeader;
+}
+
+const TileType* MazeFile::GetTiles() const
+{
+    return mFile.GetAt<TileType>(mHeader->TilesOffset);
+}
+
+const TileCoordinates* MazeFile::GetEnemySpawns() const
+{
+    return mFile.GetAt<TileCoordinates>(mHeader->EnemiesOffset);
+}
+
+const TileInstance* MazeFile::GetTileInstances() const
+{
+    return mFile.GetAt<TileInstance>(mHeader->InstancesOffset);
+}
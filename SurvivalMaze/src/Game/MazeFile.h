@@ -0,0 +1,57 @@
+#pragma once
+
+
+#include "MappedFile.h"
+#include "MazeGrid.h"
+
+
+// Baked maze level. Everything is stored exactly the way the game consumes it, so loading
+// a level is just mapping the file and pointing into it.
+//
+// Layout (every section starts on a kSectionAlignment boundary):
+//   MazeFileHeader
+//   TileType       tiles[rows * cols]       row major
+//   TileCoordinates enemySpawns[numEnemies]
+//   TileInstance   instances[rows * cols]   row major, one per tile (walls and floors)
+struct MazeFileHeader
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t Rows;
+    uint32_t Cols;
+    float TileWidthDepth;
+    int32_t StartX;
+    int32_t StartY;
+    uint32_t Reserved;
+    uint64_t NumEnemies;
+    uint64_t TilesOffset;
+    uint64_t EnemiesOffset;
+    uint64_t InstancesOffset;
+    uint64_t FileSize;
+};
+
+class MazeFile
+{
+public:
+    static constexpr const uint32_t kMagic = 0x455A4D53; // "SMZE"
+    static constexpr const uint32_t kVersion = 1;
+    static constexpr const uint64_t kSectionAlignment = 64;
+
+public:
+    MazeFile() = default;
+
+public:
+    static bool Write(const std::string& path, const MazeGrid& grid, const TileCoordinates& startPosition, float tileWidthDepth);
+
+    bool Open(const std::string& path);
+    void Close();
+
+    const MazeFileHeader& GetHeader() const;
+    const TileType* GetTiles() const;
+    const TileCoordinates* GetEnemySpawns() const;
+    const TileInstance* GetTileInstances() const;
+
+private:
+    MappedFile mFile;
+    const MazeFileHeader* mHeader = nullptr;
+};
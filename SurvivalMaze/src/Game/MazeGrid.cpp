@@ -0,0 +1,205 @@
+#include "MazeGrid.h"
+
+#include <iterator>
+
+
+MazeGrid::MazeGrid(std::pmr::memory_resource* memory) :
+    mTiles(memory)
+{
+}
+
+MazeGrid::MazeGrid(uint32_t rows, uint32_t cols, TileType fill, std::pmr::memory_resource* memory) :
+    mRows(rows), mCols(cols), mTiles((std::size_t)rows * cols, fill, memory)
+{
+}
+
+TileCoordinates MazeGrid::Lee(std::mt19937& generator, float enemyProbability)
+{
+    constexpr int dirY[] = { 1, -1, 0, 0 };
+    constexpr int dirX[] = { 0, 0, 1, -1 };
+    static_assert(sizeof(dirY) == sizeof(dirX), "Direction arrays must have the same size");
+
+    TileCoordinates startPosition = {
+        (int32_t)mCols / 2,
+        (int32_t)mRows / 2,
+    };
+    std::vector<TileCoordinates> st;
+    st.push_back(startPosition);
+
+    // One byte per tile is a lot cheaper than hashing coordinates when baking huge mazes
+    std::vector<uint8_t> visitedTiles((std::size_t)mRows * mCols, 0);
+    visitedTiles[(std::size_t)startPosition.y * mCols + startPosition.x] = 1;
+
+    std::uniform_real_distribution<float> chanceDistribution(0.0f, 1.0f);
+
+    while (!st.empty()) {
+        // The order of st doesn't matter since we always pick a random element, so swap & pop instead of erase
+        std::uniform_int_distribution<std::size_t> indexDistribution(0, st.size() - 1);
+        auto currentPositionIndex = indexDistribution(generator);
+        auto currentPosition = st[currentPositionIndex];
+        st[currentPositionIndex] = st.back();
+        st.pop_back();
+
+        if (currentPosition.x == 0 || currentPosition.y == 0 ||
+            currentPosition.x == (int32_t)mCols - 1 || currentPosition.y == (int32_t)mRows - 1) {
+            Set(currentPosition.y, currentPosition.x, TileType::Free);
+            break;
+        }
+
+        TileCoordinates availableNeighbours[std::size(dirY)];
+        unsigned int numAvailableNeighbours = 0;
+        unsigned int freeTiles = 0;
+        for (uint32_t i = 0; i < std::size(dirY); ++i) {
+            TileCoordinates neighbour = { currentPosition.x + dirX[i], currentPosition.y + dirY[i] };
+            if (neighbour.x < 0 || neighbour.y < 0 || neighbour.x > (int32_t)mCols - 1 || neighbour.y > (int32_t)mRows - 1) {
+                continue;
+            }
+            if (visitedTiles[(std::size_t)neighbour.y * mCols + neighbour.x]) {
+                continue;
+            }
+
+            const auto tile = Get(neighbour.y, neighbour.x);
+            if (tile == TileType::Free) {
+                freeTiles++;
+            } else if (tile == TileType::Wall) {
+                availableNeighbours[numAvailableNeighbours++] = neighbour;
+            }
+        }
+        if (freeTiles > 2) {
+            continue;
+        }
+
+        if (chanceDistribution(generator) <= enemyProbability) {
+            Set(currentPosition.y, currentPosition.x, TileType::Enemy);
+        } else {
+            Set(currentPosition.y, currentPosition.x, TileType::Free);
+        }
+
+        if (numAvailableNeighbours > 1) {
+            st.push_back(currentPosition);
+        }
+        for (unsigned int i = 0; i < numAvailableNeighbours; ++i) {
+            const auto& nextNeighbour = availableNeighbours[i];
+            st.push_back(nextNeighbour);
+            visitedTiles[(std::size_t)nextNeighbour.y * mCols + nextNeighbour.x] = 1;
+        }
+    }
+    Set(startPosition.y, startPosition.x, TileType::Free);
+
+    return startPosition;
+}
+
+std::vector<TileCoordinates> MazeGrid::GetEnemySpawns() const
+{
+    std::vector<TileCoordinates> spawns;
+    for (uint32_t i = 0; i < mRows; ++i) {
+        for (uint32_t j = 0; j < mCols; ++j) {
+            if (Get(i, j) == TileType::Enemy) {
+                spawns.push_back({ (int32_t)j, (int32_t)i });
+            }
+        }
+    }
+    return spawns;
+}
+
+uint32_t MazeGrid::GetRows() const
+{
+    return mRows;
+}
+
+uint32_t MazeGrid::GetCols() const
+{
+    return mCols;
+}
+
+const TileType* MazeGrid::GetTiles() const
+{
+    return mTiles.data();
+}
+
+TileType* MazeGrid::GetTiles()
+{
+    return mTiles.data();
+}
+
+void MazeGrid::MergeTiles(const TileType* tiles, uint32_t cols, const TileRect& area, TileType type, std::vector<TileRect>& rects)
+{
+    auto isOfType = [&](uint32_t row, uint32_t col) {
+        return tiles[(std::size_t)row * cols + col] == type;
+    };
+    std::vector<uint8_t> used((std::size_t)area.rows * area.cols, 0);
+    auto isUsed = [&](uint32_t row, uint32_t col) -> uint8_t& {
+        return used[(std::size_t)(row - area.row) * area.cols + (col - area.col)];
+    };
+
+    for (uint32_t i = area.row; i < area.row + area.rows; ++i) {
+        for (uint32_t j = area.col; j < area.col + area.cols; ++j) {
+            if (!isOfType(i, j) || isUsed(i, j)) {
+                continue;
+            }
+
+            uint32_t width = 1;
+            while (j + width < area.col + area.cols && isOfType(i, j + width) && !isUsed(i, j + width)) {
+                width++;
+            }
+
+            uint32_t height = 1;
+            for (; i + height < area.row + area.rows; ++height) {
+                bool fullSpan = true;
+                for (uint32_t k = j; k < j + width && fullSpan; ++k) {
+                    fullSpan = isOfType(i + height, k) && !isUsed(i + height, k);
+                }
+                if (!fullSpan) {
+                    break;
+                }
+            }
+
+            for (uint32_t row = i; row < i + height; ++row) {
+                for (uint32_t col = j; col < j + width; ++col) {
+                    isUsed(row, col) = 1;
+                }
+            }
+            rects.push_back({ i, j, height, width });
+        }
+    }
+}
+
+TileInstance MazeGrid::BuildTileInstance(TileType type, uint32_t row, uint32_t col, uint32_t rows, uint32_t cols, float tileSize)
+{
+    float position[3];
+    float scale[3] = { tileSize, 2.0f, tileSize };
+    float color[4] = { 0.0f, 1.0f, 0.0f, 1.0f };
+    position[0] = ((float)col - (float)cols / 2.0f) * tileSize;
+    position[2] = ((float)row - (float)rows / 2.0f) * tileSize;
+
+    switch (type) {
+    case TileType::Enemy:
+        color[2] = 1.0f;
+        [[fallthrough]];
+    case TileType::Free:
+        position[1] = -1.0f;
+        break;
+    case TileType::Wall:
+    default:
+        position[1] = 1.0f;
+        scale[1] = 5.0f;
+        color[0] = 1.0f;
+        color[1] = 0.0f;
+        color[2] = 0.0f;
+        break;
+    }
+
+    // Scaling * Translation
+    TileInstance instance = {};
+    instance.WorldMatrix[0][0] = scale[0];
+    instance.WorldMatrix[1][1] = scale[1];
+    instance.WorldMatrix[2][2] = scale[2];
+    instance.WorldMatrix[3][0] = position[0];
+    instance.WorldMatrix[3][1] = position[1];
+    instance.WorldMatrix[3][2] = position[2];
+    instance.WorldMatrix[3][3] = 1.0f;
+    for (uint32_t i = 0; i < 4; ++i) {
+        instance.Color[i] = color[i];
+    }
+    return instance;
+}
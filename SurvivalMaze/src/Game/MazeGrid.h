@@ -0,0 +1,74 @@
+#pragma once
+
+
+#include <cstdint>
+#include <memory_resource>
+#include <random>
+#include <vector>
+
+
+// Everything in here is renderer independent, so it can be shared with the offline tools
+
+enum class TileType : uint8_t {
+    Free = 0,
+    Wall,
+    Enemy,
+};
+
+struct TileCoordinates {
+    int32_t x; // column
+    int32_t y; // row
+};
+
+// Tiles [row, row + rows) x [col, col + cols)
+struct TileRect {
+    uint32_t row, col;
+    uint32_t rows, cols;
+};
+
+// Same layout as the beginning of InstanceInfo (row major world matrix followed by the color)
+struct TileInstance {
+    float WorldMatrix[4][4];
+    float Color[4];
+};
+
+class MazeGrid {
+public:
+    MazeGrid() = default;
+    explicit MazeGrid(std::pmr::memory_resource* memory);
+    // Moving a grid into another one only takes its tiles over when both use the same memory
+    MazeGrid(uint32_t rows, uint32_t cols, TileType fill = TileType::Wall,
+        std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+public:
+    // Carves the maze starting from the center until the border is reached. Returns the start position
+    TileCoordinates Lee(std::mt19937& generator, float enemyProbability = 0.1f);
+
+    std::vector<TileCoordinates> GetEnemySpawns() const;
+
+    inline TileType Get(int32_t row, int32_t col) const
+    {
+        return mTiles[(std::size_t)row * mCols + col];
+    }
+    inline void Set(int32_t row, int32_t col, TileType type)
+    {
+        mTiles[(std::size_t)row * mCols + col] = type;
+    }
+
+    uint32_t GetRows() const;
+    uint32_t GetCols() const;
+    const TileType* GetTiles() const;
+    TileType* GetTiles();
+
+    // Greedily covers the tiles of the given type inside area with as few rectangles as it can: each unused tile is grown
+    // along its row first, then down as long as the whole span is made of unused tiles. Rectangles are appended to rects
+    static void MergeTiles(const TileType* tiles, uint32_t cols, const TileRect& area, TileType type, std::vector<TileRect>& rects);
+
+    static TileInstance BuildTileInstance(TileType type, uint32_t row, uint32_t col, uint32_t rows, uint32_t cols, float tileSize);
+
+private:
+    uint32_t mRows = 0;
+    uint32_t mCols = 0;
+
+    std::pmr::vector<TileType> mTiles;
+};
@@ -0,0 +1,248 @@
+#include "MazeVisibility.h"
+
+#include <cmath>
+#include <iterator>
+
+
+bool MazeVisibility::VisibleSet::Contains(int32_t row, int32_t col) const
+{
+    int32_t windowRow = row - mOriginRow + mRadius;
+    int32_t windowCol = col - mOriginCol + mRadius;
+    if (windowRow < 0 || windowCol < 0 || windowRow >= (int32_t)mWindowSize || windowCol >= (int32_t)mWindowSize)
+    {
+        return false;
+    }
+    auto bit = (std::size_t)windowRow * mWindowSize + windowCol;
+    return (mBits[bit / 64] >> (bit % 64)) & 1;
+}
+
+bool MazeVisibility::VisibleSet::Overlaps(int32_t firstRow, int32_t firstCol, int32_t lastRow, int32_t lastCol) const
+{
+    return lastRow >= mOriginRow - mRadius && firstRow <= mOriginRow + mRadius &&
+        lastCol >= mOriginCol - mRadius && firstCol <= mOriginCol + mRadius;
+}
+
+bool MazeVisibility::Build(const TileType* tiles, uint32_t rows, uint32_t cols, uint32_t radius, ThreadPool& threadPool)
+{
+    if (!tiles || rows == 0 || cols == 0 || radius == 0 || radius > kMaximumRadius)
+    {
+        return false;
+    }
+    mRows = rows;
+    mCols = cols;
+    mRadius = radius;
+    mWindowSize = 2 * radius + 1;
+
+    // Every row is encoded on its own, then everything is concatenated in order
+    std::vector<std::vector<uint16_t>> rowRuns(rows);
+    mTileOffsets.assign((std::size_t)rows * cols, 0);
+    std::vector<uint64_t> rowVisiblePairs(rows, 0);
+
+    // Enough rays to be at most half a tile apart in the corners of the window
+    auto numRays = (uint32_t)std::ceil(4.0f * kPi * (float)radius * std::sqrt(2.0f));
+    mRayDirections.resize(numRays);
+    for (uint32_t ray = 0; ray < numRays; ++ray)
+    {
+        float angle = 2.0f * kPi * ((float)ray + 0.5f) / (float)numRays;
+        mRayDirections[ray] = { std::cos(angle), std::sin(angle) };
+    }
+
+    threadPool.ParallelFor(rows, [&](std::size_t row)
+        {
+            std::vector<uint8_t> window, dilated;
+            std::vector<TileCoordinates> marked;
+            auto& runs = rowRuns[row];
+            for (uint32_t col = 0; col < cols; ++col)
+            {
+                mTileOffsets[row * cols + col] = (uint32_t)runs.size();
+                auto tileRuns = EncodeTile(tiles, (int32_t)row, (int32_t)col, window, dilated, marked);
+                for (std::size_t i = 1; i < tileRuns.size(); i += 2)
+                {
+                    rowVisiblePairs[row] += tileRuns[i];
+                }
+                runs.insert(runs.end(), tileRuns.begin(), tileRuns.end());
+            }
+        });
+
+    mRowOffsets.resize((std::size_t)rows + 1);
+    mRowOffsets[0] = 0;
+    mNumVisiblePairs = 0;
+    for (uint32_t row = 0; row < rows; ++row)
+    {
+        mRowOffsets[row + 1] = mRowOffsets[row] + rowRuns[row].size();
+        mNumVisiblePairs += rowVisiblePairs[row];
+    }
+    mRuns.clear();
+    mRuns.reserve(mRowOffsets[rows]);
+    for (auto& runs : rowRuns)
+    {
+        mRuns.insert(mRuns.end(), runs.begin(), runs.end());
+        std::vector<uint16_t>().swap(runs);
+    }
+    return true;
+}
+
+bool MazeVisibility::IsBuilt() const
+{
+    return !mRowOffsets.empty();
+}
+
+bool MazeVisibility::Decode(int32_t row, int32_t col, VisibleSet& set) const
+{
+    if (!IsBuilt() || row < 0 || col < 0 || row >= (int32_t)mRows || col >= (int32_t)mCols)
+    {
+        return false;
+    }
+    auto tile = (std::size_t)row * mCols + col;
+    auto begin = mRowOffsets[row] + mTileOffsets[tile];
+    auto end = (uint32_t)col + 1 < mCols ? mRowOffsets[row] + mTileOffsets[tile + 1] : mRowOffsets[(std::size_t)row + 1];
+    if (begin == end)
+    {
+        return false;
+    }
+
+    set.mOriginRow = row;
+    set.mOriginCol = col;
+    set.mRadius = (int32_t)mRadius;
+    set.mWindowSize = mWindowSize;
+    set.mBits.assign(((std::size_t)mWindowSize * mWindowSize + 63) / 64, 0);
+
+    std::size_t bit = 0;
+    for (auto i = begin; i < end; ++i)
+    {
+        bool inside = (i - begin) % 2 == 1;
+        for (uint32_t j = 0; j < mRuns[i]; ++j, ++bit)
+        {
+            if (inside)
+            {
+                set.mBits[bit / 64] |= 1ull << (bit % 64);
+            }
+        }
+    }
+    return true;
+}
+
+std::size_t MazeVisibility::GetMemoryUsage() const
+{
+    return mRuns.capacity() * sizeof(uint16_t) + mRowOffsets.capacity() * sizeof(uint64_t) +
+        mTileOffsets.capacity() * sizeof(uint32_t);
+}
+
+uint64_t MazeVisibility::GetNumVisiblePairs() const
+{
+    return mNumVisiblePairs;
+}
+
+std::vector<uint16_t> MazeVisibility::EncodeTile(const TileType* tiles, int32_t row, int32_t col,
+    std::vector<uint8_t>& window, std::vector<uint8_t>& dilated, std::vector<TileCoordinates>& marked) const
+{
+    auto isWall = [&](int32_t r, int32_t c)
+    {
+        return tiles[(std::size_t)r * mCols + c] == TileType::Wall;
+    };
+    if (isWall(row, col))
+    {
+        return {};
+    }
+
+    const int32_t radius = (int32_t)mRadius;
+    const uint32_t windowSize = mWindowSize;
+    window.assign((std::size_t)windowSize * windowSize, 0);
+    marked.clear();
+    auto mark = [&](int32_t r, int32_t c)
+    {
+        auto& value = window[(std::size_t)(r - row + radius) * windowSize + (c - col + radius)];
+        if (!value)
+        {
+            value = 1;
+            marked.push_back({ c - col + radius, r - row + radius });
+        }
+    };
+
+    // The camera can be anywhere inside the tile, so cast from its center and from points close to its corners.
+    // Coordinates are in tiles, tile (r, c) covers [c - 0.5, c + 0.5] x [r - 0.5, r + 0.5]
+    constexpr float inset = 0.49f;
+    constexpr float originX[] = { 0.0f, -inset, inset, -inset, inset };
+    constexpr float originY[] = { 0.0f, -inset, -inset, inset, inset };
+    for (uint32_t origin = 0; origin < std::size(originX); ++origin)
+    {
+        float startX = (float)col + originX[origin];
+        float startY = (float)row + originY[origin];
+        for (const auto& direction : mRayDirections)
+        {
+            float directionX = direction.x, directionY = direction.y;
+
+            // Amanatides & Woo grid traversal
+            int32_t tileX = col, tileY = row;
+            int32_t stepX = directionX > 0.0f ? 1 : -1;
+            int32_t stepY = directionY > 0.0f ? 1 : -1;
+            float deltaX = directionX != 0.0f ? std::fabs(1.0f / directionX) : INFINITY;
+            float deltaY = directionY != 0.0f ? std::fabs(1.0f / directionY) : INFINITY;
+            float boundaryX = (float)tileX + 0.5f * (float)stepX;
+            float boundaryY = (float)tileY + 0.5f * (float)stepY;
+            float maxX = directionX != 0.0f ? (boundaryX - startX) / directionX : INFINITY;
+            float maxY = directionY != 0.0f ? (boundaryY - startY) / directionY : INFINITY;
+
+            while (true)
+            {
+                if (maxX < maxY)
+                {
+                    tileX += stepX;
+                    maxX += deltaX;
+                }
+                else
+                {
+                    tileY += stepY;
+                    maxY += deltaY;
+                }
+                if (std::abs(tileX - col) > radius || std::abs(tileY - row) > radius ||
+                    tileX < 0 || tileY < 0 || tileX >= (int32_t)mCols || tileY >= (int32_t)mRows)
+                {
+                    break;
+                }
+                mark(tileY, tileX);
+                if (isWall(tileY, tileX))
+                {
+                    break;
+                }
+            }
+        }
+    }
+    mark(row, col);
+
+    // Grow the set by one tile, so tiles squeezed between two rays are not lost
+    dilated.assign(window.size(), 0);
+    for (const auto& tile : marked)
+    {
+        for (int32_t r = std::max(tile.y - 1, 0); r <= std::min(tile.y + 1, (int32_t)windowSize - 1); ++r)
+        {
+            for (int32_t c = std::max(tile.x - 1, 0); c <= std::min(tile.x + 1, (int32_t)windowSize - 1); ++c)
+            {
+                int32_t mazeRow = r - radius + row, mazeCol = c - radius + col;
+                if (mazeRow >= 0 && mazeCol >= 0 && mazeRow < (int32_t)mRows && mazeCol < (int32_t)mCols)
+                {
+                    dilated[(std::size_t)r * windowSize + c] = 1;
+                }
+            }
+        }
+    }
+
+    std::vector<uint16_t> runs;
+    uint8_t current = 0;
+    uint32_t length = 0;
+    for (auto value : dilated)
+    {
+        if (value != current)
+        {
+            runs.push_back((uint16_t)length);
+            current = value;
+            length = 0;
+        }
+        length++;
+    }
+    if (current == 1)
+    {
+        runs.push_back((uint16_t)length);
+    }
+    return runs;
+}
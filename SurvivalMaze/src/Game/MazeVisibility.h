@@ -0,0 +1,71 @@
+#pragma once
+
+
+#include "MazeGrid.h"
+#include "ThreadPool.h"
+
+
+// Potentially visible sets for a tile grid. For every non wall tile, rays are cast from a few points of the tile
+// in all directions and every tile they cross, up to and including the first wall, is marked as visible.
+// Sets are limited to a square window of radius tiles around their tile and stored run length encoded.
+class MazeVisibility
+{
+public:
+    static constexpr const uint32_t kMaximumRadius = 127;
+    static constexpr const float kPi = 3.14159265f;
+
+    // Decoded set of a single tile, a bitset over its window
+    class VisibleSet
+    {
+    public:
+        VisibleSet() = default;
+
+    public:
+        bool Contains(int32_t row, int32_t col) const;
+        // True if any tile of the rectangle can be in the set
+        bool Overlaps(int32_t firstRow, int32_t firstCol, int32_t lastRow, int32_t lastCol) const;
+
+    private:
+        friend class MazeVisibility;
+
+        int32_t mOriginRow = 0, mOriginCol = 0;
+        int32_t mRadius = 0;
+        uint32_t mWindowSize = 0;
+        std::vector<uint64_t> mBits;
+    };
+
+public:
+    MazeVisibility() = default;
+
+public:
+    bool Build(const TileType* tiles, uint32_t rows, uint32_t cols, uint32_t radius, ThreadPool& threadPool);
+    bool IsBuilt() const;
+
+    // Returns false if row, col has no set (walls or outside of the maze)
+    bool Decode(int32_t row, int32_t col, VisibleSet& set) const;
+
+    std::size_t GetMemoryUsage() const;
+    // Sum of the set sizes over all tiles
+    uint64_t GetNumVisiblePairs() const;
+
+private:
+    std::vector<uint16_t> EncodeTile(const TileType* tiles, int32_t row, int32_t col,
+        std::vector<uint8_t>& window, std::vector<uint8_t>& dilated, std::vector<TileCoordinates>& marked) const;
+
+private:
+    uint32_t mRows = 0, mCols = 0;
+    uint32_t mRadius = 0;
+    uint32_t mWindowSize = 0;
+
+    struct RayDirection {
+        float x, y;
+    };
+    std::vector<RayDirection> mRayDirections;
+
+    // Runs alternate between tiles outside and inside of the set, starting with outside, over the window in row major order.
+    // A tile's runs start at mRowOffsets[row] + mTileOffsets[tile]; an empty range means there is no set
+    std::vector<uint16_t> mRuns;
+    std::vector<uint64_t> mRowOffsets;
+    std::vector<uint32_t> mTileOffsets;
+    uint64_t mNumVisiblePairs = 0;
+};
@@ -0,0 +1,135 @@
+#include "MemoryTracker.h"
+
+#include <fstream>
+
+
+TrackedMemoryResource::TrackedMemoryResource(const char* name, std::pmr::memory_resource* upstream) :
+    mName(name), mUpstream(upstream)
+{
+}
+
+const char* TrackedMemoryResource::GetName() const
+{
+    return mName;
+}
+
+TrackedMemoryResource::Statistics TrackedMemoryResource::GetStatistics() const
+{
+    return { mLiveBytes.load(std::memory_order_relaxed), mPeakBytes.load(std::memory_order_relaxed),
+        mNumAllocations.load(std::memory_order_relaxed), mNumFrees.load(std::memory_order_relaxed),
+        mFrameAllocations.load(std::memory_order_relaxed) };
+}
+
+void TrackedMemoryResource::EndFrame()
+{
+    uint64_t numAllocations = mNumAllocations.load(std::memory_order_relaxed);
+    mFrameAllocations.store(numAllocations - mFrameStartAllocations, std::memory_order_relaxed);
+    mFrameStartAllocations = numAllocations;
+}
+
+void* TrackedMemoryResource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    void* pointer = mUpstream->allocate(bytes, alignment);
+    mNumAllocations.fetch_add(1, std::memory_order_relaxed);
+    uint64_t liveBytes = mLiveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    uint64_t peakBytes = mPeakBytes.load(std::memory_order_relaxed);
+    while (liveBytes > peakBytes && !mPeakBytes.compare_exchange_weak(peakBytes, liveBytes, std::memory_order_relaxed))
+    {
+    }
+    return pointer;
+}
+
+void TrackedMemoryResource::do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment)
+{
+    mUpstream->deallocate(pointer, bytes, alignment);
+    mNumFrees.fetch_add(1, std::memory_order_relaxed);
+    mLiveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+bool TrackedMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+MemoryTracker& MemoryTracker::Get()
+{
+    static MemoryTracker instance;
+    return instance;
+}
+
+MemoryTracker::MemoryTracker() :
+    mResources{
+        TrackedMemoryResource("Maze"),
+        TrackedMemoryResource("Enemies"),
+        TrackedMemoryResource("Projectiles"),
+        TrackedMemoryResource("CompositeModels"),
+        TrackedMemoryResource("Logging"),
+        TrackedMemoryResource("Snapshots"),
+        TrackedMemoryResource("FrameArenas"),
+    }
+{
+    static_assert((uint32_t)MemoryTag::Count == 7, "Every tag needs a resource");
+}
+
+std::pmr::memory_resource* MemoryTracker::GetResource(MemoryTag tag)
+{
+    return &mResources[(uint32_t)tag];
+}
+
+TrackedMemoryResource::Statistics MemoryTracker::GetStatistics(MemoryTag tag) const
+{
+    return mResources[(uint32_t)tag].GetStatistics();
+}
+
+const char* MemoryTracker::GetName(MemoryTag tag) const
+{
+    return mResources[(uint32_t)tag].GetName();
+}
+
+void MemoryTracker::EndFrame()
+{
+    for (auto& resource : mResources)
+    {
+        resource.EndFrame();
+    }
+}
+
+uint64_t MemoryTracker::GetFrameAllocations() const
+{
+    uint64_t numAllocations = 0;
+    for (const auto& resource : mResources)
+    {
+        numAllocations += resource.GetStatistics().FrameAllocations;
+    }
+    return numAllocations;
+}
+
+std::string MemoryTracker::DumpJson() const
+{
+    std::string json = "{\n  \"subsystems\": [\n";
+    for (uint32_t i = 0; i < (uint32_t)MemoryTag::Count; ++i)
+    {
+        auto statistics = mResources[i].GetStatistics();
+        // The names are ours, nothing to escape
+        json += "    { \"name\": \"" + std::string(mResources[i].GetName()) + "\"";
+        json += ", \"liveBytes\": " + std::to_string(statistics.LiveBytes);
+        json += ", \"peakBytes\": " + std::to_string(statistics.PeakBytes);
+        json += ", \"allocations\": " + std::to_string(statistics.NumAllocations);
+        json += ", \"frees\": " + std::to_string(statistics.NumFrees);
+        json += ", \"frameAllocations\": " + std::to_string(statistics.FrameAllocations);
+        json += i + 1 < (uint32_t)MemoryTag::Count ? " },\n" : " }\n";
+    }
+    json += "  ]\n}\n";
+    return json;
+}
+
+bool MemoryTracker::DumpJson(const std::string& path) const
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        return false;
+    }
+    file << DumpJson();
+    return (bool)file;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <utility>
+
+
+// Where the game's own memory goes, one tracked std::pmr resource per subsystem. Containers get the resource of their
+// subsystem at construction, objects on their own are made with MakeTracked. Memory owned by the renderer
+// (Model instance arrays, FrameResources upload buffers) is not allocated through here, so it doesn't show up
+
+enum class MemoryTag : uint32_t
+{
+    Maze = 0, // Tiles, tile instances and their boxes
+    Enemies,
+    Projectiles,
+    CompositeModels,
+    Logging,
+    Snapshots,
+    FrameArenas, // The blocks of every thread's FrameArena
+    Count,
+};
+
+class TrackedMemoryResource : public std::pmr::memory_resource
+{
+public:
+    struct Statistics
+    {
+        uint64_t LiveBytes;
+        uint64_t PeakBytes;
+        uint64_t NumAllocations;
+        uint64_t NumFrees;
+        uint64_t FrameAllocations; // During the last frame, see MemoryTracker::EndFrame
+    };
+
+public:
+    explicit TrackedMemoryResource(const char* name, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+public:
+    const char* GetName() const;
+    Statistics GetStatistics() const;
+    void EndFrame();
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+    const char* mName;
+    std::pmr::memory_resource* mUpstream;
+
+    // Relaxed, the numbers only need to add up eventually
+    std::atomic<uint64_t> mLiveBytes = 0;
+    std::atomic<uint64_t> mPeakBytes = 0;
+    std::atomic<uint64_t> mNumAllocations = 0;
+    std::atomic<uint64_t> mNumFrees = 0;
+    uint64_t mFrameStartAllocations = 0;
+    std::atomic<uint64_t> mFrameAllocations = 0;
+};
+
+class MemoryTracker
+{
+public:
+    static MemoryTracker& Get();
+
+    MemoryTracker(const MemoryTracker&) = delete;
+    MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+public:
+    std::pmr::memory_resource* GetResource(MemoryTag tag);
+    TrackedMemoryResource::Statistics GetStatistics(MemoryTag tag) const;
+    const char* GetName(MemoryTag tag) const;
+
+    // Call once per frame, from the main thread: the allocations made since the previous call become the last frame's
+    void EndFrame();
+    // Of every subsystem
+    uint64_t GetFrameAllocations() const;
+
+    // {"subsystems": [{"name": ..., "liveBytes": ..., ...}, ...]}
+    std::string DumpJson() const;
+    bool DumpJson(const std::string& path) const;
+
+private:
+    MemoryTracker();
+
+private:
+    TrackedMemoryResource mResources[(uint32_t)MemoryTag::Count];
+};
+
+template <typename T>
+struct TrackedDeleter
+{
+    std::pmr::memory_resource* Memory = nullptr;
+
+    void operator()(T* object) const
+    {
+        object->~T();
+        Memory->deallocate(object, sizeof(T), alignof(T));
+    }
+};
+
+template <typename T>
+using TrackedPtr = std::unique_ptr<T, TrackedDeleter<T>>;
+
+template <typename T, typename... Args>
+TrackedPtr<T> MakeTracked(MemoryTag tag, Args&&... args)
+{
+    auto* memory = MemoryTracker::Get().GetResource(tag);
+    void* storage = memory->allocate(sizeof(T), alignof(T));
+    try
+    {
+        return TrackedPtr<T>(new (storage) T(std::forward<Args>(args)...), TrackedDeleter<T>{ memory });
+    }
+    catch (...)
+    {
+        memory->deallocate(storage, sizeof(T), alignof(T));
+        throw;
+    }
+}
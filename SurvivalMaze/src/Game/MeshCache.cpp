@@ -0,0 +1,116 @@
+#include "MeshCache.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+
+static void HashBytes(uint64_t& hash, const uint8_t* data, uint64_t size)
+{
+    // FNV-1a
+    constexpr uint64_t prime = 0x100000001B3ull;
+    for (uint64_t i = 0; i < size; ++i)
+    {
+        hash ^= data[i];
+        hash *= prime;
+    }
+}
+
+// The mtllib lines of an OBJ file. Like assimp, which loads them, the rest of the line is one file name
+static std::vector<std::string> FindMaterialLibraries(const uint8_t* data, uint64_t size)
+{
+    constexpr const char keyword[] = "mtllib";
+    constexpr uint64_t keywordSize = sizeof(keyword) - 1;
+    auto isBlank = [](uint8_t c) { return c == ' ' || c == '\t'; };
+
+    std::vector<std::string> libraries;
+    uint64_t lineStart = 0;
+    while (lineStart < size)
+    {
+        uint64_t lineEnd = lineStart;
+        while (lineEnd < size && data[lineEnd] != '\n')
+        {
+            lineEnd++;
+        }
+        uint64_t begin = lineStart;
+        while (begin < lineEnd && isBlank(data[begin]))
+        {
+            begin++;
+        }
+        if (lineEnd - begin > keywordSize && std::equal(keyword, keyword + keywordSize, data + begin) &&
+            isBlank(data[begin + keywordSize]))
+        {
+            begin += keywordSize;
+            uint64_t end = lineEnd;
+            while (begin < end && std::isspace(data[begin]))
+            {
+                begin++;
+            }
+            while (end > begin && std::isspace(data[end - 1]))
+            {
+                end--;
+            }
+            if (end > begin)
+            {
+                libraries.emplace_back(reinterpret_cast<const char*>(data + begin), (std::size_t)(end - begin));
+            }
+        }
+        lineStart = lineEnd + 1;
+    }
+    return libraries;
+}
+
+bool MeshCache::HashSource(const std::string& sourcePath, uint64_t& hash)
+{
+    hash = 0xCBF29CE484222325ull;
+
+    MappedFile source;
+    if (!source.Open(sourcePath))
+    {
+        return false;
+    }
+    HashBytes(hash, source.GetData(), source.GetSize());
+
+    auto directory = std::filesystem::path(sourcePath).parent_path();
+    for (const auto& library : FindMaterialLibraries(source.GetData(), source.GetSize()))
+    {
+        HashBytes(hash, reinterpret_cast<const uint8_t*>(library.data()), library.size());
+        MappedFile materialLibrary;
+        if (materialLibrary.Open((directory / library).string()))
+        {
+            HashBytes(hash, materialLibrary.GetData(), materialLibrary.GetSize());
+        }
+    }
+
+    return true;
+}
+
+std::string MeshCache::GetCachePath(const std::string& sourcePath, uint64_t hash)
+{
+    char hashString[17];
+    snprintf(hashString, sizeof(hashString), "%016llx", (unsigned long long)hash);
+
+    std::filesystem::path path(sourcePath);
+    auto cacheName = path.stem().string() + "." + hashString + kCacheExtension;
+    return (path.parent_path() / kCacheDirectory / cacheName).string();
+}
+
+std::string MeshCache::FindCachedMesh(const std::string& sourcePath)
+{
+    uint64_t hash;
+    if (!HashSource(sourcePath, hash))
+    {
+        return {};
+    }
+
+    auto cachePath = GetCachePath(sourcePath, hash);
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(cachePath, error))
+    {
+        return {};
+    }
+    return cachePath;
+}
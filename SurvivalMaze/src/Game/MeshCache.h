@@ -0,0 +1,25 @@
+#pragma once
+
+
+#include <cstdint>
+#include <string>
+
+
+// Baked meshes live next to their source in a Cache directory, as assimp binary dumps named after
+// the hash of the source files (<dir>/Cache/<name>.<hash>.assbin). A cache entry whose hash doesn't
+// match the current sources is simply never looked up, so stale entries can't be loaded by mistake.
+class MeshCache
+{
+public:
+    static constexpr const char* kCacheDirectory = "Cache";
+    static constexpr const char* kCacheExtension = ".assbin";
+
+public:
+    // Hashes the mesh source together with the material libraries it names with mtllib, relative to its directory.
+    // A library that doesn't exist yet still counts with its name, so creating it later changes the hash
+    static bool HashSource(const std::string& sourcePath, uint64_t& hash);
+    static std::string GetCachePath(const std::string& sourcePath, uint64_t hash);
+
+    // Returns the baked mesh when it is up to date, an empty string otherwise
+    static std::string FindCachedMesh(const std::string& sourcePath);
+};
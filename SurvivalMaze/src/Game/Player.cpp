@@ -48,16 +48,21 @@ bool Player::Create(Model* usedModel, Maze* maze)
     mLeftLeg->TranslateFromParent(-0.3f, -1.1f, 0.0f);
 
     mModel.UpdateBoundingBox();
+    const auto& boundingBox = static_cast<const CompositeModel&>(mModel).GetBoundingBox();
+    float radiusX = std::fabs(boundingBox.Center.x) + boundingBox.Extents.x;
+    float radiusZ = std::fabs(boundingBox.Center.z) + boundingBox.Extents.z;
+    mRadius = std::sqrt(radiusX * radiusX + radiusZ * radiusZ);
 
     return true;
 }
 
-void Player::Render()
+void Player::Render(FrustumCuller& culler)
 {
     mModel.Identity();
     mModel.RotateY(mYAngle);
     mModel.Translate(XMVectorGetX(mPosition), XMVectorGetY(mPosition), XMVectorGetZ(mPosition));
-    if (mHealth > 0.0f)
+    // The composite's box contains every child, so one test covers the whole hierarchy
+    if (mHealth > 0.0f && culler.IsVisible(mModel.GetTransformedBoundingBox()))
     {
         mModel.Render();
     }
@@ -80,6 +85,12 @@ bool Player::Strafe(float dt)
     return MoveDirection(dt, mCamera->GetRightDirection());
 }
 
+bool __vectorcall Player::Move(float dt, const DirectX::XMVECTOR& direction)
+{
+    HandleAnimation(dt);
+    return MoveDirection(dt, direction);
+}
+
 void Player::HandleAnimation(float dt)
 {
     ResetTransform();
@@ -135,16 +146,20 @@ bool __vectorcall Player::MoveDirection(float dt, DirectX::XMVECTOR actualDirect
 {
     actualDirection = XMVectorSetY(actualDirection, 0.0f);
     actualDirection = XMVector3Normalize(actualDirection);
-    
-    DirectX::XMVECTOR newPosition;
-    newPosition = mPosition + actualDirection * distanceToWallInFrames * dt * mMoveSpeed;
+
+    // Walls only take away the part of the move that goes into them, so the player slides along them
+    DirectX::XMVECTOR newPosition = mMaze->MoveCapsule(mPosition, mRadius, actualDirection * dt * mMoveSpeed);
+    if (XMVectorGetX(XMVector3LengthSq(newPosition - mPosition)) < 1e-8f)
+    {
+        return false;
+    }
     float newAngle = GetYAngle(actualDirection);
-    if (PositionCollidesWithMaze(newPosition, newAngle))
+    if (PositionCollidesWithEnemies(newPosition, newAngle))
     {
         return false;
     }
 
-    mPosition = mPosition + actualDirection * dt * mMoveSpeed;
+    mPosition = newPosition;
 
     mYAngle = newAngle;
 
@@ -181,18 +196,42 @@ float Player::GetYAngle(const DirectX::XMVECTOR& actualDirection)
     return finalAngle;
 }
 
-bool __vectorcall Player::PositionCollidesWithMaze(const DirectX::XMVECTOR& position, float angle)
+bool __vectorcall Player::PositionCollidesWithEnemies(const DirectX::XMVECTOR& position, float angle)
 {
     mModel.Identity();
     mModel.RotateY(angle);
     mModel.Translate(XMVectorGetX(position), XMVectorGetY(position), XMVectorGetZ(position));
     DirectX::BoundingBox transformedBoundingBox = mModel.GetTransformedBoundingBox();
-    bool result = mMaze->BoundingBoxCollidesWithWalls(transformedBoundingBox);
+    bool result = false;
     if (mMaze->HandleCollisionBetweenBoundingBoxAndEnemies(transformedBoundingBox))
     {
-        mHealth -= 1.0f / 3.f;
-        result |= true;
+        mHealth -= GameRules::kTouchDamage;
+        result = true;
     }
     mModel.Identity();
     return result;
 }
+
+void Player::SaveState(WorldSnapshot& snapshot) const
+{
+    State state;
+    XMStoreFloat3(&state.Position, mPosition);
+    state.YAngle = mYAngle;
+    state.Health = mHealth;
+    state.AnimationTime = mAnimationTime;
+    state.AnimationDelta = mAnimationDelta;
+    snapshot.Write(state);
+    mModel.SaveState(snapshot);
+}
+
+bool Player::LoadState(WorldSnapshot::Reader& reader)
+{
+    State state;
+    CHECK(reader.Read(state), false, "Snapshot has no player");
+    mPosition = XMLoadFloat3(&state.Position);
+    mYAngle = state.YAngle;
+    mHealth = state.Health;
+    mAnimationTime = state.AnimationTime;
+    mAnimationDelta = state.AnimationDelta;
+    return mModel.LoadState(reader);
+}
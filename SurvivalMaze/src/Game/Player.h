@@ -6,33 +6,48 @@
 #include "Camera.h"
 #include "Maze.h"
 #include "ThirdPersonCamera.h"
+#include "FrustumCuller.h"
 
 
 OBLIVION_ALIGN(16)
 class Player
 {
-    static constexpr const float distanceToWallInFrames = 2;
+public:
+    struct State
+    {
+        DirectX::XMFLOAT3 Position;
+        float YAngle;
+        float Health;
+        float AnimationTime;
+        int32_t AnimationDelta;
+    };
+
 public:
     Player() = default;
     ~Player() = default;
 
 public:
     bool Create(Model* usedModel, Maze* maze);
-    void Render();
+    void Render(FrustumCuller& culler);
     void RenderDebug(BatchRenderer& renderer);
 
     bool Walk(float dt);
     bool Strafe(float dt);
+    // Walks along direction instead of following the camera, for agents
+    bool __vectorcall Move(float dt, const DirectX::XMVECTOR& direction);
     void HandleAnimation(float dt);
     void ResetAnimation();
 
     void SetCamera(ICamera* camera);
 
+    void SaveState(WorldSnapshot& snapshot) const;
+    bool LoadState(WorldSnapshot::Reader& reader);
+
 private:
     void ResetTransform();
     bool __vectorcall MoveDirection(float dt, DirectX::XMVECTOR actualDirection);
     float GetYAngle(const DirectX::XMVECTOR& actualDirection);
-    bool __vectorcall PositionCollidesWithMaze(const DirectX::XMVECTOR& position, float angle);
+    bool __vectorcall PositionCollidesWithEnemies(const DirectX::XMVECTOR& position, float angle);
 
 public:
     ICamera* mCamera;
@@ -50,8 +65,10 @@ public:
 
     DirectX::XMVECTOR mPosition;
     float mYAngle = 0.0f;
+    // Of the capsule walls are resolved against, big enough to hold the model at any angle
+    float mRadius = 1.0f;
 
-    float mMoveSpeed = 3.0f;
+    float mMoveSpeed = GameRules::kPlayerSpeed;
     float mAnimationSpeed = 3.0f;
     float mAnimationTime = 0.0f;
     int mAnimationDelta = 1;
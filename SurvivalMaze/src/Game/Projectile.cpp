@@ -1,4 +1,5 @@
 #include "Projectile.h"
+#include "BoxTransform.h"
 
 using namespace DirectX;
 
@@ -30,17 +31,9 @@ void Projectile::Update(float dt)
 
         mProjectileModel->GetInstanceInfo(mInstanceID).WorldMatrix = worldMatrix;
 
-        mLifetime -= dt;
-        if (mLifetime < 0.0f)
-        {
-            mActive = false;
-        }
-
         if (mMaze)
         {
-            BoundingBox currentBoundingBox;
-            const auto& boundingBox = mProjectileModel->GetBoundingBox();
-            boundingBox.Transform(currentBoundingBox, worldMatrix);
+            auto currentBoundingBox = BoxTransform::Transform(mProjectileModel->GetBoundingBox(), worldMatrix);
             if (mMaze->HandleCollisionBetweenBoundingBoxAndEnemies(currentBoundingBox))
             {
                 SetActive(false);
@@ -49,18 +42,22 @@ void Projectile::Update(float dt)
     }
 }
 
-void Projectile::Render()
+void Projectile::Render(FrustumCuller& culler)
 {
     if (mActive)
     {
-        mProjectileModel->AddCurrentInstance(mInstanceID);
+        auto currentBoundingBox = BoxTransform::Transform(mProjectileModel->GetBoundingBox(),
+            mProjectileModel->GetInstanceInfo(mInstanceID).WorldMatrix);
+        if (culler.IsVisible(currentBoundingBox))
+        {
+            mProjectileModel->AddCurrentInstance(mInstanceID);
+        }
     }
 }
 
-void Projectile::SetActive(bool active, float lifetime)
+void Projectile::SetActive(bool active)
 {
     mActive = active;
-    mLifetime = lifetime;
 }
 
 void __vectorcall Projectile::SetPosition(const XMVECTOR& position)
@@ -77,3 +74,26 @@ bool Projectile::IsActive() const
 {
     return mActive;
 }
+
+XMFLOAT3 Projectile::GetPosition() const
+{
+    XMFLOAT3 position;
+    XMStoreFloat3(&position, mPosition);
+    return position;
+}
+
+void Projectile::SaveState(State& state) const
+{
+    XMStoreFloat3(&state.Position, mPosition);
+    XMStoreFloat3(&state.Direction, mDirection);
+    state.Active = mActive ? 1 : 0;
+    XMStoreFloat4x4(&state.WorldMatrix, mProjectileModel->GetInstanceInfo(mInstanceID).WorldMatrix);
+}
+
+void Projectile::LoadState(const State& state)
+{
+    mPosition = XMLoadFloat3(&state.Position);
+    mDirection = XMLoadFloat3(&state.Direction);
+    mActive = state.Active != 0;
+    mProjectileModel->GetInstanceInfo(mInstanceID).WorldMatrix = XMLoadFloat4x4(&state.WorldMatrix);
+}
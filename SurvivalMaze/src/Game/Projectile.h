@@ -3,25 +3,40 @@
 
 #include <Model.h>
 #include "Maze.h"
+#include "FrustumCuller.h"
 
 
 class Projectile
 {
+public:
+    struct State
+    {
+        DirectX::XMFLOAT3 Position;
+        DirectX::XMFLOAT3 Direction;
+        uint32_t Active;
+        DirectX::XMFLOAT4X4 WorldMatrix;
+    };
+
 public:
     bool Create(Model* projectileModel, Maze* maze);
     void Update(float dt);
-    void Render();
+    void Render(FrustumCuller& culler);
 
-    void SetActive(bool active, float lifetime = 5.0f);
+    // How long it stays active is up to ProjectileManager
+    void SetActive(bool active);
 
     void __vectorcall SetPosition(const DirectX::XMVECTOR& position);
     void __vectorcall SetDirection(const DirectX::XMVECTOR& direction);
 
     bool IsActive() const;
+    DirectX::XMFLOAT3 GetPosition() const;
+
+    void SaveState(State& state) const;
+    void LoadState(const State& state);
 
 private:
     static constexpr const float scale = 0.5f;
-    static constexpr const float speed = 5.0f;
+    static constexpr const float speed = GameRules::kProjectileSpeed;
 
     Model* mProjectileModel;
     Maze* mMaze;
@@ -30,7 +45,6 @@ private:
     DirectX::XMVECTOR mDirection;
 
     bool mActive = false;
-    float mLifetime = 0.0f;
 
     uint32_t mInstanceID;
 };
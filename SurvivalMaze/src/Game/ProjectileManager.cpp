@@ -3,6 +3,8 @@
 bool ProjectileManager::Create(Model* projectileModel, Maze* maze, uint32_t maxNumProjectiles)
 {
     mProjectiles.resize((size_t)maxNumProjectiles);
+    mExpiryTimers.assign((size_t)maxNumProjectiles, TimerWheel::kNoTimer);
+    mExpiryTimes.assign((size_t)maxNumProjectiles, 0.0);
     for (auto& projectile : mProjectiles)
     {
         projectile.Create(projectileModel, maze);
@@ -12,31 +14,117 @@ bool ProjectileManager::Create(Model* projectileModel, Maze* maze, uint32_t maxN
 
 void ProjectileManager::Update(float dt)
 {
-    for (auto& projectile : mProjectiles)
+    mTime += dt;
+    for (std::size_t i = 0; i < mProjectiles.size(); ++i)
     {
+        auto& projectile = mProjectiles[i];
+        if (!projectile.IsActive())
+        {
+            continue;
+        }
         projectile.Update(dt);
+        if (!projectile.IsActive())
+        {
+            // Hit an enemy before its lifetime was over
+            mTimers.Cancel(mExpiryTimers[i]);
+            mExpiryTimers[i] = TimerWheel::kNoTimer;
+        }
     }
+    mTimers.Advance(mTime);
+}
+
+void ProjectileManager::Activate(uint32_t projectile, double expiryTime)
+{
+    mProjectiles[projectile].SetActive(true);
+    mExpiryTimes[projectile] = expiryTime;
+    mExpiryTimers[projectile] = mTimers.Add(expiryTime,
+        [this, projectile]()
+        {
+            mProjectiles[projectile].SetActive(false);
+            mExpiryTimers[projectile] = TimerWheel::kNoTimer;
+        });
 }
 
-void ProjectileManager::Render()
+void ProjectileManager::Render(FrustumCuller& culler)
 {
     for (auto& projectile : mProjectiles)
     {
-        projectile.Render();
+        projectile.Render(culler);
     }
 }
 
 bool __vectorcall ProjectileManager::SpawnProjectile(const DirectX::XMVECTOR& position, const DirectX::XMVECTOR& direction)
 {
-    for (auto& projectile : mProjectiles)
+    for (uint32_t i = 0; i < (uint32_t)mProjectiles.size(); ++i)
     {
+        auto& projectile = mProjectiles[i];
         if (!projectile.IsActive())
         {
             projectile.SetPosition(position);
             projectile.SetDirection(direction);
-            projectile.SetActive(true);
+            Activate(i, mTime + kLifetime);
             return true;
         }
     }
     return false;
 }
+
+void ProjectileManager::Reset()
+{
+    mTimers.Reset(mTime);
+    for (std::size_t i = 0; i < mProjectiles.size(); ++i)
+    {
+        mProjectiles[i].SetActive(false);
+        mExpiryTimers[i] = TimerWheel::kNoTimer;
+    }
+}
+
+void ProjectileManager::Spectate(SpectatorFrame& frame) const
+{
+    for (uint32_t i = 0; i < (uint32_t)mProjectiles.size(); ++i)
+    {
+        if (!mProjectiles[i].IsActive())
+        {
+            continue;
+        }
+        auto position = mProjectiles[i].GetPosition();
+        frame.Entities.push_back({ SpectatorEntity::MakeId(SpectatorEntityKind::Projectile, i), 0,
+            position.x, position.y, position.z, 0.0f });
+    }
+}
+
+void ProjectileManager::SaveState(WorldSnapshot& snapshot) const
+{
+    auto* states = snapshot.Allocate<Projectile::State>(mProjectiles.size());
+    for (std::size_t i = 0; i < mProjectiles.size(); ++i)
+    {
+        mProjectiles[i].SaveState(states[i]);
+    }
+    // What is left of the lifetimes, the timers themselves aren't saved
+    auto* lifetimes = snapshot.Allocate<float>(mProjectiles.size());
+    for (std::size_t i = 0; i < mProjectiles.size(); ++i)
+    {
+        lifetimes[i] = mProjectiles[i].IsActive() ? (float)(mExpiryTimes[i] - mTime) : 0.0f;
+    }
+}
+
+bool ProjectileManager::LoadState(WorldSnapshot::Reader& reader)
+{
+    std::size_t count;
+    const auto* states = reader.Read<Projectile::State>(count);
+    CHECK(states && count == mProjectiles.size(), false, "Snapshot has {} projectiles instead of {}", count, mProjectiles.size());
+    std::size_t numLifetimes;
+    const auto* lifetimes = reader.Read<float>(numLifetimes);
+    CHECK(lifetimes && numLifetimes == count, false, "Snapshot has no lifetimes for its projectiles");
+    mTimers.Reset(mTime);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        mProjectiles[i].LoadState(states[i]);
+        mExpiryTimers[i] = TimerWheel::kNoTimer;
+        if (mProjectiles[i].IsActive())
+        {
+            Activate((uint32_t)i, mTime + lifetimes[i]);
+        }
+    }
+    return true;
+}
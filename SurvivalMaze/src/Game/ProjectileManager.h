@@ -4,6 +4,7 @@
 
 #include "Projectile.h"
 #include "Maze.h"
+#include "TimerWheel.h"
 
 
 
@@ -12,12 +13,33 @@ class ProjectileManager
 public:
     bool Create(Model* projectileModel, Maze* maze, uint32_t maxNumProjectiles);
     void Update(float dt);
-    void Render();
+    void Render(FrustumCuller& culler);
 
     bool __vectorcall SpawnProjectile(const DirectX::XMVECTOR& position, const DirectX::XMVECTOR& direction);
+    // Deactivates every projectile, for when the maze they fly in is replaced
+    void Reset();
+
+    // Adds the active projectiles
+    void Spectate(SpectatorFrame& frame) const;
+
+    void SaveState(WorldSnapshot& snapshot) const;
+    bool LoadState(WorldSnapshot::Reader& reader);
 
 private:
-    std::vector<Projectile> mProjectiles;
+    // Until expiryTime
+    void Activate(uint32_t projectile, double expiryTime);
 
+private:
+    static constexpr const float kLifetime = GameRules::kProjectileLifetime;
+
+private:
+    std::pmr::vector<Projectile> mProjectiles{ MemoryTracker::Get().GetResource(MemoryTag::Projectiles) };
+
+    // Projectiles are deactivated by a timer once their lifetime is over, instead of counting it down every tick
+    double mTime = 0.0;
+    TimerWheel mTimers{ Maze::kTimerTickTime, MemoryTracker::Get().GetResource(MemoryTag::Projectiles) };
+    // One per projectile, for the active ones
+    std::pmr::vector<TimerWheel::TimerId> mExpiryTimers{ MemoryTracker::Get().GetResource(MemoryTag::Projectiles) };
+    std::pmr::vector<double> mExpiryTimes{ MemoryTracker::Get().GetResource(MemoryTag::Projectiles) };
 };
 
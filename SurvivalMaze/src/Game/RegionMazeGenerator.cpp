@@ -0,0 +1,202 @@
+#include "RegionMazeGenerator.h"
+
+
+namespace
+{
+    struct Region
+    {
+        uint32_t firstCellX, firstCellY;
+        uint32_t numCellsX, numCellsY;
+    };
+
+    uint64_t SplitMix64(uint64_t value)
+    {
+        value += 0x9E3779B97F4A7C15ull;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+    std::mt19937 CreateRegionGenerator(uint32_t seed, std::size_t regionIndex)
+    {
+        auto mixed = SplitMix64(((uint64_t)seed << 32) ^ (uint64_t)regionIndex);
+        std::seed_seq sequence{ (uint32_t)mixed, (uint32_t)(mixed >> 32) };
+        return std::mt19937(sequence);
+    }
+
+    // Frees a tile and gives it the same chance of holding an enemy as any carved tile
+    void Carve(MazeGrid& grid, int32_t row, int32_t col, std::mt19937& generator, float enemyProbability)
+    {
+        std::uniform_real_distribution<float> chanceDistribution(0.0f, 1.0f);
+        grid.Set(row, col, chanceDistribution(generator) <= enemyProbability ? TileType::Enemy : TileType::Free);
+    }
+
+    // Iterative randomized depth first search, so the region becomes a spanning tree of its cells
+    void CarveRegion(MazeGrid& grid, const Region& region, std::mt19937& generator, float enemyProbability)
+    {
+        constexpr int dirY[] = { 1, -1, 0, 0 };
+        constexpr int dirX[] = { 0, 0, 1, -1 };
+
+        std::vector<uint8_t> visitedCells((std::size_t)region.numCellsX * region.numCellsY, 0);
+        std::vector<uint32_t> st;
+
+        std::uniform_int_distribution<uint32_t> startDistribution(0, (uint32_t)visitedCells.size() - 1);
+        uint32_t startCell = startDistribution(generator);
+        st.push_back(startCell);
+        visitedCells[startCell] = 1;
+        Carve(grid, 2 * (region.firstCellY + startCell / region.numCellsX) + 1,
+            2 * (region.firstCellX + startCell % region.numCellsX) + 1, generator, enemyProbability);
+
+        while (!st.empty()) {
+            uint32_t currentCell = st.back();
+            int32_t cellX = (int32_t)(currentCell % region.numCellsX);
+            int32_t cellY = (int32_t)(currentCell / region.numCellsX);
+
+            uint32_t availableDirections[4];
+            uint32_t numAvailableDirections = 0;
+            for (uint32_t i = 0; i < 4; ++i) {
+                int32_t neighbourX = cellX + dirX[i];
+                int32_t neighbourY = cellY + dirY[i];
+                if (neighbourX < 0 || neighbourY < 0 ||
+                    neighbourX >= (int32_t)region.numCellsX || neighbourY >= (int32_t)region.numCellsY) {
+                    continue;
+                }
+                if (visitedCells[(std::size_t)neighbourY * region.numCellsX + neighbourX]) {
+                    continue;
+                }
+                availableDirections[numAvailableDirections++] = i;
+            }
+
+            if (numAvailableDirections == 0) {
+                st.pop_back();
+                continue;
+            }
+
+            std::uniform_int_distribution<uint32_t> directionDistribution(0, numAvailableDirections - 1);
+            uint32_t direction = availableDirections[directionDistribution(generator)];
+            int32_t nextX = cellX + dirX[direction];
+            int32_t nextY = cellY + dirY[direction];
+            uint32_t nextCell = (uint32_t)nextY * region.numCellsX + (uint32_t)nextX;
+            visitedCells[nextCell] = 1;
+            st.push_back(nextCell);
+
+            int32_t tileY = 2 * ((int32_t)region.firstCellY + cellY) + 1;
+            int32_t tileX = 2 * ((int32_t)region.firstCellX + cellX) + 1;
+            Carve(grid, tileY + dirY[direction], tileX + dirX[direction], generator, enemyProbability);
+            Carve(grid, tileY + 2 * dirY[direction], tileX + 2 * dirX[direction], generator, enemyProbability);
+        }
+    }
+
+    uint32_t FindRoot(std::vector<uint32_t>& parents, uint32_t node)
+    {
+        while (parents[node] != node) {
+            parents[node] = parents[parents[node]];
+            node = parents[node];
+        }
+        return node;
+    }
+}
+
+TileCoordinates RegionMazeGenerator::Generate(MazeGrid& grid, uint32_t seed, ThreadPool& threadPool,
+    float enemyProbability, uint32_t regionSize)
+{
+    const uint32_t numCellsX = (grid.GetCols() - 1) / 2;
+    const uint32_t numCellsY = (grid.GetRows() - 1) / 2;
+    regionSize = std::max(regionSize, 1u);
+    const uint32_t numRegionsX = (numCellsX + regionSize - 1) / regionSize;
+    const uint32_t numRegionsY = (numCellsY + regionSize - 1) / regionSize;
+
+    std::vector<Region> regions;
+    regions.reserve((std::size_t)numRegionsX * numRegionsY);
+    for (uint32_t i = 0; i < numRegionsY; ++i) {
+        for (uint32_t j = 0; j < numRegionsX; ++j) {
+            Region region;
+            region.firstCellX = j * regionSize;
+            region.firstCellY = i * regionSize;
+            region.numCellsX = std::min(regionSize, numCellsX - region.firstCellX);
+            region.numCellsY = std::min(regionSize, numCellsY - region.firstCellY);
+            regions.push_back(region);
+        }
+    }
+
+    // Regions never share a tile, so they can be carved without any synchronization
+    threadPool.ParallelFor(regions.size(), [&](std::size_t regionIndex)
+    {
+        auto generator = CreateRegionGenerator(seed, regionIndex);
+        CarveRegion(grid, regions[regionIndex], generator, enemyProbability);
+    });
+
+    // Stitch the regions with a random spanning tree (randomized Kruskal) over the region graph.
+    // Each tree edge opens exactly one passage through the wall between the two regions
+    auto generator = CreateRegionGenerator(seed, regions.size());
+    struct RegionEdge {
+        uint32_t first, second;
+        bool horizontal; // second is to the right of first
+    };
+    std::vector<RegionEdge> edges;
+    for (uint32_t i = 0; i < numRegionsY; ++i) {
+        for (uint32_t j = 0; j < numRegionsX; ++j) {
+            uint32_t index = i * numRegionsX + j;
+            if (j + 1 < numRegionsX) {
+                edges.push_back({ index, index + 1, true });
+            }
+            if (i + 1 < numRegionsY) {
+                edges.push_back({ index, index + numRegionsX, false });
+            }
+        }
+    }
+    std::shuffle(edges.begin(), edges.end(), generator);
+
+    std::vector<uint32_t> parents(regions.size());
+    for (uint32_t i = 0; i < parents.size(); ++i) {
+        parents[i] = i;
+    }
+    for (const auto& edge : edges) {
+        auto firstRoot = FindRoot(parents, edge.first);
+        auto secondRoot = FindRoot(parents, edge.second);
+        if (firstRoot == secondRoot) {
+            continue;
+        }
+        parents[firstRoot] = secondRoot;
+
+        const auto& second = regions[edge.second];
+        if (edge.horizontal) {
+            std::uniform_int_distribution<uint32_t> cellDistribution(0, second.numCellsY - 1);
+            int32_t row = 2 * (int32_t)(second.firstCellY + cellDistribution(generator)) + 1;
+            Carve(grid, row, 2 * (int32_t)second.firstCellX, generator, enemyProbability);
+        } else {
+            std::uniform_int_distribution<uint32_t> cellDistribution(0, second.numCellsX - 1);
+            int32_t col = 2 * (int32_t)(second.firstCellX + cellDistribution(generator)) + 1;
+            Carve(grid, 2 * (int32_t)second.firstCellY, col, generator, enemyProbability);
+        }
+    }
+
+    // Single exit: open the wall between a random border cell and the edge of the grid
+    std::uniform_int_distribution<uint32_t> sideDistribution(0, 3);
+    auto side = sideDistribution(generator);
+    if (side < 2) {
+        std::uniform_int_distribution<uint32_t> cellDistribution(0, numCellsX - 1);
+        int32_t col = 2 * (int32_t)cellDistribution(generator) + 1;
+        int32_t firstRow = side == 0 ? 0 : 2 * (int32_t)numCellsY;
+        int32_t lastRow = side == 0 ? 0 : (int32_t)grid.GetRows() - 1;
+        for (int32_t row = firstRow; row <= lastRow; ++row) {
+            grid.Set(row, col, TileType::Free);
+        }
+    } else {
+        std::uniform_int_distribution<uint32_t> cellDistribution(0, numCellsY - 1);
+        int32_t row = 2 * (int32_t)cellDistribution(generator) + 1;
+        int32_t firstCol = side == 2 ? 0 : 2 * (int32_t)numCellsX;
+        int32_t lastCol = side == 2 ? 0 : (int32_t)grid.GetCols() - 1;
+        for (int32_t col = firstCol; col <= lastCol; ++col) {
+            grid.Set(row, col, TileType::Free);
+        }
+    }
+
+    TileCoordinates startPosition = {
+        2 * (int32_t)(numCellsX / 2) + 1,
+        2 * (int32_t)(numCellsY / 2) + 1,
+    };
+    grid.Set(startPosition.y, startPosition.x, TileType::Free);
+
+    return startPosition;
+}
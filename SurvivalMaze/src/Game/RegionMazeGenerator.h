@@ -0,0 +1,23 @@
+#pragma once
+
+
+#include "MazeGrid.h"
+#include "ThreadPool.h"
+
+
+// Generates a perfect maze (exactly one path between any two free tiles) with a single exit.
+// Cells sit on odd coordinates and the tiles between them are walls or passages.
+// The cell grid is split in square regions that are carved independently on a thread pool,
+// each with its own random stream. The regions are then stitched together along a spanning tree
+// of the region graph by opening exactly one passage per tree edge, which keeps the maze perfect.
+// The output only depends on the seed, not on the number of threads.
+class RegionMazeGenerator
+{
+public:
+    static constexpr const uint32_t kDefaultRegionSize = 128; // In cells
+
+public:
+    // Returns the start position. The grid must be at least 3x3 and filled with walls
+    static TileCoordinates Generate(MazeGrid& grid, uint32_t seed, ThreadPool& threadPool,
+        float enemyProbability = 0.1f, uint32_t regionSize = kDefaultRegionSize);
+};
@@ -0,0 +1,329 @@
+#include "SimWorld.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+SimWorld::SimWorld(std::pmr::memory_resource* memory) :
+    mTiles(memory), mEnemies(memory), mEnemyTimers(memory), mTimers(GameRules::kTimerTickTime, memory), mProjectiles(memory)
+{
+}
+
+void SimWorld::Reset(const Config& config, uint32_t seed)
+{
+    mConfig = config;
+    mGenerator.seed(seed);
+    float wallMin[3] = { -config.wallHalfExtent, -config.wallHalfExtent, -config.wallHalfExtent };
+    float wallMax[3] = { config.wallHalfExtent, config.wallHalfExtent, config.wallHalfExtent };
+    mLayout = GameRules::GetWallLayout(config.rows, config.cols, config.tileSize, wallMin, wallMax);
+
+    MazeGrid grid(config.rows, config.cols);
+    auto start = grid.Lee(mGenerator, config.enemyProbability);
+    mTiles.assign(grid.GetTiles(), grid.GetTiles() + (std::size_t)config.rows * config.cols);
+
+    mTime = 0.0;
+    mTimers.Reset(mTime);
+    // Lee stops carving at the first border tile it reaches, that's the way out
+    mExit = start;
+    mEnemies.clear();
+    for (uint32_t i = 0; i < config.rows; ++i) {
+        for (uint32_t j = 0; j < config.cols; ++j) {
+            auto tile = mTiles[(std::size_t)i * config.cols + j];
+            bool border = i == 0 || j == 0 || i == config.rows - 1 || j == config.cols - 1;
+            if (border && tile != TileType::Wall) {
+                mExit = { (int32_t)j, (int32_t)i };
+            }
+            if (tile == TileType::Enemy) {
+                float position[3] = { GetTileCenterX(j), 0.0f, GetTileCenterZ(i) };
+                mEnemies.emplace_back().Spawn(position);
+            }
+        }
+    }
+
+    mPlayerX = GetTileCenterX(start.x);
+    mPlayerZ = GetTileCenterZ(start.y);
+    mRemainingTime = config.maximumTime;
+    mProjectiles.clear();
+    mProjectiles.reserve(config.maxProjectiles);
+    mStatistics = {};
+    mStatistics.health = 1.0f;
+    ScheduleEnemies();
+}
+
+SimWorld::Outcome SimWorld::Step(const Action& action, float dt)
+{
+    if (mStatistics.outcome != Outcome::Running) {
+        return mStatistics.outcome;
+    }
+
+    // Same order as Application::OnUpdate: the player's input and the timer, projectiles, then enemies. Everything
+    // before the enemies sees them where they were at the end of the last step, and only then does the time move on
+    MovePlayer(action.moveX, action.moveZ, dt);
+    float aimLength = std::sqrt(action.aimX * action.aimX + action.aimZ * action.aimZ);
+    if (action.shoot && aimLength > 0.0f && mProjectiles.size() < mConfig.maxProjectiles) {
+        mProjectiles.push_back({ mPlayerX, mPlayerZ, action.aimX / aimLength, action.aimZ / aimLength, mTime + mConfig.projectileLifetime });
+        mStatistics.numShots++;
+    }
+    mRemainingTime -= dt;
+
+    UpdateProjectiles(dt);
+    mTime += dt;
+    UpdateEnemies();
+
+    mStatistics.numTicks++;
+    mStatistics.time += dt;
+    auto playerTile = GetPlayerTile();
+    if (mStatistics.health <= 0.0f) {
+        mStatistics.outcome = Outcome::Died;
+    } else if (playerTile.x == mExit.x && playerTile.y == mExit.y) {
+        mStatistics.outcome = Outcome::Escaped;
+    } else if (mRemainingTime < 0.0f) {
+        mStatistics.health = 0.0f;
+        mStatistics.outcome = Outcome::TimedOut;
+    }
+    return mStatistics.outcome;
+}
+
+void SimWorld::UpdateEnemies()
+{
+    // Like Maze::Update, enemies only change level when the player changes chunk
+    auto focusChunk = GameRules::GetChunk(GetPlayerTile());
+    if (focusChunk.x != mScheduledFocusChunk.x || focusChunk.y != mScheduledFocusChunk.y) {
+        ScheduleEnemies();
+    }
+    mTimers.Advance(mTime);
+}
+
+void SimWorld::UpdateProjectiles(float dt)
+{
+    for (auto& projectile : mProjectiles) {
+        projectile.x += projectile.directionX * dt * mConfig.projectileSpeed;
+        projectile.z += projectile.directionZ * dt * mConfig.projectileSpeed;
+
+        uint32_t numKilled = KillEnemiesTouching(projectile.x, projectile.z, mConfig.projectileHalfExtent);
+        mStatistics.numEnemiesKilled += numKilled;
+        if (numKilled > 0) {
+            projectile.expiryTime = mTime;
+        }
+    }
+    mProjectiles.erase(std::remove_if(mProjectiles.begin(), mProjectiles.end(),
+        // Like ProjectileManager, whose clock is already at the end of the step
+        [this, dt](const Projectile& projectile) { return projectile.expiryTime <= mTime + dt; }), mProjectiles.end());
+}
+
+void SimWorld::MovePlayer(float moveX, float moveZ, float dt)
+{
+    float length = std::sqrt(moveX * moveX + moveZ * moveZ);
+    if (length == 0.0f) {
+        return;
+    }
+    float speed = dt * mConfig.playerSpeed / length;
+    float x = mPlayerX, z = mPlayerZ;
+    GridCollision::MoveCircle(mLayout, [this](int64_t row, int64_t col) { return IsWall(row, col); },
+        x, z, mConfig.playerRadius, moveX * speed, moveZ * speed);
+
+    // Like Player::PositionCollidesWithEnemies: touching enemies hurts, kills them and blocks the move
+    uint32_t numTouched = KillEnemiesTouching(x, z, mConfig.playerRadius);
+    if (numTouched > 0) {
+        mStatistics.numEnemiesTouched += numTouched;
+        mStatistics.health -= GameRules::kTouchDamage;
+        return;
+    }
+    mPlayerX = x;
+    mPlayerZ = z;
+}
+
+uint32_t SimWorld::KillEnemiesTouching(float x, float z, float halfExtent)
+{
+    GameRules::Footprint box = { x, z, halfExtent, halfExtent };
+    uint32_t numKilled = 0;
+    for (uint32_t i = 0; i < (uint32_t)mEnemies.size(); ++i) {
+        auto& enemy = mEnemies[i];
+        if (enemy.IsDying() || GetSimulationLevel(i) == GameRules::SimulationLevel::Far) {
+            continue;
+        }
+        float position[3];
+        enemy.GetPosition((float)mTime, position);
+        if (GameRules::Touches({ position[0], position[2], mConfig.enemyHalfExtent, mConfig.enemyHalfExtent }, box)) {
+            numKilled++;
+            enemy.Die((float)mTime);
+            enemy.SetUpdateTime(mTime);
+            Unschedule(i);
+            Schedule(i);
+        }
+    }
+    return numKilled;
+}
+
+void SimWorld::ScheduleEnemies()
+{
+    for (auto timer : mEnemyTimers) {
+        mTimers.Cancel(timer);
+    }
+    mScheduledFocusChunk = GameRules::GetChunk(GetPlayerTile());
+    mEnemyTimers.assign(mEnemies.size(), TimerWheel::kNoTimer);
+    for (uint32_t i = 0; i < (uint32_t)mEnemies.size(); ++i) {
+        Schedule(i);
+    }
+}
+
+GameRules::SimulationLevel SimWorld::GetSimulationLevel(uint32_t enemyIndex) const
+{
+    const auto& enemy = mEnemies[enemyIndex];
+    if (enemy.IsDying()) {
+        return GameRules::SimulationLevel::Near;
+    }
+    const float* position = enemy.GetInitialPosition();
+    TileCoordinates tile = { (int32_t)GridCollision::GetCol(mLayout, position[0]), (int32_t)GridCollision::GetRow(mLayout, position[2]) };
+    return GameRules::GetSimulationLevel(GameRules::GetChunk(tile), mScheduledFocusChunk,
+        mConfig.simulationNearRadius, std::max(mConfig.simulationMidRadius, mConfig.simulationNearRadius));
+}
+
+void SimWorld::Schedule(uint32_t enemyIndex)
+{
+    mEnemyTimers[enemyIndex] = TimerWheel::kNoTimer;
+    double wakeTime = GameRules::GetResumeTime(GetSimulationLevel(enemyIndex), mEnemies[enemyIndex].GetWakeTime());
+    if (wakeTime == kBehaviourDone) {
+        return;
+    }
+    mEnemyTimers[enemyIndex] = mTimers.Add(wakeTime, [this, enemyIndex]() { ResumeEnemy(enemyIndex); });
+}
+
+void SimWorld::Unschedule(uint32_t enemyIndex)
+{
+    mTimers.Cancel(mEnemyTimers[enemyIndex]);
+    mEnemyTimers[enemyIndex] = TimerWheel::kNoTimer;
+}
+
+void SimWorld::ResumeEnemy(uint32_t enemyIndex)
+{
+    mEnemyTimers[enemyIndex] = TimerWheel::kNoTimer;
+    auto& enemy = mEnemies[enemyIndex];
+    enemy.Resume(mTime, mGenerator);
+    if (enemy.ShouldDie()) {
+        RemoveEnemy(enemyIndex);
+        return;
+    }
+    Schedule(enemyIndex);
+}
+
+void SimWorld::RemoveEnemy(uint32_t enemyIndex)
+{
+    Unschedule(enemyIndex);
+    auto lastEnemy = (uint32_t)mEnemies.size() - 1;
+    bool moved = enemyIndex != lastEnemy && mEnemyTimers[lastEnemy] != TimerWheel::kNoTimer;
+    if (enemyIndex != lastEnemy) {
+        // Its timer knows it by its index, so it gets a new one at the same wake time
+        Unschedule(lastEnemy);
+        mEnemies[enemyIndex] = mEnemies[lastEnemy];
+    }
+    mEnemies.pop_back();
+    mEnemyTimers.pop_back();
+    if (moved) {
+        Schedule(enemyIndex);
+    }
+}
+
+void SimWorld::Observe(AgentObservation& observation) const
+{
+    auto playerTile = GetPlayerTile();
+    observation.Health = mStatistics.health;
+    observation.RemainingTime = mRemainingTime;
+    observation.PlayerX = mPlayerX;
+    observation.PlayerZ = mPlayerZ;
+    observation.PlayerRow = playerTile.y;
+    observation.PlayerCol = playerTile.x;
+    observation.Outcome = (uint32_t)mStatistics.outcome;
+
+    for (int32_t i = 0; i < (int32_t)kObservationWidth; ++i) {
+        int64_t row = (int64_t)playerTile.y + i - kObservationRadius;
+        for (int32_t j = 0; j < (int32_t)kObservationWidth; ++j) {
+            int64_t col = (int64_t)playerTile.x + j - kObservationRadius;
+            bool inside = row >= 0 && col >= 0 && row < (int64_t)mConfig.rows && col < (int64_t)mConfig.cols;
+            observation.Tiles[i * kObservationWidth + j] = inside ? (uint8_t)mTiles[(std::size_t)row * mConfig.cols + col] : kObservedOutside;
+        }
+    }
+
+    observation.NumEnemies = 0;
+    for (uint32_t i = 0; i < (uint32_t)mEnemies.size(); ++i) {
+        // What the game draws
+        if (!mEnemies[i].IsDying() && GetSimulationLevel(i) != GameRules::SimulationLevel::Far) {
+            float position[3];
+            mEnemies[i].GetPosition((float)mTime, position);
+            AgentChannel::AddEnemy(observation, position[0], position[2]);
+        }
+    }
+}
+
+const SimWorld::Statistics& SimWorld::GetStatistics() const
+{
+    return mStatistics;
+}
+
+const SimWorld::Config& SimWorld::GetConfig() const
+{
+    return mConfig;
+}
+
+const GridLayout& SimWorld::GetLayout() const
+{
+    return mLayout;
+}
+
+const TileType* SimWorld::GetTiles() const
+{
+    return mTiles.data();
+}
+
+TileCoordinates SimWorld::GetExit() const
+{
+    return mExit;
+}
+
+TileCoordinates SimWorld::GetPlayerTile() const
+{
+    return { (int32_t)GridCollision::GetCol(mLayout, mPlayerX), (int32_t)GridCollision::GetRow(mLayout, mPlayerZ) };
+}
+
+float SimWorld::GetPlayerX() const
+{
+    return mPlayerX;
+}
+
+float SimWorld::GetPlayerZ() const
+{
+    return mPlayerZ;
+}
+
+double SimWorld::GetTime() const
+{
+    return mTime;
+}
+
+const std::pmr::vector<EnemyBehaviour>& SimWorld::GetEnemies() const
+{
+    return mEnemies;
+}
+
+const std::pmr::vector<SimWorld::Projectile>& SimWorld::GetProjectiles() const
+{
+    return mProjectiles;
+}
+
+bool SimWorld::IsWall(int64_t row, int64_t col) const
+{
+    if (row < 0 || col < 0 || row >= (int64_t)mConfig.rows || col >= (int64_t)mConfig.cols) {
+        return false;
+    }
+    return mTiles[(std::size_t)row * mConfig.cols + col] == TileType::Wall;
+}
+
+float SimWorld::GetTileCenterX(int64_t col) const
+{
+    return ((float)col - (float)mConfig.cols / 2.0f) * mConfig.tileSize;
+}
+
+float SimWorld::GetTileCenterZ(int64_t row) const
+{
+    return ((float)row - (float)mConfig.rows / 2.0f) * mConfig.tileSize;
+}
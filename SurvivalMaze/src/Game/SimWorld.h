@@ -0,0 +1,144 @@
+#pragma once
+
+
+#include <cstdint>
+#include <memory_resource>
+#include <random>
+#include <vector>
+
+#include "AgentChannel.h"
+#include "EnemyBehaviour.h"
+#include "GameRules.h"
+#include "GridCollision.h"
+#include "MazeGrid.h"
+#include "TimerWheel.h"
+
+
+// Runs episodes of the game without a device: bots, difficulty tuning, tests. The rules themselves are shared with the
+// game (see GameRules and EnemyBehaviour), only the models are left out: the player and the projectiles are points with
+// the sizes of their models, and the walls are boxes of the cube model's size. Enemies are scheduled on a TimerWheel by
+// simulation level, like Maze does.
+// Every allocation made while an episode runs comes from the memory resource given to the constructor
+class SimWorld {
+public:
+    // Defaults to the game's settings
+    struct Config {
+        uint32_t rows = 21;
+        uint32_t cols = 21;
+        float tileSize = GameRules::kTileSize;
+        float enemyProbability = GameRules::kEnemyProbability;
+
+        float maximumTime = GameRules::kMaximumTime;
+        float playerSpeed = GameRules::kPlayerSpeed;
+        float playerRadius = GameRules::kPlayerRadius;
+        float enemyHalfExtent = GameRules::kEnemyHalfExtent;
+        float projectileHalfExtent = GameRules::kProjectileHalfExtent;
+        float wallHalfExtent = GameRules::kWallHalfExtent;
+        float projectileSpeed = GameRules::kProjectileSpeed;
+        float projectileLifetime = GameRules::kProjectileLifetime;
+        uint32_t maxProjectiles = GameRules::kMaximumProjectiles;
+
+        // See Maze::MazeInitializationInfo
+        uint32_t simulationNearRadius = GameRules::kSimulationNearRadius;
+        uint32_t simulationMidRadius = GameRules::kSimulationMidRadius;
+    };
+
+    enum class Outcome : uint8_t {
+        Running = 0,
+        Escaped, // Reached the tile where the maze opens on its border
+        Died,
+        TimedOut,
+    };
+
+    struct Action {
+        // Direction to walk in, doesn't have to be normalized. Zero to stand still
+        float moveX, moveZ;
+        bool shoot;
+        float aimX, aimZ;
+    };
+
+    struct Projectile {
+        float x, z;
+        float directionX, directionZ;
+        double expiryTime;
+    };
+
+    struct Statistics {
+        Outcome outcome;
+        uint32_t numTicks;
+        float time;
+        float health;
+        uint32_t numEnemiesKilled; // By projectiles
+        uint32_t numEnemiesTouched;
+        uint32_t numShots;
+    };
+
+public:
+    explicit SimWorld(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+    SimWorld(const SimWorld&) = delete;
+    SimWorld& operator=(const SimWorld&) = delete;
+
+public:
+    // Generates a new maze with the Lee generator, like Maze does, and puts the player at its start
+    void Reset(const Config& config, uint32_t seed);
+    // Advances the world by dt, returns the outcome after the step
+    Outcome Step(const Action& action, float dt);
+
+    // Fills everything but the tick
+    void Observe(AgentObservation& observation) const;
+
+    const Statistics& GetStatistics() const;
+    const Config& GetConfig() const;
+    const GridLayout& GetLayout() const;
+
+    const TileType* GetTiles() const;
+    TileCoordinates GetExit() const;
+    TileCoordinates GetPlayerTile() const;
+    float GetPlayerX() const;
+    float GetPlayerZ() const;
+    // Since the episode started, what the enemies' positions are a function of
+    double GetTime() const;
+    // Including the far ones, which are frozen
+    const std::pmr::vector<EnemyBehaviour>& GetEnemies() const;
+    const std::pmr::vector<Projectile>& GetProjectiles() const;
+
+    bool IsWall(int64_t row, int64_t col) const;
+    float GetTileCenterX(int64_t col) const;
+    float GetTileCenterZ(int64_t row) const;
+
+private:
+    void UpdateEnemies();
+    void UpdateProjectiles(float dt);
+    void MovePlayer(float moveX, float moveZ, float dt);
+    // Like Maze::HandleCollisionBetweenBoundingBoxAndEnemies, kills every enemy the box touches and returns how many
+    uint32_t KillEnemiesTouching(float x, float z, float halfExtent);
+
+    // The same scheduling as Maze, see Maze::ScheduleEnemies
+    void ScheduleEnemies();
+    GameRules::SimulationLevel GetSimulationLevel(uint32_t enemyIndex) const;
+    void Schedule(uint32_t enemyIndex);
+    void Unschedule(uint32_t enemyIndex);
+    void ResumeEnemy(uint32_t enemyIndex);
+    void RemoveEnemy(uint32_t enemyIndex);
+
+private:
+    Config mConfig;
+    GridLayout mLayout;
+    std::mt19937 mGenerator;
+
+    std::pmr::vector<TileType> mTiles;
+    TileCoordinates mExit;
+
+    float mPlayerX, mPlayerZ;
+    float mRemainingTime;
+    double mTime = 0.0;
+
+    std::pmr::vector<EnemyBehaviour> mEnemies;
+    std::pmr::vector<TimerWheel::TimerId> mEnemyTimers;
+    TimerWheel mTimers;
+    TileCoordinates mScheduledFocusChunk = { -1, -1 };
+    std::pmr::vector<Projectile> mProjectiles;
+
+    Statistics mStatistics;
+};
@@ -0,0 +1,360 @@
+#include "SpectatorCodec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+static constexpr float kTwoPi = 6.28318530718f;
+static constexpr float kMaxQuantized = 1073741824.0f; // 2^30, far outside of any maze
+
+static uint32_t FloatBits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float BitsFloat(uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Deltas wrap around, which both sides agree on, so they are exact even between far apart values
+static uint32_t ZigZag(uint32_t delta)
+{
+    return (delta << 1) ^ (uint32_t)((int32_t)delta >> 31);
+}
+
+static uint32_t UnZigZag(uint32_t value)
+{
+    return (value >> 1) ^ (0u - (value & 1));
+}
+
+static int32_t QuantizePosition(float value)
+{
+    return (int32_t)std::lround(std::clamp(value / kSpectatorPositionStep, -kMaxQuantized, kMaxQuantized));
+}
+
+static uint32_t QuantizeHeading(float heading)
+{
+    float turns = heading / kTwoPi;
+    turns -= std::floor(turns);
+    return (uint32_t)std::lround(turns * (1 << kSpectatorHeadingBits)) & ((1u << kSpectatorHeadingBits) - 1);
+}
+
+BitWriter::BitWriter(std::vector<uint8_t>& bytes) :
+    mBytes(bytes)
+{
+}
+
+void BitWriter::Write(uint32_t value, uint32_t numBits)
+{
+    if (numBits == 0)
+    {
+        return;
+    }
+    uint64_t mask = numBits == 32 ? 0xFFFFFFFFull : ((1ull << numBits) - 1);
+    mAccumulator |= ((uint64_t)value & mask) << mNumBits;
+    mNumBits += numBits;
+    while (mNumBits >= 8)
+    {
+        mBytes.push_back((uint8_t)mAccumulator);
+        mAccumulator >>= 8;
+        mNumBits -= 8;
+    }
+}
+
+void BitWriter::WriteExpGolomb(uint32_t value)
+{
+    // value + 1 = 1xxx (n bits after the leading one) is written as n zeros, the one, then the n bits
+    uint64_t shifted = (uint64_t)value + 1;
+    uint32_t n = 0;
+    while ((shifted >> (n + 1)) != 0)
+    {
+        n++;
+    }
+    Write(0, std::min(n, 31u));
+    Write(0, n - std::min(n, 31u));
+    Write(1, 1);
+    Write((uint32_t)shifted, n);
+}
+
+void BitWriter::Flush()
+{
+    if (mNumBits > 0)
+    {
+        mBytes.push_back((uint8_t)mAccumulator);
+    }
+    mAccumulator = 0;
+    mNumBits = 0;
+}
+
+BitReader::BitReader(const uint8_t* data, std::size_t size) :
+    mData(data), mSize(size)
+{
+}
+
+uint32_t BitReader::Read(uint32_t numBits)
+{
+    if (numBits == 0 || mFailed)
+    {
+        return 0;
+    }
+    if (mBitOffset + numBits > mSize * 8)
+    {
+        mFailed = true;
+        return 0;
+    }
+    std::size_t byte = mBitOffset >> 3;
+    uint32_t shift = (uint32_t)(mBitOffset & 7);
+    uint64_t value = 0;
+    for (uint32_t i = 0; i * 8 < shift + numBits; ++i)
+    {
+        value |= (uint64_t)mData[byte + i] << (8 * i);
+    }
+    mBitOffset += numBits;
+    value >>= shift;
+    return (uint32_t)(numBits == 32 ? value : value & ((1ull << numBits) - 1));
+}
+
+uint32_t BitReader::ReadExpGolomb()
+{
+    uint32_t n = 0;
+    while (Read(1) == 0)
+    {
+        if (mFailed || ++n > 32)
+        {
+            mFailed = true;
+            return 0;
+        }
+    }
+    uint64_t shifted = (1ull << n) | Read(n);
+    return (uint32_t)(shifted - 1);
+}
+
+bool BitReader::Failed() const
+{
+    return mFailed;
+}
+
+QuantizedFrame& SpectatorHistory::Add(uint32_t tick)
+{
+    auto& frame = mFrames[tick % kSpectatorHistorySize];
+    frame.Tick = tick;
+    return frame;
+}
+
+const QuantizedFrame* SpectatorHistory::Find(uint32_t tick) const
+{
+    if (tick == kSpectatorNoBaseline)
+    {
+        return nullptr;
+    }
+    const auto& frame = mFrames[tick % kSpectatorHistorySize];
+    return frame.Tick == tick ? &frame : nullptr;
+}
+
+namespace SpectatorCodec
+{
+    void Quantize(const SpectatorFrame& frame, QuantizedFrame& quantized)
+    {
+        quantized.Tick = frame.Tick;
+        quantized.Health = frame.Health;
+        quantized.RemainingTime = frame.RemainingTime;
+        quantized.Entities.resize(frame.Entities.size());
+        for (std::size_t i = 0; i < frame.Entities.size(); ++i)
+        {
+            const auto& entity = frame.Entities[i];
+            quantized.Entities[i] = { entity.Id, entity.Flags, QuantizePosition(entity.X), QuantizePosition(entity.Y),
+                QuantizePosition(entity.Z), QuantizeHeading(entity.Heading) };
+        }
+        std::sort(quantized.Entities.begin(), quantized.Entities.end(),
+            [](const QuantizedEntity& lhs, const QuantizedEntity& rhs) { return lhs.Id < rhs.Id; });
+    }
+
+    void Dequantize(const QuantizedFrame& quantized, SpectatorFrame& frame)
+    {
+        frame.Tick = quantized.Tick;
+        frame.Health = quantized.Health;
+        frame.RemainingTime = quantized.RemainingTime;
+        frame.Entities.resize(quantized.Entities.size());
+        for (std::size_t i = 0; i < quantized.Entities.size(); ++i)
+        {
+            const auto& entity = quantized.Entities[i];
+            frame.Entities[i] = { entity.Id, entity.Flags, entity.X * kSpectatorPositionStep, entity.Y * kSpectatorPositionStep,
+                entity.Z * kSpectatorPositionStep, entity.Heading * kTwoPi / (1 << kSpectatorHeadingBits) };
+        }
+    }
+
+    void Encode(const QuantizedFrame& frame, const QuantizedFrame* baseline, BitWriter& writer)
+    {
+        writer.Write(frame.Tick, 32);
+        writer.Write(baseline ? baseline->Tick : kSpectatorNoBaseline, 32);
+        writer.Write(FloatBits(frame.Health), 32);
+        writer.Write(FloatBits(frame.RemainingTime), 32);
+
+        const auto& entities = frame.Entities;
+        std::size_t numKept = 0;
+        if (baseline)
+        {
+            // One bit per baseline entity for whether it's still there, then what changed
+            std::size_t j = 0;
+            for (const auto& previous : baseline->Entities)
+            {
+                while (j < entities.size() && entities[j].Id < previous.Id)
+                {
+                    j++;
+                }
+                if (j == entities.size() || entities[j].Id != previous.Id)
+                {
+                    writer.Write(0, 1);
+                    continue;
+                }
+                writer.Write(1, 1);
+                numKept++;
+
+                const auto& current = entities[j];
+                bool moved = current.X != previous.X || current.Y != previous.Y || current.Z != previous.Z;
+                bool turned = current.Heading != previous.Heading;
+                bool flagged = current.Flags != previous.Flags;
+                if (!moved && !turned && !flagged)
+                {
+                    writer.Write(0, 1);
+                    continue;
+                }
+                writer.Write(1, 1);
+                writer.Write(moved, 1);
+                if (moved)
+                {
+                    writer.WriteExpGolomb(ZigZag((uint32_t)current.X - (uint32_t)previous.X));
+                    writer.WriteExpGolomb(ZigZag((uint32_t)current.Y - (uint32_t)previous.Y));
+                    writer.WriteExpGolomb(ZigZag((uint32_t)current.Z - (uint32_t)previous.Z));
+                }
+                writer.Write(turned, 1);
+                if (turned)
+                {
+                    writer.Write(current.Heading, kSpectatorHeadingBits);
+                }
+                writer.Write(flagged, 1);
+                if (flagged)
+                {
+                    writer.WriteExpGolomb(current.Flags);
+                }
+            }
+        }
+
+        // Then the entities the baseline doesn't have, in full. Ids are sent as the gap to the previous one
+        writer.WriteExpGolomb((uint32_t)(entities.size() - numKept));
+        std::size_t i = 0;
+        uint32_t nextId = 0;
+        for (const auto& current : entities)
+        {
+            if (baseline)
+            {
+                const auto& previous = baseline->Entities;
+                while (i < previous.size() && previous[i].Id < current.Id)
+                {
+                    i++;
+                }
+                if (i < previous.size() && previous[i].Id == current.Id)
+                {
+                    continue;
+                }
+            }
+            writer.WriteExpGolomb(current.Id - nextId);
+            nextId = current.Id + 1;
+            writer.WriteExpGolomb(current.Flags);
+            writer.WriteExpGolomb(ZigZag((uint32_t)current.X));
+            writer.WriteExpGolomb(ZigZag((uint32_t)current.Y));
+            writer.WriteExpGolomb(ZigZag((uint32_t)current.Z));
+            writer.Write(current.Heading, kSpectatorHeadingBits);
+        }
+        writer.Flush();
+    }
+
+    bool DecodeHeader(BitReader& reader, uint32_t& tick, uint32_t& baselineTick)
+    {
+        tick = reader.Read(32);
+        baselineTick = reader.Read(32);
+        return !reader.Failed();
+    }
+
+    bool DecodeBody(BitReader& reader, const QuantizedFrame* baseline, QuantizedFrame& frame)
+    {
+        frame.Health = BitsFloat(reader.Read(32));
+        frame.RemainingTime = BitsFloat(reader.Read(32));
+
+        auto& entities = frame.Entities;
+        entities.clear();
+        if (baseline)
+        {
+            for (const auto& previous : baseline->Entities)
+            {
+                if (!reader.Read(1))
+                {
+                    continue;
+                }
+                auto current = previous;
+                if (reader.Read(1))
+                {
+                    if (reader.Read(1))
+                    {
+                        current.X = (int32_t)((uint32_t)previous.X + UnZigZag(reader.ReadExpGolomb()));
+                        current.Y = (int32_t)((uint32_t)previous.Y + UnZigZag(reader.ReadExpGolomb()));
+                        current.Z = (int32_t)((uint32_t)previous.Z + UnZigZag(reader.ReadExpGolomb()));
+                    }
+                    if (reader.Read(1))
+                    {
+                        current.Heading = reader.Read(kSpectatorHeadingBits);
+                    }
+                    if (reader.Read(1))
+                    {
+                        current.Flags = reader.ReadExpGolomb();
+                    }
+                }
+                entities.push_back(current);
+            }
+        }
+        if (reader.Failed())
+        {
+            return false;
+        }
+
+        std::size_t numKept = entities.size();
+        uint32_t numNew = reader.ReadExpGolomb();
+        // Every new entity takes more than 8 bits, don't trust a count that can't be right
+        if (reader.Failed() || numNew > 1u << 24)
+        {
+            return false;
+        }
+        uint64_t nextId = 0;
+        for (uint32_t i = 0; i < numNew && !reader.Failed(); ++i)
+        {
+            QuantizedEntity current;
+            uint64_t id = nextId + reader.ReadExpGolomb();
+            if (id > 0xFFFFFFFFull)
+            {
+                return false;
+            }
+            current.Id = (uint32_t)id;
+            nextId = id + 1;
+            current.Flags = reader.ReadExpGolomb();
+            current.X = (int32_t)UnZigZag(reader.ReadExpGolomb());
+            current.Y = (int32_t)UnZigZag(reader.ReadExpGolomb());
+            current.Z = (int32_t)UnZigZag(reader.ReadExpGolomb());
+            current.Heading = reader.Read(kSpectatorHeadingBits);
+            entities.push_back(current);
+        }
+        if (reader.Failed())
+        {
+            return false;
+        }
+        // Both halves are sorted already
+        std::inplace_merge(entities.begin(), entities.begin() + numKept, entities.end(),
+            [](const QuantizedEntity& lhs, const QuantizedEntity& rhs) { return lhs.Id < rhs.Id; });
+        return true;
+    }
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+
+#include <cstdint>
+#include <vector>
+
+
+// What spectators see of a tick and how it goes over the wire. Positions are quantized to kPositionStep, so a
+// spectator reconstructs them within half a step, and every frame is encoded against a frame the spectator already
+// has (the last one it acknowledged), bit-packed with exp-Golomb codes: an entity that didn't move costs 2 bits,
+// a small move a handful. Frames with no baseline, for spectators that just connected, hold everything.
+// Doesn't depend on the renderer, the same code runs in the game and in the spectator tools
+
+constexpr float kSpectatorPositionStep = 1.0f / 64.0f;
+constexpr uint32_t kSpectatorHeadingBits = 8;
+constexpr uint32_t kSpectatorHistorySize = 64; // Frames a baseline can be taken from, on both sides
+constexpr uint32_t kSpectatorNoBaseline = 0xFFFFFFFF;
+
+enum class SpectatorEntityKind : uint32_t
+{
+    Player = 0,
+    Enemy,
+    Projectile,
+};
+
+struct SpectatorEntity
+{
+    static constexpr const uint32_t kIndexBits = 28;
+
+    static uint32_t MakeId(SpectatorEntityKind kind, uint32_t index)
+    {
+        return ((uint32_t)kind << kIndexBits) | (index & ((1u << kIndexBits) - 1));
+    }
+    SpectatorEntityKind GetKind() const
+    {
+        return (SpectatorEntityKind)(Id >> kIndexBits);
+    }
+
+    uint32_t Id; // Unique in the frame, see MakeId
+    uint32_t Flags; // Enemies: 1 when dying
+    float X, Y, Z;
+    float Heading; // Radians around Y
+};
+
+struct SpectatorFrame
+{
+    uint32_t Tick = 0;
+    float Health = 0.0f;
+    float RemainingTime = 0.0f;
+    std::vector<SpectatorEntity> Entities; // Any order when published, sorted by Id when received
+};
+
+// Frames as they are encoded, the encoder and decoder only deal with these so deltas are exact and never drift
+struct QuantizedEntity
+{
+    uint32_t Id;
+    uint32_t Flags;
+    int32_t X, Y, Z;
+    uint32_t Heading;
+};
+
+struct QuantizedFrame
+{
+    uint32_t Tick = kSpectatorNoBaseline;
+    float Health = 0.0f;
+    float RemainingTime = 0.0f;
+    std::vector<QuantizedEntity> Entities; // Sorted by Id
+};
+
+class BitWriter
+{
+public:
+    explicit BitWriter(std::vector<uint8_t>& bytes);
+
+public:
+    // At most 32 bits at a time
+    void Write(uint32_t value, uint32_t numBits);
+    // Values close to 0 take the fewest bits, 0 takes one
+    void WriteExpGolomb(uint32_t value);
+    // Pads the last byte with zeros
+    void Flush();
+
+private:
+    std::vector<uint8_t>& mBytes;
+    uint64_t mAccumulator = 0;
+    uint32_t mNumBits = 0;
+};
+
+class BitReader
+{
+public:
+    BitReader(const uint8_t* data, std::size_t size);
+
+public:
+    // Reads zeros, and the reader fails, past the end
+    uint32_t Read(uint32_t numBits);
+    uint32_t ReadExpGolomb();
+
+    bool Failed() const;
+
+private:
+    const uint8_t* mData;
+    std::size_t mSize;
+    std::size_t mBitOffset = 0;
+    bool mFailed = false;
+};
+
+// The last kSpectatorHistorySize frames, by tick
+class SpectatorHistory
+{
+public:
+    QuantizedFrame& Add(uint32_t tick);
+    // Null when the frame is too old or never made it
+    const QuantizedFrame* Find(uint32_t tick) const;
+
+private:
+    QuantizedFrame mFrames[kSpectatorHistorySize];
+};
+
+namespace SpectatorCodec
+{
+    // Sorts the entities by Id
+    void Quantize(const SpectatorFrame& frame, QuantizedFrame& quantized);
+    void Dequantize(const QuantizedFrame& quantized, SpectatorFrame& frame);
+
+    // Without a baseline, every entity is sent in full
+    void Encode(const QuantizedFrame& frame, const QuantizedFrame* baseline, BitWriter& writer);
+    // The receiver looks the baseline up between the two
+    bool DecodeHeader(BitReader& reader, uint32_t& tick, uint32_t& baselineTick);
+    bool DecodeBody(BitReader& reader, const QuantizedFrame* baseline, QuantizedFrame& frame);
+}
@@ -0,0 +1,496 @@
+#include "SpectatorStream.h"
+
+#include <chrono>
+#include <cstring>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+using NativeSocket = SOCKET;
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+using NativeSocket = int;
+#endif
+
+
+// Both the server and the clients only ever talk to the loopback interface
+static constexpr uint32_t kMaxPacketSize = 64 * 1024 * 1024;
+
+#if defined(_WIN32)
+static bool InitSockets()
+{
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+}
+
+static void ShutdownSockets()
+{
+    WSACleanup();
+}
+
+static void CloseSocket(intptr_t handle)
+{
+    closesocket((NativeSocket)handle);
+}
+
+static bool SetNonBlocking(intptr_t handle)
+{
+    u_long mode = 1;
+    return ioctlsocket((NativeSocket)handle, FIONBIO, &mode) == 0;
+}
+
+static bool WouldBlock()
+{
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+
+static constexpr int kSendFlags = 0;
+#else
+static bool InitSockets()
+{
+    return true;
+}
+
+static void ShutdownSockets()
+{
+}
+
+static void CloseSocket(intptr_t handle)
+{
+    close((NativeSocket)handle);
+}
+
+static bool SetNonBlocking(intptr_t handle)
+{
+    int flags = fcntl((NativeSocket)handle, F_GETFL, 0);
+    return flags != -1 && fcntl((NativeSocket)handle, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static bool WouldBlock()
+{
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+// A spectator closing its end must not kill the game with SIGPIPE
+#if defined(MSG_NOSIGNAL)
+static constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+static constexpr int kSendFlags = 0;
+#endif
+#endif
+
+static void SetNoDelay(intptr_t handle)
+{
+    // Packets and acks are sent as soon as they are ready, waiting to coalesce them only adds latency
+    int noDelay = 1;
+    setsockopt((NativeSocket)handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+}
+
+static sockaddr_in MakeLoopbackAddress(uint16_t port)
+{
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return address;
+}
+
+SpectatorServer::~SpectatorServer()
+{
+    Stop();
+}
+
+bool SpectatorServer::Start(uint16_t port)
+{
+    Stop();
+    if (!InitSockets())
+    {
+        return false;
+    }
+    auto listenSocket = (intptr_t)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listenSocket == -1)
+    {
+        ShutdownSockets();
+        return false;
+    }
+#if !defined(_WIN32)
+    // Restarting the game right away must not fail because of the last run's connections
+    int reuse = 1;
+    setsockopt((NativeSocket)listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+    auto address = MakeLoopbackAddress(port);
+    socklen_t addressSize = sizeof(address);
+    if (bind((NativeSocket)listenSocket, (const sockaddr*)&address, sizeof(address)) != 0 ||
+        listen((NativeSocket)listenSocket, 8) != 0 ||
+        getsockname((NativeSocket)listenSocket, (sockaddr*)&address, &addressSize) != 0 ||
+        !SetNonBlocking(listenSocket))
+    {
+        CloseSocket(listenSocket);
+        ShutdownSockets();
+        return false;
+    }
+    mListenSocket = listenSocket;
+    mPort = ntohs(address.sin_port);
+    mStop = false;
+    mHasPending = false;
+    mHistory = SpectatorHistory();
+    mRunning = true;
+    mThread = std::thread(&SpectatorServer::Run, this);
+    return true;
+}
+
+void SpectatorServer::Stop()
+{
+    if (!mRunning)
+    {
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mCondition.notify_one();
+    mThread.join();
+
+    for (auto& client : mClients)
+    {
+        CloseSocket(client.Socket);
+    }
+    mClients.clear();
+    mNumClients = 0;
+    CloseSocket(mListenSocket);
+    mListenSocket = -1;
+    ShutdownSockets();
+    mRunning = false;
+}
+
+bool SpectatorServer::IsRunning() const
+{
+    return mRunning;
+}
+
+uint16_t SpectatorServer::GetPort() const
+{
+    return mPort;
+}
+
+SpectatorFrame& SpectatorServer::BeginPublish()
+{
+    return mPublishing;
+}
+
+void SpectatorServer::EndPublish()
+{
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        std::swap(mPublishing, mPending);
+        mHasPending = true;
+    }
+    mCondition.notify_one();
+}
+
+SpectatorServer::Statistics SpectatorServer::GetStatistics() const
+{
+    return { mNumClients.load(std::memory_order_relaxed), mNumFramesSent.load(std::memory_order_relaxed),
+        mNumFramesSkipped.load(std::memory_order_relaxed), mNumBytesSent.load(std::memory_order_relaxed) };
+}
+
+void SpectatorServer::Run()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true)
+    {
+        // Wakes up now and then without frames too, to accept spectators and read their acks
+        mCondition.wait_for(lock, std::chrono::milliseconds(10), [this] { return mHasPending || mStop; });
+        if (mStop)
+        {
+            break;
+        }
+        bool hasFrame = mHasPending;
+        if (hasFrame)
+        {
+            std::swap(mPending, mEncoding);
+            mHasPending = false;
+        }
+        lock.unlock();
+
+        AcceptClients();
+        for (auto& client : mClients)
+        {
+            if (!ReceiveAcks(client) || !SendPending(client))
+            {
+                CloseSocket(client.Socket);
+                client.Socket = -1;
+            }
+        }
+        if (hasFrame)
+        {
+            auto& frame = mHistory.Add(mEncoding.Tick);
+            SpectatorCodec::Quantize(mEncoding, frame);
+            SendFrame(frame);
+        }
+        for (std::size_t i = 0; i < mClients.size();)
+        {
+            if (mClients[i].Socket == -1)
+            {
+                std::swap(mClients[i], mClients.back());
+                mClients.pop_back();
+                continue;
+            }
+            ++i;
+        }
+        mNumClients.store((uint32_t)mClients.size(), std::memory_order_relaxed);
+
+        lock.lock();
+    }
+}
+
+void SpectatorServer::AcceptClients()
+{
+    while (true)
+    {
+        auto clientSocket = (intptr_t)accept((NativeSocket)mListenSocket, nullptr, nullptr);
+        if (clientSocket == -1)
+        {
+            return;
+        }
+        if (!SetNonBlocking(clientSocket))
+        {
+            CloseSocket(clientSocket);
+            continue;
+        }
+        SetNoDelay(clientSocket);
+        Client client;
+        client.Socket = clientSocket;
+        mClients.push_back(std::move(client));
+    }
+}
+
+bool SpectatorServer::ReceiveAcks(Client& client)
+{
+    while (true)
+    {
+        auto received = recv((NativeSocket)client.Socket, (char*)client.Incoming + client.NumIncoming,
+            4 - client.NumIncoming, 0);
+        if (received == 0)
+        {
+            return false;
+        }
+        if (received < 0)
+        {
+            return WouldBlock();
+        }
+        client.NumIncoming += (uint32_t)received;
+        if (client.NumIncoming == 4)
+        {
+            // Acks arrive in order, the last one is the newest frame the client has
+            client.AckedTick = (uint32_t)client.Incoming[0] | ((uint32_t)client.Incoming[1] << 8) |
+                ((uint32_t)client.Incoming[2] << 16) | ((uint32_t)client.Incoming[3] << 24);
+            client.NumIncoming = 0;
+        }
+    }
+}
+
+bool SpectatorServer::SendPending(Client& client)
+{
+    while (client.NumSent < client.Outgoing.size())
+    {
+        auto sent = send((NativeSocket)client.Socket, (const char*)client.Outgoing.data() + client.NumSent,
+            (int)(client.Outgoing.size() - client.NumSent), kSendFlags);
+        if (sent < 0)
+        {
+            return WouldBlock();
+        }
+        client.NumSent += (std::size_t)sent;
+        mNumBytesSent.fetch_add((uint64_t)sent, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void SpectatorServer::SendFrame(const QuantizedFrame& frame)
+{
+    mNumPackets = 0;
+    for (auto& client : mClients)
+    {
+        if (client.Socket == -1)
+        {
+            continue;
+        }
+        if (client.NumSent < client.Outgoing.size())
+        {
+            mNumFramesSkipped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        const auto* baseline = mHistory.Find(client.AckedTick);
+        uint32_t baselineTick = baseline ? baseline->Tick : kSpectatorNoBaseline;
+        const std::vector<uint8_t>* packet = nullptr;
+        for (std::size_t i = 0; i < mNumPackets && !packet; ++i)
+        {
+            if (mPackets[i].first == baselineTick)
+            {
+                packet = &mPackets[i].second;
+            }
+        }
+        if (!packet)
+        {
+            if (mNumPackets == mPackets.size())
+            {
+                mPackets.emplace_back();
+            }
+            auto& encoded = mPackets[mNumPackets++];
+            encoded.first = baselineTick;
+            encoded.second.clear();
+            encoded.second.resize(4);
+            BitWriter writer(encoded.second);
+            SpectatorCodec::Encode(frame, baseline, writer);
+            uint32_t size = (uint32_t)encoded.second.size() - 4;
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                encoded.second[i] = (uint8_t)(size >> (8 * i));
+            }
+            packet = &encoded.second;
+        }
+
+        client.Outgoing.assign(packet->begin(), packet->end());
+        client.NumSent = 0;
+        mNumFramesSent.fetch_add(1, std::memory_order_relaxed);
+        if (!SendPending(client))
+        {
+            CloseSocket(client.Socket);
+            client.Socket = -1;
+        }
+    }
+}
+
+SpectatorClient::~SpectatorClient()
+{
+    Close();
+}
+
+bool SpectatorClient::Connect(uint16_t port)
+{
+    Close();
+    if (!InitSockets())
+    {
+        return false;
+    }
+    auto clientSocket = (intptr_t)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (clientSocket == -1)
+    {
+        ShutdownSockets();
+        return false;
+    }
+    auto address = MakeLoopbackAddress(port);
+    if (connect((NativeSocket)clientSocket, (const sockaddr*)&address, sizeof(address)) != 0)
+    {
+        CloseSocket(clientSocket);
+        ShutdownSockets();
+        return false;
+    }
+    SetNoDelay(clientSocket);
+    mSocket = clientSocket;
+    mHistory = SpectatorHistory();
+    return true;
+}
+
+void SpectatorClient::Close()
+{
+    if (mSocket == -1)
+    {
+        return;
+    }
+    CloseSocket(mSocket);
+    mSocket = -1;
+    ShutdownSockets();
+}
+
+bool SpectatorClient::Receive(SpectatorFrame& frame)
+{
+    uint8_t sizeBytes[4];
+    if (mSocket == -1 || !ReceiveBytes(sizeBytes, sizeof(sizeBytes)))
+    {
+        return false;
+    }
+    uint32_t size = (uint32_t)sizeBytes[0] | ((uint32_t)sizeBytes[1] << 8) | ((uint32_t)sizeBytes[2] << 16) |
+        ((uint32_t)sizeBytes[3] << 24);
+    if (size > kMaxPacketSize)
+    {
+        return false;
+    }
+    mPacket.resize(size);
+    if (!ReceiveBytes(mPacket.data(), size))
+    {
+        return false;
+    }
+
+    BitReader reader(mPacket.data(), mPacket.size());
+    uint32_t tick, baselineTick;
+    if (!SpectatorCodec::DecodeHeader(reader, tick, baselineTick))
+    {
+        return false;
+    }
+    const auto* baseline = mHistory.Find(baselineTick);
+    if (baselineTick != kSpectatorNoBaseline && !baseline)
+    {
+        return false;
+    }
+    // The new frame may take the baseline's place in the history, so it's decoded on the side first
+    if (!SpectatorCodec::DecodeBody(reader, baseline, mDecoded))
+    {
+        return false;
+    }
+    auto& decoded = mHistory.Add(tick);
+    std::swap(decoded.Entities, mDecoded.Entities);
+    decoded.Health = mDecoded.Health;
+    decoded.RemainingTime = mDecoded.RemainingTime;
+    SpectatorCodec::Dequantize(decoded, frame);
+    mLastPacketSize = size + sizeof(sizeBytes);
+    mLastBaselineTick = baselineTick;
+
+    uint8_t ack[4];
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        ack[i] = (uint8_t)(tick >> (8 * i));
+    }
+    return send((NativeSocket)mSocket, (const char*)ack, sizeof(ack), kSendFlags) == (int)sizeof(ack);
+}
+
+std::size_t SpectatorClient::GetLastPacketSize() const
+{
+    return mLastPacketSize;
+}
+
+uint32_t SpectatorClient::GetLastBaselineTick() const
+{
+    return mLastBaselineTick;
+}
+
+bool SpectatorClient::ReceiveBytes(uint8_t* data, std::size_t size)
+{
+    std::size_t numReceived = 0;
+    while (numReceived < size)
+    {
+        auto received = recv((NativeSocket)mSocket, (char*)data + numReceived, (int)(size - numReceived), 0);
+        if (received <= 0)
+        {
+            return false;
+        }
+        numReceived += (std::size_t)received;
+    }
+    return true;
+}
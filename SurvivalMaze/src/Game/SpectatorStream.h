@@ -0,0 +1,131 @@
+#pragma once
+
+
+#include "SpectatorCodec.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+
+// Streams the frames the game publishes to spectator processes on the same machine, over TCP on the loopback
+// interface. Packets are a 4 byte little endian size followed by a SpectatorCodec frame, and spectators answer every
+// frame they decode with its 4 byte tick, which becomes the baseline of the next frames they get.
+// Encoding and sending happen on the server's own thread, publishing a frame only swaps buffers. A spectator that
+// can't keep up skips frames instead of slowing anything down, the next one it gets is encoded against what it has
+
+class SpectatorServer
+{
+public:
+    struct Statistics
+    {
+        uint32_t NumClients;
+        uint64_t NumFramesSent;
+        uint64_t NumFramesSkipped; // Published while the client was still receiving an older one
+        uint64_t NumBytesSent;
+    };
+
+public:
+    SpectatorServer() = default;
+    ~SpectatorServer();
+
+    SpectatorServer(const SpectatorServer&) = delete;
+    SpectatorServer& operator=(const SpectatorServer&) = delete;
+
+public:
+    // Port 0 picks a free one, see GetPort
+    bool Start(uint16_t port);
+    void Stop();
+
+    bool IsRunning() const;
+    uint16_t GetPort() const;
+
+    // Fill the frame, then hand it to the server with EndPublish. Frames published faster than they are encoded
+    // replace each other
+    SpectatorFrame& BeginPublish();
+    void EndPublish();
+
+    Statistics GetStatistics() const;
+
+private:
+    struct Client
+    {
+        intptr_t Socket = -1;
+        uint32_t AckedTick = kSpectatorNoBaseline;
+        std::vector<uint8_t> Outgoing;
+        std::size_t NumSent = 0;
+        uint8_t Incoming[4] = {};
+        uint32_t NumIncoming = 0;
+    };
+
+private:
+    void Run();
+    void AcceptClients();
+    // False when the client went away
+    bool ReceiveAcks(Client& client);
+    bool SendPending(Client& client);
+    void SendFrame(const QuantizedFrame& frame);
+
+private:
+    intptr_t mListenSocket = -1;
+    uint16_t mPort = 0;
+    std::thread mThread;
+    bool mRunning = false;
+
+    // Written by the game, swapped with mPending under mMutex, encoded from mEncoding
+    SpectatorFrame mPublishing;
+    SpectatorFrame mPending;
+    SpectatorFrame mEncoding;
+    bool mHasPending = false;
+    bool mStop = false;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+
+    // Server thread only
+    std::vector<Client> mClients;
+    SpectatorHistory mHistory;
+    // Packets encoded this frame by baseline tick, so clients with the same baseline share them
+    std::vector<std::pair<uint32_t, std::vector<uint8_t>>> mPackets;
+    std::size_t mNumPackets = 0;
+
+    std::atomic<uint32_t> mNumClients = 0;
+    std::atomic<uint64_t> mNumFramesSent = 0;
+    std::atomic<uint64_t> mNumFramesSkipped = 0;
+    std::atomic<uint64_t> mNumBytesSent = 0;
+};
+
+class SpectatorClient
+{
+public:
+    SpectatorClient() = default;
+    ~SpectatorClient();
+
+    SpectatorClient(const SpectatorClient&) = delete;
+    SpectatorClient& operator=(const SpectatorClient&) = delete;
+
+public:
+    // To a server on this machine
+    bool Connect(uint16_t port);
+    void Close();
+
+    // Waits for the next frame and acknowledges it. False when the server went away or sent something that can't
+    // be decoded
+    bool Receive(SpectatorFrame& frame);
+
+    // Of the last frame received, header included
+    std::size_t GetLastPacketSize() const;
+    // kSpectatorNoBaseline when it was a full frame
+    uint32_t GetLastBaselineTick() const;
+
+private:
+    bool ReceiveBytes(uint8_t* data, std::size_t size);
+
+private:
+    intptr_t mSocket = -1;
+    SpectatorHistory mHistory;
+    QuantizedFrame mDecoded;
+    std::vector<uint8_t> mPacket;
+    std::size_t mLastPacketSize = 0;
+    uint32_t mLastBaselineTick = kSpectatorNoBaseline;
+};
@@ -0,0 +1,212 @@
+#include "TaskGraph.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include <fmt/format.h>
+
+
+TaskGraph::TaskId TaskGraph::Add(std::string name, std::function<bool()> function, std::initializer_list<TaskId> dependencies)
+{
+    return AddTask(std::move(name), std::move(function), dependencies, false);
+}
+
+TaskGraph::TaskId TaskGraph::AddOnWaitingThread(std::string name, std::function<bool()> function, std::initializer_list<TaskId> dependencies)
+{
+    return AddTask(std::move(name), std::move(function), dependencies, true);
+}
+
+TaskGraph::TaskId TaskGraph::AddTask(std::string name, std::function<bool()> function, std::initializer_list<TaskId> dependencies,
+    bool onWaitingThread)
+{
+    auto id = (TaskId)mTasks.size();
+    mTasks.emplace_back();
+    auto& task = mTasks.back();
+    task.name = std::move(name);
+    task.function = std::move(function);
+    task.onWaitingThread = onWaitingThread;
+    for (auto dependency : dependencies)
+    {
+        mTasks[dependency].dependents.push_back(id);
+        task.numDependencies++;
+    }
+    task.numPendingDependencies = task.numDependencies;
+    return id;
+}
+
+void TaskGraph::Start(ThreadPool& threadPool)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mThreadPool = &threadPool;
+    mWaitingThread = std::this_thread::get_id();
+    mStart = std::chrono::steady_clock::now();
+    for (TaskId task = 0; task < (TaskId)mTasks.size(); ++task)
+    {
+        if (mTasks[task].numDependencies == 0)
+        {
+            Schedule(task);
+        }
+    }
+}
+
+bool TaskGraph::Wait(TaskId task)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (!mTasks[task].done)
+    {
+        mCondition.wait(lock, [&]() { return mTasks[task].done || !mWaitingThreadTasks.empty(); });
+        while (!mWaitingThreadTasks.empty())
+        {
+            auto ready = mWaitingThreadTasks.front();
+            mWaitingThreadTasks.pop_front();
+            lock.unlock();
+            Run(ready);
+            lock.lock();
+        }
+    }
+    return mTasks[task].timing.Succeeded;
+}
+
+bool TaskGraph::Poll()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (!mWaitingThreadTasks.empty())
+    {
+        auto ready = mWaitingThreadTasks.front();
+        mWaitingThreadTasks.pop_front();
+        lock.unlock();
+        Run(ready);
+        lock.lock();
+    }
+    return mNumDone == (uint32_t)mTasks.size();
+}
+
+bool TaskGraph::Succeeded() const
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    return mNumDone == (uint32_t)mTasks.size() && !mFailed;
+}
+
+std::string TaskGraph::FormatTimeline() const
+{
+    constexpr uint32_t kBarWidth = 40;
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    std::vector<TaskId> order(mTasks.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+        [&](TaskId lhs, TaskId rhs)
+        {
+            const auto& left = mTasks[lhs].timing;
+            const auto& right = mTasks[rhs].timing;
+            return left.Ran != right.Ran ? left.Ran : left.StartMs < right.StartMs;
+        });
+    double totalMs = 0.0;
+    std::size_t nameWidth = 0;
+    for (const auto& task : mTasks)
+    {
+        totalMs = std::max(totalMs, task.timing.EndMs);
+        nameWidth = std::max(nameWidth, task.name.size());
+    }
+
+    auto timeline = fmt::format("{:.2f} ms, {} tasks on {} threads\n", totalMs, mTasks.size(), mThreads.size() + 1);
+    for (auto id : order)
+    {
+        const auto& task = mTasks[id];
+        const auto& timing = task.timing;
+        if (!timing.Ran)
+        {
+            timeline += fmt::format("  {:<{}}  skipped, a dependency failed\n", task.name, nameWidth);
+            continue;
+        }
+        auto first = totalMs > 0.0 ? (uint32_t)(timing.StartMs / totalMs * kBarWidth) : 0;
+        auto last = totalMs > 0.0 ? (uint32_t)(timing.EndMs / totalMs * kBarWidth) : 0;
+        std::string bar(kBarWidth, '.');
+        for (auto i = std::min(first, kBarWidth - 1); i <= std::min(last, kBarWidth - 1); ++i)
+        {
+            bar[i] = '#';
+        }
+        timeline += fmt::format("  {:<{}}  {:8.2f} - {:8.2f} ms  {:8.2f} ms  thread {}  |{}|{}\n", task.name, nameWidth,
+            timing.StartMs, timing.EndMs, timing.EndMs - timing.StartMs, timing.Thread, bar, timing.Succeeded ? "" : " failed");
+    }
+    return timeline;
+}
+
+const TaskGraph::Timing& TaskGraph::GetTiming(TaskId task) const
+{
+    return mTasks[task].timing;
+}
+
+void TaskGraph::Schedule(TaskId task)
+{
+    if (mTasks[task].onWaitingThread)
+    {
+        mWaitingThreadTasks.push_back(task);
+        mCondition.notify_all();
+        return;
+    }
+    mThreadPool->Submit([this, task]() { Run(task); });
+}
+
+void TaskGraph::Run(TaskId task)
+{
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mTasks[task].timing.Thread = GetThreadIndex(std::this_thread::get_id());
+        mTasks[task].timing.StartMs = GetElapsedMs();
+        mTasks[task].timing.Ran = true;
+    }
+    // Nothing else touches the task while it runs
+    bool succeeded = mTasks[task].function();
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mTasks[task].timing.EndMs = GetElapsedMs();
+    Finish(task, succeeded);
+    mCondition.notify_all();
+}
+
+void TaskGraph::Finish(TaskId task, bool succeeded)
+{
+    auto& finished = mTasks[task];
+    finished.done = true;
+    finished.timing.Succeeded = succeeded;
+    mFailed |= !succeeded;
+    mNumDone++;
+    for (auto id : finished.dependents)
+    {
+        auto& dependent = mTasks[id];
+        dependent.numPendingDependencies--;
+        if (dependent.done)
+        {
+            continue;
+        }
+        if (!succeeded)
+        {
+            Finish(id, false);
+        }
+        else if (dependent.numPendingDependencies == 0)
+        {
+            Schedule(id);
+        }
+    }
+}
+
+uint32_t TaskGraph::GetThreadIndex(std::thread::id thread)
+{
+    if (thread == mWaitingThread)
+    {
+        return 0;
+    }
+    auto found = std::find(mThreads.begin(), mThreads.end(), thread);
+    if (found != mThreads.end())
+    {
+        return (uint32_t)(found - mThreads.begin()) + 1;
+    }
+    mThreads.push_back(thread);
+    return (uint32_t)mThreads.size();
+}
+
+double TaskGraph::GetElapsedMs() const
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStart).count();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Tasks that run as soon as the tasks they depend on are done, on a ThreadPool or, for work that has to stay on one
+// thread (command lists), on the thread that waits on the graph. A task returns false when it fails, and then the
+// tasks depending on it don't run at all. Every task is timed, see FormatTimeline
+class TaskGraph
+{
+public:
+    using TaskId = uint32_t;
+
+    struct Timing
+    {
+        double StartMs, EndMs; // Since Start
+        uint32_t Thread; // 0 for the waiting thread, then in the order threads first ran a task
+        bool Ran, Succeeded;
+    };
+
+public:
+    TaskGraph() = default;
+
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+public:
+    // Dependencies must have been added before. Only before Start
+    TaskId Add(std::string name, std::function<bool()> function, std::initializer_list<TaskId> dependencies = {});
+    TaskId AddOnWaitingThread(std::string name, std::function<bool()> function, std::initializer_list<TaskId> dependencies = {});
+
+    // Submits the tasks without dependencies, and the other ones as they become ready. The pool must outlive the graph's tasks
+    void Start(ThreadPool& threadPool);
+    // Runs the waiting thread's tasks until task is done, true if it succeeded
+    bool Wait(TaskId task);
+    // Runs the waiting thread's tasks that are ready, without blocking. True once every task is done
+    bool Poll();
+    // Once Poll returned true, whether every task ran and succeeded
+    bool Succeeded() const;
+
+    // One line per task in start order, with a bar showing when it ran over the whole graph's time
+    std::string FormatTimeline() const;
+    const Timing& GetTiming(TaskId task) const;
+
+private:
+    struct Task
+    {
+        std::string name;
+        std::function<bool()> function;
+        std::vector<TaskId> dependents;
+        uint32_t numDependencies = 0;
+        uint32_t numPendingDependencies = 0;
+        bool onWaitingThread = false;
+        bool done = false;
+        Timing timing = {};
+    };
+
+private:
+    TaskId AddTask(std::string name, std::function<bool()> function, std::initializer_list<TaskId> dependencies, bool onWaitingThread);
+    // Called with mMutex locked
+    void Schedule(TaskId task);
+    void Run(TaskId task);
+    // Called with mMutex locked. Marks the dependents as done without running them when the task failed
+    void Finish(TaskId task, bool succeeded);
+    uint32_t GetThreadIndex(std::thread::id thread);
+    double GetElapsedMs() const;
+
+private:
+    std::vector<Task> mTasks;
+    ThreadPool* mThreadPool = nullptr;
+    std::chrono::steady_clock::time_point mStart;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<TaskId> mWaitingThreadTasks;
+    uint32_t mNumDone = 0;
+    bool mFailed = false;
+    std::thread::id mWaitingThread;
+    std::vector<std::thread::id> mThreads;
+};
@@ -0,0 +1,49 @@
+#include "ThreadPool.h"
+
+
+ThreadPool::ThreadPool(uint32_t numThreads)
+{
+    numThreads = std::max(numThreads, 1u);
+    mThreads.reserve(numThreads);
+    for (uint32_t i = 0; i < numThreads; ++i)
+    {
+        mThreads.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mCondition.notify_all();
+    for (auto& thread : mThreads)
+    {
+        thread.join();
+    }
+}
+
+uint32_t ThreadPool::GetThreadCount() const
+{
+    return (uint32_t)mThreads.size();
+}
+
+void ThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]() { return mStopping || !mTasks.empty(); });
+            if (mStopping && mTasks.empty())
+            {
+                return;
+            }
+            task = std::move(mTasks.front());
+            mTasks.pop_front();
+        }
+        task();
+    }
+}
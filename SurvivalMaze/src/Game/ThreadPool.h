@@ -0,0 +1,80 @@
+#pragma once
+
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class ThreadPool
+{
+public:
+    explicit ThreadPool(uint32_t numThreads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+public:
+    template <typename Function>
+    auto Submit(Function&& function) -> std::future<decltype(function())>
+    {
+        using ReturnType = decltype(function());
+        auto task = std::make_shared<std::packaged_task<ReturnType()>>(std::forward<Function>(function));
+        auto future = task->get_future();
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mTasks.emplace_back([task]() { (*task)(); });
+        }
+        mCondition.notify_one();
+        return future;
+    }
+
+    // Calls function(index) for every index in [0, count). The calling thread helps too
+    template <typename Function>
+    void ParallelFor(std::size_t count, Function&& function)
+    {
+        std::atomic<std::size_t> nextIndex = 0;
+        auto worker = [&]()
+        {
+            for (auto index = nextIndex++; index < count; index = nextIndex++)
+            {
+                function(index);
+            }
+        };
+
+        std::size_t numHelpers = std::min<std::size_t>(mThreads.size(), count > 0 ? count - 1 : 0);
+        std::vector<std::future<void>> helpers;
+        helpers.reserve(numHelpers);
+        for (std::size_t i = 0; i < numHelpers; ++i)
+        {
+            helpers.push_back(Submit(worker));
+        }
+        worker();
+        for (auto& helper : helpers)
+        {
+            helper.get();
+        }
+    }
+
+    uint32_t GetThreadCount() const;
+
+private:
+    void WorkerLoop();
+
+private:
+    std::vector<std::thread> mThreads;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<std::function<void()>> mTasks;
+    bool mStopping = false;
+};
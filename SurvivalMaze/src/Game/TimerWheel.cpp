@@ -0,0 +1,228 @@
+#include "TimerWheel.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+TimerWheel::TimerWheel(double tickTime, std::pmr::memory_resource* memory) :
+    mTickTime(tickTime), mNodes(memory), mSlots(kNumSlots + 2, kNone, memory)
+{
+}
+
+TimerWheel::TimerId TimerWheel::Add(double time, std::function<void()> callback)
+{
+    uint32_t node = mFreeNodes;
+    if (node != kNone)
+    {
+        mFreeNodes = mNodes[node].next;
+    }
+    else
+    {
+        node = (uint32_t)mNodes.size();
+        mNodes.emplace_back();
+    }
+    auto& timer = mNodes[node];
+    timer.deadline = GetDeadline(time);
+    timer.callback = std::move(callback);
+    Insert(node);
+    mNumPending++;
+    return ((TimerId)timer.generation << 32) | node;
+}
+
+bool TimerWheel::Cancel(TimerId timer)
+{
+    uint32_t node = Find(timer);
+    if (node == kNone)
+    {
+        return false;
+    }
+    Unlink(node);
+    Free(node);
+    mNumPending--;
+    return true;
+}
+
+bool TimerWheel::Reschedule(TimerId timer, double time)
+{
+    uint32_t node = Find(timer);
+    if (node == kNone)
+    {
+        return false;
+    }
+    // Out of whatever slot it is in, the firing one included, and back in like a new timer
+    Unlink(node);
+    mNodes[node].deadline = GetDeadline(time);
+    Insert(node);
+    return true;
+}
+
+void TimerWheel::Advance(double time)
+{
+    if (time < 0.0)
+    {
+        return;
+    }
+    auto lastTick = (uint64_t)std::floor(time / mTickTime);
+    if (mNumPending == 0)
+    {
+        // Nothing can come up, and every slot is empty wherever the wheel stands
+        mCurrentTick = std::max(mCurrentTick, lastTick + 1);
+        return;
+    }
+    constexpr uint64_t kSlotMask = kSlotsPerLevel - 1;
+    while (mCurrentTick <= lastTick && mNumPending > 0)
+    {
+        uint64_t tick = mCurrentTick;
+        if ((tick & kSlotMask) == 0)
+        {
+            // Coarsest first, its timers can move all the way down to the slots cascaded after it
+            if ((tick & ((1ull << (kSlotBits * kNumLevels)) - 1)) == 0)
+            {
+                Cascade(kOverflowSlot);
+            }
+            for (uint32_t level = kNumLevels - 1; level > 0; --level)
+            {
+                if ((tick & ((1ull << (kSlotBits * level)) - 1)) == 0)
+                {
+                    Cascade(level * kSlotsPerLevel + (uint32_t)((tick >> (kSlotBits * level)) & kSlotMask));
+                }
+            }
+        }
+        // Timers the callbacks add for this tick or before go to the next one
+        mCurrentTick = tick + 1;
+        Fire((uint32_t)(tick & kSlotMask));
+    }
+    mCurrentTick = std::max(mCurrentTick, lastTick + 1);
+}
+
+void TimerWheel::Reset(double time)
+{
+    for (uint32_t node = 0; node < (uint32_t)mNodes.size(); ++node)
+    {
+        if (mNodes[node].slot != kFreeSlot)
+        {
+            Free(node);
+        }
+    }
+    std::fill(mSlots.begin(), mSlots.end(), kNone);
+    mNumPending = 0;
+    mCurrentTick = time < 0.0 ? 0 : (uint64_t)std::floor(time / mTickTime) + 1;
+}
+
+uint32_t TimerWheel::GetNumPending() const
+{
+    return mNumPending;
+}
+
+uint64_t TimerWheel::GetDeadline(double time) const
+{
+    double deadline = std::max(std::ceil(time / mTickTime), 0.0);
+    // mCurrentTick is the tick after the one firing while callbacks run, so they never add to it
+    return std::max((uint64_t)deadline, mCurrentTick);
+}
+
+uint32_t TimerWheel::Find(TimerId timer) const
+{
+    auto node = (uint32_t)(timer & 0xffffffffu);
+    auto generation = (uint32_t)(timer >> 32);
+    if (timer == kNoTimer || node >= (uint32_t)mNodes.size() || mNodes[node].generation != generation ||
+        mNodes[node].slot == kFreeSlot)
+    {
+        return kNone;
+    }
+    return node;
+}
+
+void TimerWheel::Insert(uint32_t node)
+{
+    uint64_t deadline = mNodes[node].deadline;
+    for (uint32_t level = 0; level < kNumLevels; ++level)
+    {
+        // In the current slot of the level above, so in this level's wheel
+        uint32_t coarserShift = kSlotBits * (level + 1);
+        if ((deadline >> coarserShift) == (mCurrentTick >> coarserShift))
+        {
+            Link(node, level * kSlotsPerLevel + (uint32_t)((deadline >> (kSlotBits * level)) & (kSlotsPerLevel - 1)));
+            return;
+        }
+    }
+    Link(node, kOverflowSlot);
+}
+
+void TimerWheel::Link(uint32_t node, uint32_t slot)
+{
+    auto& timer = mNodes[node];
+    timer.slot = slot;
+    timer.previous = kNone;
+    timer.next = mSlots[slot];
+    if (timer.next != kNone)
+    {
+        mNodes[timer.next].previous = node;
+    }
+    mSlots[slot] = node;
+}
+
+void TimerWheel::Unlink(uint32_t node)
+{
+    auto& timer = mNodes[node];
+    if (timer.previous != kNone)
+    {
+        mNodes[timer.previous].next = timer.next;
+    }
+    else
+    {
+        mSlots[timer.slot] = timer.next;
+    }
+    if (timer.next != kNone)
+    {
+        mNodes[timer.next].previous = timer.previous;
+    }
+}
+
+void TimerWheel::Free(uint32_t node)
+{
+    auto& timer = mNodes[node];
+    timer.callback = nullptr;
+    timer.slot = kFreeSlot;
+    if (++timer.generation == 0)
+    {
+        timer.generation = 1;
+    }
+    timer.next = mFreeNodes;
+    mFreeNodes = node;
+}
+
+void TimerWheel::Cascade(uint32_t slot)
+{
+    uint32_t node = mSlots[slot];
+    mSlots[slot] = kNone;
+    while (node != kNone)
+    {
+        uint32_t next = mNodes[node].next;
+        Insert(node);
+        node = next;
+    }
+}
+
+void TimerWheel::Fire(uint32_t slot)
+{
+    // Set apart first, a timer added by a callback for a tick kSlotsPerLevel away would land in the same slot
+    uint32_t node = mSlots[slot];
+    mSlots[slot] = kNone;
+    while (node != kNone)
+    {
+        uint32_t next = mNodes[node].next;
+        Link(node, kFiringSlot);
+        node = next;
+    }
+    while (mSlots[kFiringSlot] != kNone)
+    {
+        node = mSlots[kFiringSlot];
+        Unlink(node);
+        // Callbacks can add timers, which can move mNodes
+        auto callback = std::move(mNodes[node].callback);
+        Free(node);
+        mNumPending--;
+        callback();
+    }
+}
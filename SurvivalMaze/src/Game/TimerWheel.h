@@ -0,0 +1,86 @@
+#pragma once
+
+
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <vector>
+
+
+// Deadlines with a callback, for anything in the simulation that waits. Time only moves through Advance, so the wheel
+// has no clock of its own and the same calls always fire the same timers in the same order.
+// Deadlines are rounded up to whole ticks and kept in kNumLevels wheels of kSlotsPerLevel slots, each level kSlotsPerLevel
+// times coarser than the one below: level 0 holds the timers due in the current kSlotsPerLevel ticks, level 1 the ones
+// due in the current kSlotsPerLevel^2 ticks, and so on. A timer moves down a level when the slot it is in comes up, so
+// it is touched at most kNumLevels times before it fires, and adding, cancelling and firing are all O(1).
+// Timers further away than the top level are kept aside and looked at once every kSlotsPerLevel^kNumLevels ticks
+class TimerWheel
+{
+public:
+    // 0 is never a timer
+    using TimerId = uint64_t;
+    static constexpr const TimerId kNoTimer = 0;
+
+    static constexpr const uint32_t kSlotBits = 6;
+    static constexpr const uint32_t kSlotsPerLevel = 1u << kSlotBits;
+    static constexpr const uint32_t kNumLevels = 4;
+
+public:
+    explicit TimerWheel(double tickTime, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+public:
+    // Fires once Advance reaches time, a time already reached fires on the next tick. Callbacks can add and cancel
+    // timers, and a timer added by a callback never fires in the same tick
+    TimerId Add(double time, std::function<void()> callback);
+    // False when the timer already fired or was cancelled
+    bool Cancel(TimerId timer);
+    // Moves the timer to time, keeping its id and callback. Lands on the same tick Add(time) would, from a callback too,
+    // so a timer due this tick and moved to a time already reached fires on the next one. False like Cancel
+    bool Reschedule(TimerId timer, double time);
+    // Fires every timer due up to time, tick by tick
+    void Advance(double time);
+    // Drops every timer and moves the wheel to time, which can be in the past
+    void Reset(double time);
+
+    uint32_t GetNumPending() const;
+
+private:
+    static constexpr const uint32_t kNone = ~0u;
+    static constexpr const uint32_t kNumSlots = kNumLevels * kSlotsPerLevel;
+    static constexpr const uint32_t kOverflowSlot = kNumSlots; // Further away than the top level
+    static constexpr const uint32_t kFiringSlot = kNumSlots + 1; // Due this tick, fired one after the other
+    static constexpr const uint32_t kFreeSlot = kNumSlots + 2;
+
+    struct Node
+    {
+        uint64_t deadline; // In ticks
+        std::function<void()> callback;
+        uint32_t slot = kFreeSlot;
+        uint32_t generation = 1; // Bumped when the node is freed, so old ids stop matching
+        uint32_t previous = kNone, next = kNone; // In the slot, or in the free list
+    };
+
+private:
+    // The tick a timer for time fires on, see Add
+    uint64_t GetDeadline(double time) const;
+    // The node of timer, or kNone when the timer already fired or was cancelled
+    uint32_t Find(TimerId timer) const;
+    void Insert(uint32_t node);
+    void Link(uint32_t node, uint32_t slot);
+    void Unlink(uint32_t node);
+    void Free(uint32_t node);
+    // Moves the timers of slot to where they belong now
+    void Cascade(uint32_t slot);
+    void Fire(uint32_t slot);
+
+private:
+    double mTickTime;
+    uint64_t mCurrentTick = 0; // The next tick Advance fires
+    std::pmr::vector<Node> mNodes;
+    std::pmr::vector<uint32_t> mSlots; // First node of each slot, then of the overflow and the firing timers
+    uint32_t mFreeNodes = kNone;
+    uint32_t mNumPending = 0;
+};
@@ -0,0 +1,78 @@
+#include "WorldSnapshot.h"
+
+#include <algorithm>
+
+
+static std::size_t Align(std::size_t offset)
+{
+    return (offset + WorldSnapshot::kAlignment - 1) & ~(WorldSnapshot::kAlignment - 1);
+}
+
+WorldSnapshot::WorldSnapshot(std::pmr::memory_resource* memory) :
+    mBuffer(memory)
+{
+}
+
+void WorldSnapshot::Clear()
+{
+    mSize = 0;
+}
+
+const uint8_t* WorldSnapshot::GetData() const
+{
+    return mBuffer.data();
+}
+
+std::size_t WorldSnapshot::GetSize() const
+{
+    return mSize;
+}
+
+void WorldSnapshot::Assign(const uint8_t* data, std::size_t size)
+{
+    if (mBuffer.size() < size)
+    {
+        mBuffer.resize(size);
+    }
+    memcpy(mBuffer.data(), data, size);
+    mSize = size;
+}
+
+uint8_t* WorldSnapshot::AllocateSection(std::size_t count, std::size_t elementSize)
+{
+    // The header is kAlignment bytes too, so the values that follow it stay aligned
+    static_assert(2 * sizeof(uint64_t) == kAlignment, "Section headers must keep the values aligned");
+    std::size_t headerOffset = Align(mSize);
+    std::size_t valuesOffset = headerOffset + kAlignment;
+    std::size_t end = valuesOffset + count * elementSize;
+    if (mBuffer.size() < end)
+    {
+        mBuffer.resize(std::max(end, mBuffer.size() * 2));
+    }
+    uint64_t header[2] = { (uint64_t)count, (uint64_t)elementSize };
+    memcpy(mBuffer.data() + headerOffset, header, sizeof(header));
+    mSize = end;
+    return mBuffer.data() + valuesOffset;
+}
+
+WorldSnapshot::Reader::Reader(const WorldSnapshot& snapshot) :
+    mData(snapshot.GetData()), mSize(snapshot.GetSize())
+{
+}
+
+bool WorldSnapshot::Reader::Failed() const
+{
+    return mFailed;
+}
+
+bool WorldSnapshot::Reader::ReadHeader(uint64_t* header)
+{
+    std::size_t headerOffset = Align(mOffset);
+    if (mFailed || headerOffset + kAlignment > mSize)
+    {
+        return false;
+    }
+    memcpy(header, mData + headerOffset, kAlignment);
+    mOffset = headerOffset + kAlignment;
+    return true;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <type_traits>
+#include <vector>
+
+
+// Mutable simulation state copied into one contiguous buffer. Only values and indices go in, never pointers, so a
+// snapshot can be copied around or written to disk and restored into the same world later. Sections are read back in
+// the order they were written, each one starts with its element count and size and is aligned on kAlignment, so
+// arrays are filled in place or copied with a single memcpy
+class WorldSnapshot
+{
+public:
+    static constexpr const std::size_t kAlignment = 16;
+
+    class Reader
+    {
+    public:
+        explicit Reader(const WorldSnapshot& snapshot);
+
+        // Null, and the reader fails, when the next section isn't made of T
+        template <typename T>
+        const T* Read(std::size_t& count)
+        {
+            static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= kAlignment, "Only plain values can be restored");
+            uint64_t header[2];
+            // The count comes from the buffer, so it is compared without multiplying it
+            if (!ReadHeader(header) || header[1] != sizeof(T) || header[0] > (mSize - mOffset) / sizeof(T))
+            {
+                mFailed = true;
+                return nullptr;
+            }
+            count = (std::size_t)header[0];
+            const T* values = reinterpret_cast<const T*>(mData + mOffset);
+            mOffset += count * sizeof(T);
+            return values;
+        }
+
+        template <typename T>
+        bool Read(T& value)
+        {
+            std::size_t count;
+            const T* values = Read<T>(count);
+            if (!values || count != 1)
+            {
+                mFailed = true;
+                return false;
+            }
+            value = *values;
+            return true;
+        }
+
+        bool Failed() const;
+
+    private:
+        bool ReadHeader(uint64_t* header);
+
+    private:
+        const uint8_t* mData;
+        std::size_t mSize;
+        std::size_t mOffset = 0;
+        bool mFailed = false;
+    };
+
+public:
+    explicit WorldSnapshot(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+public:
+    // Keeps the memory, so taking snapshots of the same world over and over doesn't allocate
+    void Clear();
+
+    // Section of count Ts to be filled in place, valid until the next Allocate
+    template <typename T>
+    T* Allocate(std::size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= kAlignment, "Only plain values can be snapshot");
+        return reinterpret_cast<T*>(AllocateSection(count, sizeof(T)));
+    }
+
+    template <typename T>
+    void Write(const T* values, std::size_t count)
+    {
+        if (count > 0)
+        {
+            memcpy(Allocate<T>(count), values, count * sizeof(T));
+        }
+        else
+        {
+            Allocate<T>(0);
+        }
+    }
+
+    template <typename T>
+    void Write(const T& value)
+    {
+        *Allocate<T>(1) = value;
+    }
+
+    const uint8_t* GetData() const;
+    std::size_t GetSize() const;
+    // For snapshots that were saved somewhere else
+    void Assign(const uint8_t* data, std::size_t size);
+
+private:
+    uint8_t* AllocateSection(std::size_t count, std::size_t elementSize);
+
+private:
+    // Only grows, mSize is the part in use. Not resized every time, since resizing would clear the new bytes
+    std::pmr::vector<uint8_t> mBuffer;
+    std::size_t mSize = 0;
+};
@@ -1,12 +1,60 @@
 #include <Logger.h>
+#include <charconv>
+#include <cstring>
 #include "Game/Application.h"
+#include "Game/AsyncLogger.h"
 
 int main(int argc, char* argv[])
 {
     try
     {
         Logger::Init();
+        AsyncLogger::Get().Start([](AsyncLogger::Level level, const std::string& message)
+        {
+            if (level == AsyncLogger::Level::Error)
+            {
+                SHOWINFO("Check failed: {}", message);
+            }
+            else
+            {
+                SHOWINFO("{}", message);
+            }
+        });
         Application app;
+        // Options with a value go last, in any order
+        while (argc > 2)
+        {
+            std::string option = argv[argc - 2];
+            if (option == "--agent")
+            {
+                app.SetAgentChannel(argv[argc - 1]);
+            }
+            else if (option == "--spectate")
+            {
+                // The whole value, as a port a socket can bind to
+                const char* value = argv[argc - 1];
+                const char* end = value + std::strlen(value);
+                uint32_t port = 0;
+                auto parsed = std::from_chars(value, end, port);
+                CHECK(parsed.ec == std::errc() && parsed.ptr == end && port >= 1 && port <= 65535, 0,
+                    "Invalid spectator port {}, expected 1 to 65535", value);
+                app.SetSpectatorPort((uint16_t)port);
+            }
+            else
+            {
+                break;
+            }
+            argc -= 2;
+        }
+        if (argc > 1 && std::string(argv[1]) == "--endless")
+        {
+            app.SetEndless(true);
+        }
+        else if (argc > 1)
+        {
+            app.SetLevelPath(argv[1]);
+            app.SetBakedMeshes(argc > 2 && std::string(argv[2]) == "--baked-meshes");
+        }
         CHECK(app.Init(GetModuleHandle(NULL)), 0, "Cannot initialize application");
         app.Run();
     }
@@ -18,6 +66,8 @@ int main(int argc, char* argv[])
     {
         SHOWFATAL("An unexpected error occured");
     }
+    // Flush the async messages while the logger can still write them
+    AsyncLogger::Get().Stop();
     Logger::Close();
     return 0;
 }
@@ -0,0 +1,152 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "AgentChannel.h"
+#include "SimWorld.h"
+
+
+template <typename T>
+static const T* WaitForRead(AgentRing<T>& ring, const std::atomic<bool>& stop)
+{
+    const T* slot;
+    while (!(slot = ring.BeginRead()) && !stop.load(std::memory_order_relaxed)) {
+        std::this_thread::yield();
+    }
+    return slot;
+}
+
+template <typename T>
+static T* WaitForWrite(AgentRing<T>& ring, const std::atomic<bool>& stop)
+{
+    T* slot;
+    while (!(slot = ring.BeginWrite()) && !stop.load(std::memory_order_relaxed)) {
+        std::this_thread::yield();
+    }
+    return slot;
+}
+
+// Headless simulation side, steps a SimWorld in lockstep with the agent and starts a new maze after every episode
+static void Serve(AgentChannel& channel, const std::atomic<bool>& stop)
+{
+    constexpr float dt = 1.0f / 30.0f;
+    SimWorld world;
+    uint32_t seed = 1;
+    world.Reset(SimWorld::Config(), seed);
+    for (uint64_t tick = 0; !stop.load(std::memory_order_relaxed); ++tick) {
+        auto* observation = WaitForWrite(channel.GetObservations(), stop);
+        if (!observation) {
+            break;
+        }
+        world.Observe(*observation);
+        observation->Tick = tick;
+        channel.GetObservations().EndWrite();
+
+        const auto* action = WaitForRead(channel.GetActions(), stop);
+        if (!action) {
+            break;
+        }
+        SimWorld::Action simAction = { action->MoveX, action->MoveZ, action->Shoot != 0, action->AimX, action->AimZ };
+        channel.GetActions().EndRead();
+        if (world.Step(simAction, dt) != SimWorld::Outcome::Running) {
+            world.Reset(SimWorld::Config(), ++seed);
+        }
+    }
+}
+
+// Stand-in agent: keeps walking until it faces a wall, then turns, and shoots the closest enemy when it is near
+static void FillAction(const AgentObservation& observation, AgentAction& action, uint32_t& heading)
+{
+    constexpr int32_t offsets[4][2] = { { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 } };
+    for (uint32_t turn = 0; turn < 4; ++turn) {
+        const auto* offset = offsets[(heading + turn) % 4];
+        auto tile = observation.Tiles[(kObservationRadius + offset[1]) * kObservationWidth + kObservationRadius + offset[0]];
+        if (tile != (uint8_t)TileType::Wall && tile != kObservedOutside) {
+            heading = (heading + turn) % 4;
+            break;
+        }
+    }
+    action.Tick = observation.Tick;
+    action.MoveX = (float)offsets[heading][0];
+    action.MoveZ = (float)offsets[heading][1];
+    action.Shoot = 0;
+    if (observation.NumEnemies > 0) {
+        action.AimX = observation.Enemies[0].X - observation.PlayerX;
+        action.AimZ = observation.Enemies[0].Z - observation.PlayerZ;
+        action.Shoot = std::sqrt(action.AimX * action.AimX + action.AimZ * action.AimZ) < 20.0f;
+    }
+}
+
+// Answers numSteps observations, returns how many it got
+static uint64_t RunAgent(AgentChannel& channel, uint64_t numSteps, const std::atomic<bool>& stop)
+{
+    uint32_t heading = 0;
+    uint64_t step = 0;
+    for (; step < numSteps; ++step) {
+        const auto* observation = WaitForRead(channel.GetObservations(), stop);
+        auto* action = observation ? WaitForWrite(channel.GetActions(), stop) : nullptr;
+        if (!action) {
+            break;
+        }
+        FillAction(*observation, *action, heading);
+        channel.GetObservations().EndRead();
+        channel.GetActions().EndWrite();
+    }
+    return step;
+}
+
+// Usage: AgentClient <channel> [steps = 100000]  connects to a running game or server
+//        AgentClient --serve <channel>           runs a headless SimWorld for external agents
+//        AgentClient --local [steps = 1000000]   runs both sides in this process and reports the round trips per second
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <channel> [steps = 100000] | --serve <channel> | --local [steps = 1000000]\n";
+        return 1;
+    }
+    const std::string mode = argv[1];
+    std::atomic<bool> stop = false;
+    AgentChannel channel;
+    AgentChannel serverChannel;
+
+    if (mode == "--serve") {
+        if (argc < 3 || !channel.Create(argv[2])) {
+            std::cerr << "Unable to create the agent channel\n";
+            return 1;
+        }
+        std::cout << "Serving a headless world on channel " << argv[2] << "\n";
+        Serve(channel, stop);
+        return 0;
+    }
+
+    const bool local = mode == "--local";
+    const uint64_t numSteps = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : (local ? 1000000 : 100000);
+    std::thread server;
+    if (local) {
+        const std::string name = "SurvivalMazeAgentTest";
+        if (!serverChannel.Create(name) || !channel.Open(name)) {
+            std::cerr << "Unable to create the local agent channel\n";
+            return 1;
+        }
+        server = std::thread([&]() { Serve(serverChannel, stop); });
+    } else if (!channel.Open(mode)) {
+        std::cerr << "Unable to open the agent channel " << mode << ", is the simulation running?\n";
+        return 1;
+    }
+
+    auto begin = std::chrono::high_resolution_clock::now();
+    auto numAnswered = RunAgent(channel, numSteps, stop);
+    auto end = std::chrono::high_resolution_clock::now();
+    stop = true;
+    if (server.joinable()) {
+        server.join();
+    }
+
+    double seconds = std::chrono::duration<double>(end - begin).count();
+    std::cout << numAnswered << " round trips in " << seconds << " s: " << numAnswered / seconds << " round trips/s\n";
+    return numAnswered == numSteps ? 0 : 1;
+}
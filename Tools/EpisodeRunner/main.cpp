@@ -0,0 +1,176 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "SimWorld.h"
+#include "ThreadPool.h"
+
+
+// Walks down the distance field to the exit and shoots the enemies that are lined up with it
+class GreedyBot {
+public:
+    static constexpr const float kShootCooldown = 0.5f;
+    static constexpr const float kShootRange = 20.0f;
+
+public:
+    explicit GreedyBot(std::pmr::memory_resource* memory) :
+        mDistances(memory)
+    {
+    }
+
+    void Reset(const SimWorld& world)
+    {
+        const auto& config = world.GetConfig();
+        mCols = config.cols;
+        mDistances.assign((std::size_t)config.rows * config.cols, UINT32_MAX);
+
+        std::pmr::deque<TileCoordinates> queue(mDistances.get_allocator().resource());
+        auto exit = world.GetExit();
+        mDistances[(std::size_t)exit.y * mCols + exit.x] = 0;
+        queue.push_back(exit);
+        while (!queue.empty()) {
+            auto tile = queue.front();
+            queue.pop_front();
+            auto distance = mDistances[(std::size_t)tile.y * mCols + tile.x];
+            for (const auto& offset : kOffsets) {
+                TileCoordinates neighbour = { tile.x + offset[0], tile.y + offset[1] };
+                if (neighbour.x < 0 || neighbour.y < 0 || neighbour.x >= (int32_t)config.cols || neighbour.y >= (int32_t)config.rows ||
+                    world.IsWall(neighbour.y, neighbour.x) || mDistances[(std::size_t)neighbour.y * mCols + neighbour.x] != UINT32_MAX) {
+                    continue;
+                }
+                mDistances[(std::size_t)neighbour.y * mCols + neighbour.x] = distance + 1;
+                queue.push_back(neighbour);
+            }
+        }
+        mCooldown = 0.0f;
+    }
+
+    SimWorld::Action Act(const SimWorld& world, float dt)
+    {
+        SimWorld::Action action = {};
+        auto tile = world.GetPlayerTile();
+        auto best = tile;
+        auto bestDistance = GetDistance(world, tile);
+        for (const auto& offset : kOffsets) {
+            TileCoordinates neighbour = { tile.x + offset[0], tile.y + offset[1] };
+            auto distance = GetDistance(world, neighbour);
+            if (distance < bestDistance) {
+                best = neighbour;
+                bestDistance = distance;
+            }
+        }
+        action.moveX = world.GetTileCenterX(best.x) - world.GetPlayerX();
+        action.moveZ = world.GetTileCenterZ(best.y) - world.GetPlayerZ();
+
+        mCooldown -= dt;
+        if (mCooldown > 0.0f) {
+            return action;
+        }
+        for (const auto& enemy : world.GetEnemies()) {
+            float position[3];
+            enemy.GetPosition((float)world.GetTime(), position);
+            float offsetX = position[0] - world.GetPlayerX(), offsetZ = position[2] - world.GetPlayerZ();
+            bool lined = std::abs(offsetX) < 1.0f || std::abs(offsetZ) < 1.0f;
+            if (!enemy.IsDying() && lined && std::abs(offsetX) + std::abs(offsetZ) < kShootRange) {
+                action.shoot = true;
+                action.aimX = offsetX;
+                action.aimZ = offsetZ;
+                mCooldown = kShootCooldown;
+                break;
+            }
+        }
+        return action;
+    }
+
+private:
+    uint32_t GetDistance(const SimWorld& world, const TileCoordinates& tile) const
+    {
+        const auto& config = world.GetConfig();
+        if (tile.x < 0 || tile.y < 0 || tile.x >= (int32_t)config.cols || tile.y >= (int32_t)config.rows) {
+            return UINT32_MAX;
+        }
+        return mDistances[(std::size_t)tile.y * mCols + tile.x];
+    }
+
+private:
+    static constexpr const int32_t kOffsets[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+    std::pmr::vector<uint32_t> mDistances;
+    uint32_t mCols = 0;
+    float mCooldown = 0.0f;
+};
+
+// Usage: EpisodeRunner <episodes> [rows = 21] [cols = 21] [threads = all] [seed = 1]
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <episodes> [rows = 21] [cols = 21] [threads = all] [seed = 1]\n";
+        return 1;
+    }
+    const uint32_t numEpisodes = (uint32_t)std::strtoul(argv[1], nullptr, 10);
+    SimWorld::Config config;
+    config.rows = argc > 2 ? (uint32_t)std::strtoul(argv[2], nullptr, 10) : config.rows;
+    config.cols = argc > 3 ? (uint32_t)std::strtoul(argv[3], nullptr, 10) : config.cols;
+    const uint32_t numThreads = argc > 4 ? (uint32_t)std::strtoul(argv[4], nullptr, 10) : std::thread::hardware_concurrency();
+    const uint32_t seed = argc > 5 ? (uint32_t)std::strtoul(argv[5], nullptr, 10) : 1;
+    constexpr float dt = 1.0f / 30.0f;
+
+    if (config.rows < 3 || config.cols < 3 || numThreads == 0) {
+        std::cerr << "A maze needs at least 3 rows and 3 cols, and at least one thread is needed\n";
+        return 1;
+    }
+
+    std::vector<SimWorld::Statistics> results(numEpisodes);
+    std::atomic<uint32_t> nextEpisode = 0;
+
+    auto begin = std::chrono::high_resolution_clock::now();
+    // The calling thread works too, so the pool only needs the others
+    ThreadPool threadPool(numThreads - 1);
+    threadPool.ParallelFor(numThreads, [&](std::size_t)
+    {
+        // Every worker has its own arena, released after each episode so it never touches the heap once it is warm
+        std::vector<std::byte> arenaBuffer(1 << 20);
+        std::pmr::monotonic_buffer_resource arena(arenaBuffer.data(), arenaBuffer.size());
+        for (auto episode = nextEpisode++; episode < numEpisodes; episode = nextEpisode++) {
+            {
+                SimWorld world(&arena);
+                GreedyBot bot(&arena);
+                world.Reset(config, seed + episode);
+                bot.Reset(world);
+                while (world.Step(bot.Act(world, dt), dt) == SimWorld::Outcome::Running) {
+                }
+                results[episode] = world.GetStatistics();
+            }
+            arena.release();
+        }
+    });
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - begin).count();
+
+    std::array<uint32_t, 4> outcomes = {};
+    uint64_t numTicks = 0, numKilled = 0, numTouched = 0;
+    double escapeTime = 0.0;
+    for (const auto& result : results) {
+        outcomes[(std::size_t)result.outcome]++;
+        numTicks += result.numTicks;
+        numKilled += result.numEnemiesKilled;
+        numTouched += result.numEnemiesTouched;
+        if (result.outcome == SimWorld::Outcome::Escaped) {
+            escapeTime += result.time;
+        }
+    }
+    auto escaped = outcomes[(std::size_t)SimWorld::Outcome::Escaped];
+    std::cout << numEpisodes << " episodes of " << config.rows << "x" << config.cols << " mazes on " << numThreads << " threads in "
+        << seconds << " s: " << numEpisodes / seconds << " episodes/s, " << numTicks / seconds << " ticks/s\n";
+    std::cout << "Escaped " << escaped << ", died " << outcomes[(std::size_t)SimWorld::Outcome::Died]
+        << ", timed out " << outcomes[(std::size_t)SimWorld::Outcome::TimedOut] << "\n";
+    std::cout << "Mean escape time " << (escaped ? escapeTime / escaped : 0.0) << " s, enemies shot " << numKilled
+        << ", enemies touched " << numTouched << "\n";
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "ChunkMesher.h"
+#include "MazeFile.h"
+#include "RegionMazeGenerator.h"
+
+
+// Prints how many triangles the chunk meshes of the maze take compared to one cube per tile
+static bool ReportChunkMeshes(const MazeFile& mazeFile)
+{
+    // The game bakes the meshes with its own cube, this is the default cube exported from Blender
+    const float boxMin[3] = { -1.0f, -1.0f, -1.0f };
+    const float boxMax[3] = { 1.0f, 1.0f, 1.0f };
+    constexpr uint32_t chunkSize = 16;
+
+    const auto& header = mazeFile.GetHeader();
+    uint64_t partTriangles[ChunkMesher::kNumParts] = {};
+    ChunkMesh parts[ChunkMesher::kNumParts];
+    for (uint32_t row = 0; row < header.Rows; row += chunkSize)
+    {
+        for (uint32_t col = 0; col < header.Cols; col += chunkSize)
+        {
+            TileRect area = { row, col, std::min(chunkSize, header.Rows - row), std::min(chunkSize, header.Cols - col) };
+            ChunkMesher::Build(mazeFile.GetTiles(), header.Rows, header.Cols, area, header.TileWidthDepth, boxMin, boxMax, parts);
+            for (uint32_t part = 0; part < ChunkMesher::kNumParts; ++part)
+            {
+                partTriangles[part] += parts[part].GetTriangleCount();
+            }
+        }
+    }
+
+    uint64_t instancedTriangles = (uint64_t)header.Rows * header.Cols * ChunkMesher::kTrianglesPerTile;
+    uint64_t bakedTriangles = partTriangles[0] + partTriangles[1] + partTriangles[2];
+    std::cout << "Chunk meshes: " << bakedTriangles << " triangles (walls " << partTriangles[0] << ", floors " << partTriangles[1]
+        << ", enemy floors " << partTriangles[2] << "), instanced tiles: " << instancedTriangles << " triangles\n";
+    return bakedTriangles > 0 && bakedTriangles < instancedTriangles;
+}
+
+// Usage: MazeBaker <output> <rows> <cols> [tileWidthDepth = 5] [seed = random] [lee|regions] [--meshes]
+int main(int argc, char* argv[])
+{
+    bool reportMeshes = argc > 1 && std::string(argv[argc - 1]) == "--meshes";
+    if (reportMeshes)
+    {
+        argc--;
+    }
+    if (argc < 4)
+    {
+        std::cerr << "Usage: " << argv[0] << " <output> <rows> <cols> [tileWidthDepth = 5] [seed = random] [lee|regions] [--meshes]\n";
+        return 1;
+    }
+
+    const std::string outputPath = argv[1];
+    const uint32_t rows = (uint32_t)std::strtoul(argv[2], nullptr, 10);
+    const uint32_t cols = (uint32_t)std::strtoul(argv[3], nullptr, 10);
+    const float tileWidthDepth = argc > 4 ? std::strtof(argv[4], nullptr) : 5.0f;
+    const uint32_t seed = argc > 5 ? (uint32_t)std::strtoul(argv[5], nullptr, 10) : std::random_device{}();
+    const std::string generatorName = argc > 6 ? argv[6] : "lee";
+
+    if (rows < 3 || cols < 3 || tileWidthDepth < 1.0f)
+    {
+        std::cerr << "A maze needs at least 3 rows, 3 cols and a tile size of at least 1\n";
+        return 1;
+    }
+    if (generatorName != "lee" && generatorName != "regions")
+    {
+        std::cerr << "Unknown generator " << generatorName << ", expected lee or regions\n";
+        return 1;
+    }
+
+    auto begin = std::chrono::high_resolution_clock::now();
+
+    MazeGrid grid(rows, cols);
+    TileCoordinates startPosition;
+    if (generatorName == "regions")
+    {
+        ThreadPool threadPool;
+        startPosition = RegionMazeGenerator::Generate(grid, seed, threadPool);
+    }
+    else
+    {
+        std::mt19937 generator(seed);
+        startPosition = grid.Lee(generator);
+    }
+
+    auto generated = std::chrono::high_resolution_clock::now();
+
+    if (!MazeFile::Write(outputPath, grid, startPosition, tileWidthDepth))
+    {
+        std::cerr << "Unable to write maze to " << outputPath << "\n";
+        return 1;
+    }
+
+    auto written = std::chrono::high_resolution_clock::now();
+
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    std::cout << "Baked " << rows << "x" << cols << " " << generatorName << " maze (seed " << seed << ") to " << outputPath << "\n"
+        << "Generation: " << Milliseconds(generated - begin).count() << " ms\n"
+        << "Writing: " << Milliseconds(written - generated).count() << " ms\n";
+
+    MazeFile mazeFile;
+    if (!mazeFile.Open(outputPath))
+    {
+        std::cerr << "Baked file " << outputPath << " failed validation\n";
+        return 1;
+    }
+    std::cout << "File size: " << mazeFile.GetHeader().FileSize << " bytes, enemies: " << mazeFile.GetHeader().NumEnemies << "\n";
+
+    if (reportMeshes && !ReportChunkMeshes(mazeFile))
+    {
+        std::cerr << "Chunk meshes are not smaller than the instanced tiles\n";
+        return 1;
+    }
+
+    return 0;
+}
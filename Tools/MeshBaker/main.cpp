@@ -0,0 +1,87 @@
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include <assimp/Exporter.hpp>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+
+#include "MeshCache.h"
+
+
+// Removes cache entries of older versions of the same source
+static void RemoveStaleEntries(const std::filesystem::path& cachePath)
+{
+    auto cacheDirectory = cachePath.parent_path();
+    // <name>.<hash>.assbin
+    auto sourceName = cachePath.stem().stem().string() + ".";
+
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(cacheDirectory, error))
+    {
+        const auto& path = entry.path();
+        if (path != cachePath && path.extension() == MeshCache::kCacheExtension &&
+            path.filename().string().rfind(sourceName, 0) == 0)
+        {
+            std::filesystem::remove(path, error);
+        }
+    }
+}
+
+static bool BakeMesh(const std::string& sourcePath)
+{
+    uint64_t hash;
+    if (!MeshCache::HashSource(sourcePath, hash))
+    {
+        std::cerr << "Unable to read " << sourcePath << "\n";
+        return false;
+    }
+
+    std::filesystem::path cachePath = MeshCache::GetCachePath(sourcePath, hash);
+    if (std::filesystem::exists(cachePath))
+    {
+        std::cout << sourcePath << " is up to date (" << cachePath.string() << ")\n";
+        return true;
+    }
+
+    // No post processing here. The game applies its own steps when loading the baked mesh,
+    // exactly as it would do for the source, so applying any of them twice must be avoided
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(sourcePath, 0);
+    if (scene == nullptr)
+    {
+        std::cerr << "Unable to import " << sourcePath << ": " << importer.GetErrorString() << "\n";
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(cachePath.parent_path(), error);
+
+    Assimp::Exporter exporter;
+    if (exporter.Export(scene, "assbin", cachePath.string()) != aiReturn_SUCCESS)
+    {
+        std::cerr << "Unable to write " << cachePath.string() << ": " << exporter.GetErrorString() << "\n";
+        return false;
+    }
+    RemoveStaleEntries(cachePath);
+
+    std::cout << "Baked " << sourcePath << " to " << cachePath.string() << "\n";
+    return true;
+}
+
+// Usage: MeshBaker <mesh>...
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <mesh>...\n";
+        return 1;
+    }
+
+    bool result = true;
+    for (int i = 1; i < argc; ++i)
+    {
+        result &= BakeMesh(argv[i]);
+    }
+    return result ? 0 : 1;
+}
@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "SpectatorStream.h"
+
+
+constexpr float kTickTime = 1.0f / 60.0f;
+constexpr uint32_t kTruthSize = 256;
+
+// Stand-in for the game at any scale: enemies patrolling like the game's, some of them dying and being replaced
+// every tick, and projectiles flying around
+class SyntheticWorld {
+    struct Patrol {
+        uint32_t id;
+        float x, z;
+        float directionX, directionZ;
+        float range, speed, time;
+        float dyingTime; // Negative while alive
+    };
+    struct Shot {
+        uint32_t id;
+        float x, z, directionX, directionZ, lifetime;
+    };
+
+public:
+    explicit SyntheticWorld(uint32_t numEntities) : mGenerator(1) {
+        uint32_t numShots = std::max(numEntities / 100, 1u);
+        for (uint32_t i = 0; i + numShots + 1 < numEntities; ++i) {
+            mEnemies.push_back(MakeEnemy());
+        }
+        for (uint32_t i = 0; i < numShots; ++i) {
+            mShots.push_back({ SpectatorEntity::MakeId(SpectatorEntityKind::Projectile, i), 0.0f, 0.0f, 0.0f, 0.0f, 0.0f });
+        }
+    }
+
+    void Step(float dt) {
+        std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+        mPlayerAngle += dt;
+        mPlayerX += std::cos(mPlayerAngle) * 3.0f * dt;
+        mPlayerZ += std::sin(mPlayerAngle) * 3.0f * dt;
+        for (auto& enemy : mEnemies) {
+            if (enemy.dyingTime >= 0.0f) {
+                enemy.dyingTime += dt;
+                if (enemy.dyingTime > 1.0f) {
+                    enemy = MakeEnemy();
+                }
+                continue;
+            }
+            enemy.time += dt * enemy.speed;
+            if (chance(mGenerator) < 0.0005f) {
+                enemy.dyingTime = 0.0f;
+            }
+        }
+        for (auto& shot : mShots) {
+            shot.lifetime -= dt;
+            if (shot.lifetime <= 0.0f) {
+                float angle = chance(mGenerator) * 6.28318530718f;
+                shot = { shot.id, mPlayerX, mPlayerZ, std::cos(angle), std::sin(angle), 5.0f };
+            }
+            shot.x += shot.directionX * 5.0f * dt;
+            shot.z += shot.directionZ * 5.0f * dt;
+        }
+    }
+
+    void Publish(uint32_t tick, SpectatorFrame& frame) const {
+        frame.Tick = tick;
+        frame.Health = 1.0f;
+        frame.RemainingTime = 600.0f - tick * kTickTime;
+        frame.Entities.clear();
+        uint32_t playerId = SpectatorEntity::MakeId(SpectatorEntityKind::Player, 0);
+        frame.Entities.push_back({ playerId, 0, mPlayerX, 0.0f, mPlayerZ, mPlayerAngle });
+        for (const auto& enemy : mEnemies) {
+            float offset = std::sin(enemy.time) * enemy.range;
+            frame.Entities.push_back({ enemy.id, enemy.dyingTime >= 0.0f ? 1u : 0u, enemy.x + enemy.directionX * offset, 1.0f,
+                enemy.z + enemy.directionZ * offset, 0.0f });
+        }
+        for (const auto& shot : mShots) {
+            frame.Entities.push_back({ shot.id, 0, shot.x, 1.0f, shot.z, 0.0f });
+        }
+    }
+
+private:
+    Patrol MakeEnemy() {
+        std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+        std::uniform_real_distribution<float> speed(0.0001f, 1.0f / 3.0f);
+        std::uniform_int_distribution<int> axis(0, 3);
+        constexpr float directions[4][2] = { { 1.0f, 0.0f }, { -1.0f, 0.0f }, { 0.0f, 1.0f }, { 0.0f, -1.0f } };
+        int direction = axis(mGenerator);
+        // Like the game, dead enemies come back as new ones
+        uint32_t id = SpectatorEntity::MakeId(SpectatorEntityKind::Enemy, mNextEnemy++);
+        return { id, position(mGenerator), position(mGenerator), directions[direction][0], directions[direction][1], 5.0f,
+            speed(mGenerator), 0.0f, -1.0f };
+    }
+
+private:
+    std::mt19937 mGenerator;
+    std::vector<Patrol> mEnemies;
+    std::vector<Shot> mShots;
+    uint32_t mNextEnemy = 0;
+    float mPlayerX = 0.0f, mPlayerZ = 0.0f, mPlayerAngle = 0.0f;
+};
+
+struct Errors {
+    uint64_t numMismatches = 0; // Entities missing, extra or with other flags
+    float maxPositionError = 0.0f;
+    float maxHeadingError = 0.0f;
+};
+
+static void Compare(SpectatorFrame truth, const SpectatorFrame& received, Errors& errors) {
+    std::sort(truth.Entities.begin(), truth.Entities.end(),
+        [](const SpectatorEntity& lhs, const SpectatorEntity& rhs) { return lhs.Id < rhs.Id; });
+    if (truth.Entities.size() != received.Entities.size()) {
+        errors.numMismatches += (uint64_t)std::abs((int64_t)truth.Entities.size() - (int64_t)received.Entities.size());
+    }
+    for (std::size_t i = 0; i < std::min(truth.Entities.size(), received.Entities.size()); ++i) {
+        const auto& expected = truth.Entities[i];
+        const auto& actual = received.Entities[i];
+        if (expected.Id != actual.Id || expected.Flags != actual.Flags) {
+            errors.numMismatches++;
+            continue;
+        }
+        errors.maxPositionError = std::max({ errors.maxPositionError, std::abs(expected.X - actual.X),
+            std::abs(expected.Y - actual.Y), std::abs(expected.Z - actual.Z) });
+        float heading = std::remainder(expected.Heading - actual.Heading, 6.28318530718f);
+        errors.maxHeadingError = std::max(errors.maxHeadingError, std::abs(heading));
+    }
+}
+
+// Publishes the synthetic world in real time while a spectator on another thread checks every frame it gets
+static int RunLocal(uint32_t numEntities, uint32_t numTicks) {
+    SpectatorServer server;
+    if (!server.Start(0)) {
+        std::cerr << "Unable to start the local spectator server\n";
+        return 1;
+    }
+
+    std::mutex truthMutex;
+    std::vector<SpectatorFrame> truth(kTruthSize);
+    std::atomic<bool> stop = false;
+    Errors errors;
+    uint64_t numReceived = 0, numFullFrames = 0, numDeltaBytes = 0, fullFrameBytes = 0;
+    SpectatorClient client;
+    if (!client.Connect(server.GetPort())) {
+        std::cerr << "Unable to connect to the local spectator server\n";
+        return 1;
+    }
+    std::thread spectator([&]() {
+        SpectatorFrame frame;
+        while (!stop.load(std::memory_order_relaxed) && client.Receive(frame)) {
+            numReceived++;
+            if (client.GetLastBaselineTick() == kSpectatorNoBaseline) {
+                numFullFrames++;
+                fullFrameBytes = client.GetLastPacketSize();
+            } else {
+                numDeltaBytes += client.GetLastPacketSize();
+            }
+            std::unique_lock<std::mutex> lock(truthMutex);
+            const auto& expected = truth[frame.Tick % kTruthSize];
+            if (expected.Tick != frame.Tick) {
+                errors.numMismatches++;
+                continue;
+            }
+            Compare(expected, frame, errors);
+        }
+    });
+
+    SyntheticWorld world(numEntities);
+    double publishTime = 0.0;
+    auto nextTick = std::chrono::steady_clock::now();
+    for (uint32_t tick = 0; tick < numTicks; ++tick) {
+        world.Step(kTickTime);
+        auto& frame = server.BeginPublish();
+        world.Publish(tick, frame);
+        {
+            std::unique_lock<std::mutex> lock(truthMutex);
+            truth[tick % kTruthSize] = frame;
+        }
+        auto published = std::chrono::high_resolution_clock::now();
+        server.EndPublish();
+        auto end = std::chrono::high_resolution_clock::now();
+        // Filling the frame is the game's job, only the hand over counts against the frame time
+        publishTime += std::chrono::duration<double, std::micro>(end - published).count();
+
+        nextTick += std::chrono::microseconds((int64_t)(kTickTime * 1e6f));
+        std::this_thread::sleep_until(nextTick);
+    }
+    // Let the last frames arrive
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    stop = true;
+    auto statistics = server.GetStatistics();
+    // Closes the connection, which wakes the spectator up
+    server.Stop();
+    spectator.join();
+    client.Close();
+
+    uint64_t numDeltas = numReceived - numFullFrames;
+    double rawBytes = (double)numEntities * sizeof(SpectatorEntity);
+    std::cout << numReceived << "/" << numTicks << " frames received (" << statistics.NumFramesSkipped << " skipped), "
+        << numFullFrames << " full\n";
+    std::cout << "Full frame: " << fullFrameBytes << " bytes, " << fullFrameBytes * 8.0 / numEntities << " bits/entity\n";
+    if (numDeltas > 0) {
+        double bytesPerTick = (double)numDeltaBytes / numDeltas;
+        std::cout << "Delta frames: " << bytesPerTick << " bytes/tick, " << bytesPerTick * 8.0 / numEntities
+            << " bits/entity, " << rawBytes / bytesPerTick << "x smaller than the raw " << rawBytes << " bytes\n";
+    }
+    std::cout << "Max position error " << errors.maxPositionError << " (step " << kSpectatorPositionStep << "), max heading error "
+        << errors.maxHeadingError << " rad, " << errors.numMismatches << " mismatches\n";
+    std::cout << "Hand over on the publishing thread: " << publishTime / numTicks << " us/tick\n";
+
+    bool accurate = errors.numMismatches == 0 && errors.maxPositionError <= kSpectatorPositionStep * 0.5f * 1.001f;
+    return accurate && numReceived > 0 ? 0 : 1;
+}
+
+// Watches a running game and reports the stream's size now and then
+static int Watch(uint16_t port, uint32_t numFrames) {
+    SpectatorClient client;
+    if (!client.Connect(port)) {
+        std::cerr << "Unable to connect to port " << port << ", is the game running with --spectate?\n";
+        return 1;
+    }
+    SpectatorFrame frame;
+    uint64_t numBytes = 0;
+    for (uint32_t i = 0; i < numFrames; ++i) {
+        if (!client.Receive(frame)) {
+            std::cerr << "The game went away\n";
+            return 1;
+        }
+        numBytes += client.GetLastPacketSize();
+        if ((i + 1) % 60 == 0) {
+            std::cout << "Tick " << frame.Tick << ": " << frame.Entities.size() << " entities, health " << frame.Health
+                << ", " << numBytes / 60.0 << " bytes/tick\n";
+            numBytes = 0;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <port> [frames = 600] | --local [entities = 10000] [ticks = 600]\n";
+        return 1;
+    }
+    const std::string mode = argv[1];
+    if (mode == "--local") {
+        uint32_t numEntities = argc > 2 ? (uint32_t)std::strtoul(argv[2], nullptr, 10) : 10000;
+        uint32_t numTicks = argc > 3 ? (uint32_t)std::strtoul(argv[3], nullptr, 10) : 600;
+        return RunLocal(std::max(numEntities, 2u), numTicks);
+    }
+    char* end = nullptr;
+    unsigned long port = std::strtoul(mode.c_str(), &end, 10);
+    if (mode.empty() || *end != '\0' || mode[0] == '-' || port < 1 || port > 65535) {
+        std::cerr << "Invalid port " << mode << ", expected 1 to 65535\n";
+        return 1;
+    }
+    uint32_t numFrames = argc > 2 ? (uint32_t)std::strtoul(argv[2], nullptr, 10) : 600;
+    return Watch((uint16_t)port, numFrames);
+}
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "AgentChannel.h"
+#include "Test.h"
+
+
+namespace {
+
+float GetDistanceSquared(const AgentObservation& observation, float x, float z)
+{
+    return (x - observation.PlayerX) * (x - observation.PlayerX) + (z - observation.PlayerZ) * (z - observation.PlayerZ);
+}
+
+}
+
+TEST(AgentRingWrapsAround)
+{
+    // Value initialized, like the zeroed shared memory it normally lives in
+    auto ring = std::make_unique<AgentRing<AgentAction>>();
+    uint64_t nextWritten = 0, nextRead = 0;
+    // Many times around the ring, with the producer a varying number of slots ahead
+    for (uint32_t round = 0; round < 10 * kAgentRingCapacity; ++round) {
+        uint32_t numWrites = round % (kAgentRingCapacity + 2);
+        for (uint32_t i = 0; i < numWrites; ++i) {
+            auto* action = ring->BeginWrite();
+            if (nextWritten - nextRead == kAgentRingCapacity) {
+                EXPECT(action == nullptr);
+                break;
+            }
+            EXPECT(action != nullptr);
+            if (action) {
+                action->Tick = nextWritten++;
+                ring->EndWrite();
+            }
+        }
+        while (const auto* action = ring->BeginRead()) {
+            EXPECT(action->Tick == nextRead);
+            nextRead++;
+            ring->EndRead();
+        }
+        EXPECT(nextRead == nextWritten);
+    }
+    EXPECT(nextWritten > 2 * kAgentRingCapacity);
+}
+
+TEST(AgentChannelKeepsTheClosestEnemiesInOrder)
+{
+    std::mt19937 random(40);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    for (uint32_t numEnemies : { 0u, 1u, kMaxObservedEnemies - 1, kMaxObservedEnemies, 5 * kMaxObservedEnemies }) {
+        AgentObservation observation = {};
+        observation.PlayerX = position(random);
+        observation.PlayerZ = position(random);
+        std::vector<float> distances;
+        for (uint32_t i = 0; i < numEnemies; ++i) {
+            float x = position(random), z = position(random);
+            distances.push_back(GetDistanceSquared(observation, x, z));
+            AgentChannel::AddEnemy(observation, x, z);
+        }
+        std::sort(distances.begin(), distances.end());
+
+        EXPECT(observation.NumEnemies == std::min(numEnemies, kMaxObservedEnemies));
+        for (uint32_t i = 0; i < observation.NumEnemies; ++i) {
+            const auto& enemy = observation.Enemies[i];
+            EXPECT(GetDistanceSquared(observation, enemy.X, enemy.Z) == distances[i]);
+        }
+    }
+}
+
+TEST(AgentChannelConnectsBothSides)
+{
+    std::string name = "SurvivalMazeTests" + std::to_string(std::random_device()());
+    AgentChannel simulation, agent;
+    EXPECT(!agent.Open(name));
+    EXPECT(simulation.Create(name));
+    EXPECT(agent.Open(name));
+    if (!simulation.IsOpen() || !agent.IsOpen()) {
+        return;
+    }
+
+    auto* observation = simulation.GetObservations().BeginWrite();
+    EXPECT(observation != nullptr);
+    observation->Tick = 3;
+    simulation.GetObservations().EndWrite();
+    const auto* received = agent.GetObservations().BeginRead();
+    EXPECT(received != nullptr && received->Tick == 3);
+    agent.GetObservations().EndRead();
+
+    auto* action = agent.GetActions().BeginWrite();
+    action->Tick = 3;
+    action->Shoot = 1;
+    agent.GetActions().EndWrite();
+    const auto* answer = simulation.GetActions().BeginRead();
+    EXPECT(answer != nullptr && answer->Tick == 3 && answer->Shoot == 1);
+    simulation.GetActions().EndRead();
+
+    agent.Close();
+    simulation.Close();
+    EXPECT(!agent.Open(name));
+}
@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "BoxTransform.h"
+#include "Test.h"
+
+using namespace DirectX;
+
+
+// BoundingBox::Transform goes through the 8 corners, which is the reference: both give the exact same box for an affine
+// matrix, so they may only differ by float rounding
+namespace {
+
+constexpr float kTolerance = 1e-5f;
+
+struct Case {
+    BoundingBox Box;
+    XMFLOAT4X4 Matrix;
+};
+
+// Scaling, rotation about every axis and translation, with a shear on top for some of them
+std::vector<Case> MakeCases(std::size_t count)
+{
+    std::mt19937 random(37);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> size(0.01f, 10.0f);
+    std::uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+    std::uniform_real_distribution<float> shear(-1.0f, 1.0f);
+
+    std::vector<Case> cases(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        cases[i].Box = BoundingBox(XMFLOAT3(position(random), position(random), position(random)),
+            XMFLOAT3(size(random), size(random), size(random)));
+        XMMATRIX matrix = XMMatrixScaling(size(random), size(random), size(random)) *
+            XMMatrixRotationRollPitchYaw(angle(random), angle(random), angle(random)) *
+            XMMatrixTranslation(position(random), position(random), position(random));
+        if (i % 4 == 0) {
+            matrix = XMMatrixSet(
+                1.0f, shear(random), shear(random), 0.0f,
+                shear(random), 1.0f, shear(random), 0.0f,
+                shear(random), shear(random), 1.0f, 0.0f,
+                0.0f, 0.0f, 0.0f, 1.0f) * matrix;
+        }
+        XMStoreFloat4x4(&cases[i].Matrix, matrix);
+    }
+    return cases;
+}
+
+// Relative to the largest value of the box: the corners of a small box far from the origin lose the precision of its extents
+bool NearlyEqual(const BoundingBox& a, const BoundingBox& b)
+{
+    const float first[] = { a.Center.x, a.Center.y, a.Center.z, a.Extents.x, a.Extents.y, a.Extents.z };
+    const float second[] = { b.Center.x, b.Center.y, b.Center.z, b.Extents.x, b.Extents.y, b.Extents.z };
+    float scale = 1.0f;
+    for (uint32_t i = 0; i < 6; ++i)
+        scale = std::max({ scale, std::fabs(first[i]), std::fabs(second[i]) });
+    for (uint32_t i = 0; i < 6; ++i) {
+        if (std::fabs(first[i] - second[i]) > kTolerance * scale)
+            return false;
+    }
+    return true;
+}
+
+BoundingBox TransformCorners(const BoundingBox& box, const XMFLOAT4X4& matrix)
+{
+    BoundingBox result;
+    box.Transform(result, XMLoadFloat4x4(&matrix));
+    return result;
+}
+
+}
+
+TEST(BoxTransformMatchesBoundingBoxTransform)
+{
+    auto cases = MakeCases(10000);
+    uint32_t mismatches = 0;
+    for (const auto& testCase : cases) {
+        auto expected = TransformCorners(testCase.Box, testCase.Matrix);
+        mismatches += !NearlyEqual(BoxTransform::Transform(testCase.Box, XMLoadFloat4x4(&testCase.Matrix)), expected);
+    }
+    EXPECT(mismatches == 0);
+}
+
+TEST(BoxTransformBatchesMatchOneByOne)
+{
+    auto cases = MakeCases(1001);
+    std::vector<BoundingBox> boxes(cases.size());
+    std::vector<XMFLOAT4X4> matrices(cases.size());
+    for (std::size_t i = 0; i < cases.size(); ++i) {
+        boxes[i] = cases[i].Box;
+        matrices[i] = cases[i].Matrix;
+    }
+
+    std::vector<BoundingBox> outBoxes(cases.size());
+    BoxTransform::Transform(boxes.data(), matrices.data(), outBoxes.data(), cases.size());
+    uint32_t mismatches = 0;
+    for (std::size_t i = 0; i < cases.size(); ++i)
+        mismatches += !NearlyEqual(outBoxes[i], TransformCorners(boxes[i], matrices[i]));
+    EXPECT(mismatches == 0);
+
+    // Instances of one model
+    BoxTransform::Transform(boxes[0], matrices.data(), outBoxes.data(), cases.size());
+    mismatches = 0;
+    for (std::size_t i = 0; i < cases.size(); ++i)
+        mismatches += !NearlyEqual(outBoxes[i], TransformCorners(boxes[0], matrices[i]));
+    EXPECT(mismatches == 0);
+}
+
+// Reports the cost per box of the corners and of the batched instance transform, the way Maze transforms its tiles
+TEST(BoxTransformBenchmark)
+{
+    constexpr std::size_t kNumBoxes = 1 << 16;
+    constexpr uint32_t kNumRuns = 16;
+    auto cases = MakeCases(kNumBoxes);
+    std::vector<XMFLOAT4X4> matrices(kNumBoxes);
+    for (std::size_t i = 0; i < kNumBoxes; ++i)
+        matrices[i] = cases[i].Matrix;
+    std::vector<BoundingBox> outBoxes(kNumBoxes);
+    const BoundingBox box = cases[0].Box;
+
+    auto measure = [&](auto&& transform) {
+        auto best = std::chrono::steady_clock::duration::max();
+        for (uint32_t run = 0; run < kNumRuns; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            transform();
+            best = std::min(best, std::chrono::steady_clock::now() - start);
+        }
+        return std::chrono::duration<double, std::nano>(best).count() / kNumBoxes;
+    };
+    double corners = measure([&]() {
+        for (std::size_t i = 0; i < kNumBoxes; ++i)
+            box.Transform(outBoxes[i], XMLoadFloat4x4(&matrices[i]));
+    });
+    double batched = measure([&]() {
+        BoxTransform::Transform(box, matrices.data(), outBoxes.data(), kNumBoxes);
+    });
+    std::printf("BoundingBox::Transform %.2f ns per box, BoxTransform::Transform %.2f ns per box\n", corners, batched);
+
+    uint32_t mismatches = 0;
+    for (std::size_t i = 0; i < kNumBoxes; ++i)
+        mismatches += !NearlyEqual(outBoxes[i], TransformCorners(box, matrices[i]));
+    EXPECT(mismatches == 0);
+}
@@ -0,0 +1,186 @@
+#include <cmath>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "ChunkMesher.h"
+#include "Test.h"
+
+
+// Small layouts drawn as text, '#' for walls, '.' for floors and 'e' for enemy floors, meshed with the unit cube the
+// maze is built from. Every merged quad is two triangles
+namespace {
+
+constexpr float kTileSize = 5.0f;
+constexpr float kBoxMin[3] = { -0.5f, -0.5f, -0.5f };
+constexpr float kBoxMax[3] = { 0.5f, 0.5f, 0.5f };
+
+struct Layout {
+    uint32_t Rows = 0;
+    uint32_t Cols = 0;
+    std::vector<TileType> Tiles;
+    ChunkMesh Parts[ChunkMesher::kNumParts];
+
+    Layout(std::initializer_list<const char*> lines)
+    {
+        for (auto line : lines) {
+            std::string row(line);
+            Cols = (uint32_t)row.size();
+            for (char c : row)
+                Tiles.push_back(c == '#' ? TileType::Wall : c == 'e' ? TileType::Enemy : TileType::Free);
+            Rows++;
+        }
+        Build({ 0, 0, Rows, Cols });
+    }
+
+    void Build(const TileRect& area)
+    {
+        ChunkMesher::Build(Tiles.data(), Rows, Cols, area, kTileSize, kBoxMin, kBoxMax, Parts);
+    }
+
+    uint32_t GetQuads(ChunkMeshPart part) const
+    {
+        return Parts[(uint32_t)part].GetTriangleCount() / 2;
+    }
+
+    // Wall quads facing along normal
+    uint32_t GetWallQuads(float x, float y, float z) const
+    {
+        const auto& walls = Parts[(uint32_t)ChunkMeshPart::Walls];
+        uint32_t count = 0;
+        for (std::size_t i = 0; i < walls.Vertices.size(); i += 4) {
+            const auto& normal = walls.Vertices[i].Normal;
+            count += normal[0] == x && normal[1] == y && normal[2] == z;
+        }
+        return count;
+    }
+};
+
+// Front faces are clockwise with left handed coordinates, so cross(b - a, c - a) points along the normal
+bool FacesAlongNormals(const ChunkMesh& mesh)
+{
+    for (std::size_t i = 0; i + 2 < mesh.Indices.size(); i += 3) {
+        const auto& a = mesh.Vertices[mesh.Indices[i]];
+        const auto& b = mesh.Vertices[mesh.Indices[i + 1]];
+        const auto& c = mesh.Vertices[mesh.Indices[i + 2]];
+        float edge0[3], edge1[3];
+        for (uint32_t j = 0; j < 3; ++j) {
+            edge0[j] = b.Position[j] - a.Position[j];
+            edge1[j] = c.Position[j] - a.Position[j];
+        }
+        float cross[3] = {
+            edge0[1] * edge1[2] - edge0[2] * edge1[1],
+            edge0[2] * edge1[0] - edge0[0] * edge1[2],
+            edge0[0] * edge1[1] - edge0[1] * edge1[0],
+        };
+        if (cross[0] * a.Normal[0] + cross[1] * a.Normal[1] + cross[2] * a.Normal[2] <= 0.0f)
+            return false;
+    }
+    return true;
+}
+
+}
+
+TEST(ChunkMesherOneWall)
+{
+    Layout layout({
+        "...",
+        ".#.",
+        "...",
+    });
+    // A top and four sides, nothing under the floor
+    EXPECT(layout.GetQuads(ChunkMeshPart::Walls) == 5);
+    EXPECT(layout.GetWallQuads(0.0f, 1.0f, 0.0f) == 1);
+    EXPECT(layout.GetWallQuads(-1.0f, 0.0f, 0.0f) == 1);
+    EXPECT(layout.GetWallQuads(1.0f, 0.0f, 0.0f) == 1);
+    EXPECT(layout.GetWallQuads(0.0f, 0.0f, -1.0f) == 1);
+    EXPECT(layout.GetWallQuads(0.0f, 0.0f, 1.0f) == 1);
+    // The row above, the tiles on both sides and the row below
+    EXPECT(layout.GetQuads(ChunkMeshPart::Floors) == 4);
+    EXPECT(layout.GetQuads(ChunkMeshPart::EnemyFloors) == 0);
+    EXPECT(FacesAlongNormals(layout.Parts[(uint32_t)ChunkMeshPart::Walls]));
+    EXPECT(FacesAlongNormals(layout.Parts[(uint32_t)ChunkMeshPart::Floors]));
+
+    // Sides only go down to the floor, tops are at the top of the wall
+    const auto& walls = layout.Parts[(uint32_t)ChunkMeshPart::Walls];
+    float minY = walls.Vertices[0].Position[1], maxY = minY;
+    for (const auto& vertex : walls.Vertices) {
+        minY = std::fmin(minY, vertex.Position[1]);
+        maxY = std::fmax(maxY, vertex.Position[1]);
+    }
+    EXPECT(minY == -1.0f + 2.0f * kBoxMax[1]);
+    EXPECT(maxY == 1.0f + 5.0f * kBoxMax[1]);
+}
+
+TEST(ChunkMesherTwoAdjacentWalls)
+{
+    Layout row({
+        "....",
+        ".##.",
+        "....",
+    });
+    // The shared side is dropped and the two walls merge into one box
+    EXPECT(row.GetQuads(ChunkMeshPart::Walls) == 5);
+    EXPECT(row.GetQuads(ChunkMeshPart::Floors) == 4);
+
+    Layout column({
+        "...",
+        ".#.",
+        ".#.",
+        "...",
+    });
+    EXPECT(column.GetQuads(ChunkMeshPart::Walls) == 5);
+    EXPECT(FacesAlongNormals(column.Parts[(uint32_t)ChunkMeshPart::Walls]));
+
+    // Diagonal walls share no side
+    Layout diagonal({
+        "#.",
+        ".#",
+    });
+    EXPECT(diagonal.GetQuads(ChunkMeshPart::Walls) == 10);
+}
+
+TEST(ChunkMesherEnclosedBlock)
+{
+    Layout block({
+        ".....",
+        ".###.",
+        ".###.",
+        ".###.",
+        ".....",
+    });
+    // The middle wall has no visible side and the outer sides merge into one quad each
+    EXPECT(block.GetQuads(ChunkMeshPart::Walls) == 5);
+    EXPECT(block.GetQuads(ChunkMeshPart::Floors) == 4);
+
+    Layout ring({
+        "###",
+        "#e#",
+        "###",
+    });
+    // Outer sides, the four sides around the enclosed floor and the tops of the ring
+    EXPECT(ring.GetWallQuads(0.0f, 0.0f, -1.0f) == 2);
+    EXPECT(ring.GetWallQuads(0.0f, 0.0f, 1.0f) == 2);
+    EXPECT(ring.GetWallQuads(-1.0f, 0.0f, 0.0f) == 2);
+    EXPECT(ring.GetWallQuads(1.0f, 0.0f, 0.0f) == 2);
+    EXPECT(ring.GetWallQuads(0.0f, 1.0f, 0.0f) == 4);
+    EXPECT(ring.GetQuads(ChunkMeshPart::Walls) == 12);
+    EXPECT(ring.GetQuads(ChunkMeshPart::Floors) == 0);
+    EXPECT(ring.GetQuads(ChunkMeshPart::EnemyFloors) == 1);
+    EXPECT(FacesAlongNormals(ring.Parts[(uint32_t)ChunkMeshPart::Walls]));
+}
+
+TEST(ChunkMesherOnlyMeshesTheArea)
+{
+    Layout layout({
+        "##",
+        "##",
+    });
+    // The right column only: walls outside the area still hide the sides facing them
+    layout.Build({ 0, 1, 2, 1 });
+    EXPECT(layout.GetQuads(ChunkMeshPart::Walls) == 4);
+    EXPECT(layout.GetWallQuads(-1.0f, 0.0f, 0.0f) == 0);
+    EXPECT(layout.GetWallQuads(1.0f, 0.0f, 0.0f) == 1);
+    EXPECT(layout.GetWallQuads(0.0f, 0.0f, -1.0f) == 1);
+    EXPECT(layout.GetWallQuads(0.0f, 0.0f, 1.0f) == 1);
+}
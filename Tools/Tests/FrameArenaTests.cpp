@@ -0,0 +1,92 @@
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "FrameArena.h"
+#include "MemoryTracker.h"
+#include "Test.h"
+
+
+// Every arena gets its own tracked upstream, so the tests see exactly what it takes from the heap
+namespace {
+
+constexpr std::size_t kCapacity = 1024;
+
+// The same frame every time: more than fits in kCapacity, in a few allocations of mixed alignments
+void AllocateFrame(FrameArena& arena)
+{
+    for (uint32_t i = 0; i < 8; ++i) {
+        arena.AllocateArray<double>(40);
+        arena.AllocateArray<uint8_t>(33);
+    }
+}
+
+}
+
+TEST(FrameArenaRewindsTheLastAllocation)
+{
+    TrackedMemoryResource upstream("FrameArenaTests");
+    FrameArena arena(kCapacity, &upstream);
+    auto* first = arena.allocate(100, 8);
+    auto* second = arena.allocate(100, 8);
+    arena.deallocate(second, 100, 8);
+    EXPECT(arena.allocate(100, 8) == second);
+    // Only the last allocation can be given back
+    arena.deallocate(first, 100, 8);
+    EXPECT(arena.GetUsedBytes() >= 200);
+}
+
+TEST(FrameArenaAlignsAllocations)
+{
+    TrackedMemoryResource upstream("FrameArenaTests");
+    FrameArena arena(kCapacity, &upstream);
+    EXPECT(arena.allocate(1, 1) != nullptr);
+    for (std::size_t alignment : { 2, 4, 8, 16, 32, 64, 128 }) {
+        auto address = (uintptr_t)arena.allocate(3, alignment);
+        EXPECT(address % alignment == 0);
+    }
+}
+
+TEST(FrameArenaGrowsToHoldASpilledFrame)
+{
+    TrackedMemoryResource upstream("FrameArenaTests");
+    FrameArena arena(kCapacity, &upstream);
+    EXPECT(upstream.GetStatistics().NumAllocations == 1);
+
+    AllocateFrame(arena);
+    auto spilled = upstream.GetStatistics();
+    std::size_t frameBytes = arena.GetUsedBytes();
+    EXPECT(frameBytes > kCapacity);
+    EXPECT(spilled.NumAllocations > 1);
+
+    // The spilled blocks and the old block are given back for one block that holds the whole frame
+    arena.Reset();
+    auto grown = upstream.GetStatistics();
+    EXPECT(arena.GetCapacity() >= frameBytes);
+    EXPECT(arena.GetUsedBytes() == 0);
+    EXPECT(arena.GetPeakBytes() == frameBytes);
+    EXPECT(grown.NumAllocations == spilled.NumAllocations + 1);
+    EXPECT(grown.LiveBytes == arena.GetCapacity());
+
+    for (uint32_t frame = 0; frame < 4; ++frame) {
+        AllocateFrame(arena);
+        arena.Reset();
+    }
+    EXPECT(upstream.GetStatistics().NumAllocations == grown.NumAllocations);
+}
+
+TEST(FrameArenaBacksContainers)
+{
+    TrackedMemoryResource upstream("FrameArenaTests");
+    FrameArena arena(kCapacity, &upstream);
+    {
+        std::pmr::vector<uint32_t> values(&arena);
+        for (uint32_t i = 0; i < 1000; ++i) {
+            values.push_back(i);
+        }
+        EXPECT(values[999] == 999);
+    }
+    arena.Reset();
+    EXPECT(arena.GetUsedBytes() == 0);
+    EXPECT(upstream.GetStatistics().LiveBytes == arena.GetCapacity());
+}
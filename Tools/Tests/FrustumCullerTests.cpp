@@ -0,0 +1,122 @@
+#include <iterator>
+#include <vector>
+
+#include "FrustumCuller.h"
+#include "Test.h"
+
+using namespace DirectX;
+
+
+// A camera at the origin looking down +z with a 90 degree field of view, so at depth z the frustum spans [-z, z] on x and y
+namespace {
+
+constexpr float kNear = 1.0f;
+constexpr float kFar = 100.0f;
+
+FrustumCuller MakeCuller()
+{
+    FrustumCuller culler;
+    XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f),
+        XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, kNear, kFar);
+    culler.Update(view, projection);
+    return culler;
+}
+
+BoundingBox MakeBox(float x, float y, float z, float extents)
+{
+    return BoundingBox(XMFLOAT3(x, y, z), XMFLOAT3(extents, extents, extents));
+}
+
+const BoundingBox kInside[] = {
+    MakeBox(0.0f, 0.0f, 10.0f, 1.0f),
+    MakeBox(5.0f, -5.0f, 50.0f, 2.0f),
+    MakeBox(0.0f, 0.0f, kFar - 2.0f, 1.0f),
+};
+
+const BoundingBox kOutside[] = {
+    MakeBox(0.0f, 0.0f, -10.0f, 1.0f),          // Behind the camera
+    MakeBox(0.0f, 0.0f, 0.25f, 0.5f),           // Between the camera and the near plane
+    MakeBox(0.0f, 0.0f, kFar + 10.0f, 1.0f),    // Past the far plane
+    MakeBox(-30.0f, 0.0f, 10.0f, 1.0f),         // Left
+    MakeBox(30.0f, 0.0f, 10.0f, 1.0f),          // Right
+    MakeBox(0.0f, -30.0f, 10.0f, 1.0f),         // Below
+    MakeBox(0.0f, 30.0f, 10.0f, 1.0f),          // Above
+};
+
+const BoundingBox kStraddling[] = {
+    MakeBox(0.0f, 0.0f, kNear, 0.5f),
+    MakeBox(0.0f, 0.0f, kFar, 1.0f),
+    MakeBox(-10.0f, 0.0f, 10.0f, 1.0f),
+    MakeBox(10.0f, 0.0f, 10.0f, 1.0f),
+    MakeBox(0.0f, -10.0f, 10.0f, 1.0f),
+    MakeBox(0.0f, 10.0f, 10.0f, 1.0f),
+    MakeBox(0.0f, 0.0f, 10.0f, 500.0f),         // Around the whole frustum
+};
+
+}
+
+TEST(FrustumCullerClassifiesBoxes)
+{
+    auto culler = MakeCuller();
+    for (const auto& box : kInside)
+        EXPECT(culler.Classify(box) == CONTAINS);
+    for (const auto& box : kOutside)
+        EXPECT(culler.Classify(box) == DISJOINT);
+    for (const auto& box : kStraddling)
+        EXPECT(culler.Classify(box) == INTERSECTS);
+}
+
+TEST(FrustumCullerCullsBatchesLikeClassify)
+{
+    auto culler = MakeCuller();
+    // Interleaved and not a multiple of four, so both the SIMD path and the remainder see every kind of box
+    std::vector<BoundingBox> boxes;
+    std::vector<bool> expected;
+    for (std::size_t i = 0; i < std::size(kOutside); ++i) {
+        boxes.push_back(kOutside[i]);
+        expected.push_back(false);
+        if (i < std::size(kInside)) {
+            boxes.push_back(kInside[i]);
+            expected.push_back(true);
+        }
+        boxes.push_back(kStraddling[i]);
+        expected.push_back(true);
+    }
+    EXPECT(boxes.size() % 4 != 0);
+
+    std::vector<uint32_t> visibleIndices(boxes.size());
+    uint32_t numVisible = culler.CullBoxes(boxes.data(), (uint32_t)boxes.size(), visibleIndices.data());
+    std::vector<bool> visible(boxes.size(), false);
+    for (uint32_t i = 0; i < numVisible; ++i)
+        visible[visibleIndices[i]] = true;
+    EXPECT(visible == expected);
+    // In order
+    for (uint32_t i = 1; i < numVisible; ++i)
+        EXPECT(visibleIndices[i - 1] < visibleIndices[i]);
+
+    const auto& statistics = culler.GetStatistics();
+    EXPECT(statistics.VisibleInstances == numVisible);
+    EXPECT(statistics.CulledInstances == (uint32_t)std::size(kOutside));
+}
+
+TEST(FrustumCullerCountsChunks)
+{
+    auto culler = MakeCuller();
+    EXPECT(culler.ClassifyChunk(kInside[0], 10) == CONTAINS);
+    EXPECT(culler.ClassifyChunk(kOutside[0], 20) == DISJOINT);
+    // The instances of a straddling chunk are counted when they are culled one by one
+    EXPECT(culler.ClassifyChunk(kStraddling[0], 30) == INTERSECTS);
+    EXPECT(culler.IsVisible(kInside[1]));
+    EXPECT(!culler.IsVisible(kOutside[1]));
+
+    const auto& statistics = culler.GetStatistics();
+    EXPECT(statistics.VisibleChunks == 2);
+    EXPECT(statistics.CulledChunks == 1);
+    EXPECT(statistics.VisibleInstances == 11);
+    EXPECT(statistics.CulledInstances == 21);
+
+    // Update starts a new frame
+    culler = MakeCuller();
+    EXPECT(culler.GetStatistics().VisibleChunks == 0);
+}
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "LightBinner.h"
+#include "Test.h"
+
+
+// Random torches around the origin, compared against going through every light
+namespace {
+
+constexpr float kClusterSize = 20.0f;
+constexpr float kOrigin = -(float)LightBinner::kClustersAcross * kClusterSize / 2.0f;
+
+std::vector<PointLight> MakeLights(uint32_t count)
+{
+    std::mt19937 random(35);
+    std::uniform_real_distribution<float> position(-800.0f, 800.0f);
+    std::uniform_real_distribution<float> falloff(5.0f, 40.0f);
+    std::vector<PointLight> lights(count);
+    for (auto& light : lights) {
+        light = { { position(random), 2.0f, position(random) }, 1.0f, { 1.0f, 0.8f, 0.5f }, falloff(random) };
+    }
+    return lights;
+}
+
+float GetDistanceSquared(const PointLight& light, float x, float z)
+{
+    float dx = light.Position[0] - x, dz = light.Position[2] - z;
+    return dx * dx + dz * dz;
+}
+
+}
+
+TEST(LightBinnerFindsTheClosestLights)
+{
+    auto lights = MakeLights(4000);
+    std::mt19937 random(36);
+    std::uniform_real_distribution<float> position(-800.0f, 800.0f);
+    for (uint32_t point = 0; point < 100; ++point) {
+        float x = position(random), z = position(random);
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0; i < (uint32_t)lights.size(); ++i) {
+            if (GetDistanceSquared(lights[i], x, z) <= lights[i].FalloffEnd * lights[i].FalloffEnd)
+                expected.push_back(i);
+        }
+        std::stable_sort(expected.begin(), expected.end(), [&](uint32_t lhs, uint32_t rhs) {
+            return GetDistanceSquared(lights[lhs], x, z) < GetDistanceSquared(lights[rhs], x, z);
+        });
+
+        for (uint32_t maxLights : { 0u, 1u, 4u, 10u }) {
+            uint32_t closest[10];
+            auto numClosest = LightBinner::FindClosestLights(lights.data(), (uint32_t)lights.size(), x, z, maxLights, closest);
+            EXPECT(numClosest == std::min<uint32_t>(maxLights, (uint32_t)expected.size()));
+            for (uint32_t i = 0; i < numClosest; ++i)
+                EXPECT(closest[i] == expected[i]);
+        }
+    }
+}
+
+TEST(LightBinnerMatchesBruteForceCounts)
+{
+    auto lights = MakeLights(4000);
+    LightBinner binner;
+    binner.Bin(lights.data(), (uint32_t)lights.size(), kOrigin, kOrigin, kClusterSize, 4096, 65536);
+
+    // A light is in a cluster when its falloff sphere reaches the cluster's square
+    const auto& binnedLights = binner.GetBinnedLights();
+    const auto& clusters = binner.GetClusters();
+    const auto& indices = binner.GetLightIndices();
+    EXPECT(clusters.size() == LightBinner::kNumClusters);
+    uint32_t mismatches = 0;
+    for (uint32_t z = 0; z < LightBinner::kClustersAcross; ++z) {
+        for (uint32_t x = 0; x < LightBinner::kClustersAcross; ++x) {
+            float minX = kOrigin + x * kClusterSize, minZ = kOrigin + z * kClusterSize;
+            std::vector<uint32_t> expected;
+            for (uint32_t i = 0; i < (uint32_t)lights.size(); ++i) {
+                float closestX = std::clamp(lights[i].Position[0], minX, minX + kClusterSize);
+                float closestZ = std::clamp(lights[i].Position[2], minZ, minZ + kClusterSize);
+                if (GetDistanceSquared(lights[i], closestX, closestZ) <= lights[i].FalloffEnd * lights[i].FalloffEnd)
+                    expected.push_back(i);
+            }
+            const auto& cluster = clusters[z * LightBinner::kClustersAcross + x];
+            std::vector<uint32_t> binned;
+            for (uint32_t i = 0; i < cluster.Count; ++i)
+                binned.push_back(binnedLights[indices[cluster.Offset + i]]);
+            std::sort(binned.begin(), binned.end());
+            mismatches += binned != expected;
+        }
+    }
+    EXPECT(mismatches == 0);
+}
@@ -0,0 +1,140 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <string>
+
+#include "MazeFile.h"
+#include "Test.h"
+
+
+// A small baked level, then the same file with one header field broken at a time. Every broken header must be refused,
+// including the ones whose sizes only look right once they wrap around
+namespace {
+
+constexpr uint64_t kMaxOffset = std::numeric_limits<uint64_t>::max();
+
+std::string GetLevelPath()
+{
+    return (std::filesystem::temp_directory_path() / "SurvivalMazeTests.level").string();
+}
+
+bool WriteLevel(const std::string& path)
+{
+    MazeGrid grid(5, 7);
+    for (int32_t i = 1; i < 4; ++i)
+        grid.Set(i, 3, TileType::Free);
+    grid.Set(2, 3, TileType::Enemy);
+    return MazeFile::Write(path, grid, { 3, 1 }, 5.0f);
+}
+
+// Rewrites the header of the level at path, the rest of the file stays as it was baked
+bool OpensWithHeader(const std::string& path, const std::function<void(MazeFileHeader&)>& change)
+{
+    MazeFileHeader header;
+    {
+        std::ifstream stream(path, std::ios::binary);
+        stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+    }
+    auto original = header;
+    change(header);
+    {
+        std::fstream stream(path, std::ios::binary | std::ios::in | std::ios::out);
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    MazeFile file;
+    bool opened = file.Open(path);
+    file.Close();
+    {
+        std::fstream stream(path, std::ios::binary | std::ios::in | std::ios::out);
+        stream.write(reinterpret_cast<const char*>(&original), sizeof(original));
+    }
+    return opened;
+}
+
+// Overwrites the tile at index of the level at path with value, then puts it back
+bool OpensWithTile(const std::string& path, uint64_t index, uint8_t value)
+{
+    MazeFileHeader header;
+    uint8_t original;
+    {
+        std::fstream stream(path, std::ios::binary | std::ios::in | std::ios::out);
+        stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+        stream.seekg((std::streamoff)(header.TilesOffset + index));
+        stream.read(reinterpret_cast<char*>(&original), 1);
+        stream.seekp((std::streamoff)(header.TilesOffset + index));
+        stream.write(reinterpret_cast<const char*>(&value), 1);
+    }
+    MazeFile file;
+    bool opened = file.Open(path);
+    file.Close();
+    {
+        std::fstream stream(path, std::ios::binary | std::ios::in | std::ios::out);
+        stream.seekp((std::streamoff)(header.TilesOffset + index));
+        stream.write(reinterpret_cast<const char*>(&original), 1);
+    }
+    return opened;
+}
+
+}
+
+TEST(MazeFileOpensWhatItWrites)
+{
+    auto path = GetLevelPath();
+    EXPECT(WriteLevel(path));
+    MazeFile file;
+    bool opened = file.Open(path);
+    EXPECT(opened);
+    if (opened) {
+        const auto& header = file.GetHeader();
+        EXPECT(header.Rows == 5 && header.Cols == 7);
+        EXPECT(header.NumEnemies == 1);
+        EXPECT(file.GetTiles()[2 * 7 + 3] == TileType::Enemy);
+        EXPECT(file.GetEnemySpawns()[0].x == 3 && file.GetEnemySpawns()[0].y == 2);
+    }
+    file.Close();
+    std::remove(path.c_str());
+}
+
+TEST(MazeFileRefusesBrokenHeaders)
+{
+    auto path = GetLevelPath();
+    EXPECT(WriteLevel(path));
+    EXPECT(OpensWithHeader(path, [](MazeFileHeader&) {}));
+
+    // Sections overlapping the header or each other
+    EXPECT(!OpensWithHeader(path, [](MazeFileHeader& header) { header.TilesOffset = 0; }));
+    EXPECT(!OpensWithHeader(path, [](MazeFileHeader& header) { header.EnemiesOffset = header.TilesOffset; }));
+    EXPECT(!OpensWithHeader(path, [](MazeFileHeader& header) { header.InstancesOffset = header.EnemiesOffset; }));
+    // Not on a section boundary
+    EXPECT(!OpensWithHeader(path, [](MazeFileHeader& header) { header.InstancesOffset += 4; }));
+    // More tiles than the file holds
+    EXPECT(!OpensWithHeader(path, [](MazeFileHeader& header) { header.Rows = 0xffffffffu; header.Cols = 0xffffffffu; }));
+    EXPECT(!OpensWithHeader(path, [](MazeFileHeader& header) { header.Rows++; }));
+    // Counts and offsets that wrap around to something that fits
+    EXPECT(!OpensWithHeader(path, [](MazeFileHeader& header) { header.NumEnemies = (kMaxOffset / 8) + 2; }));
+    EXPECT(!OpensWithHeader(path, [](MazeFileHeader& header) {
+        header.InstancesOffset = kMaxOffset - MazeFile::kSectionAlignment + 1;
+    }));
+    EXPECT(!OpensWithHeader(path, [](MazeFileHeader& header) {
+        header.EnemiesOffset = kMaxOffset - MazeFile::kSectionAlignment + 1;
+    }));
+    // Not the file it describes
+    EXPECT(!OpensWithHeader(path, [](MazeFileHeader& header) { header.FileSize++; }));
+    EXPECT(!OpensWithHeader(path, [](MazeFileHeader& header) { header.Version++; }));
+    EXPECT(!OpensWithHeader(path, [](MazeFileHeader& header) { header.StartX = (int32_t)header.Cols; }));
+    std::remove(path.c_str());
+}
+
+TEST(MazeFileRefusesUnknownTiles)
+{
+    auto path = GetLevelPath();
+    EXPECT(WriteLevel(path));
+    EXPECT(OpensWithTile(path, 0, (uint8_t)TileType::Wall));
+    EXPECT(OpensWithTile(path, 2 * 7 + 3, (uint8_t)TileType::Enemy));
+    EXPECT(!OpensWithTile(path, 0, (uint8_t)TileType::Enemy + 1));
+    EXPECT(!OpensWithTile(path, 5 * 7 - 1, 0xff));
+    EXPECT(OpensWithHeader(path, [](MazeFileHeader&) {}));
+    std::remove(path.c_str());
+}
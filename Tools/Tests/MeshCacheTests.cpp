@@ -0,0 +1,66 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "MeshCache.h"
+#include "Test.h"
+
+
+// The hash must change with the material libraries the OBJ actually names, and only with those
+namespace {
+
+std::filesystem::path GetMeshDirectory()
+{
+    return std::filesystem::temp_directory_path() / "SurvivalMazeTestsMeshes";
+}
+
+void WriteText(const std::filesystem::path& path, const std::string& text)
+{
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    stream << text;
+}
+
+uint64_t GetHash(const std::filesystem::path& path)
+{
+    uint64_t hash = 0;
+    EXPECT(MeshCache::HashSource(path.string(), hash));
+    return hash;
+}
+
+}
+
+TEST(MeshCacheHashesTheNamedMaterialLibraries)
+{
+    auto directory = GetMeshDirectory();
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+    std::filesystem::create_directories(directory / "materials", error);
+    EXPECT(!error);
+
+    auto meshPath = directory / "Box.obj";
+    WriteText(meshPath, "# A box\n  mtllib materials/Shared.mtl \r\nv 0 0 0\nusemtl Red\n");
+    WriteText(directory / "materials" / "Shared.mtl", "newmtl Red\nKd 1 0 0\n");
+    auto hash = GetHash(meshPath);
+
+    // A library with the mesh's name that it doesn't use
+    WriteText(directory / "Box.mtl", "newmtl Green\nKd 0 1 0\n");
+    EXPECT(GetHash(meshPath) == hash);
+
+    WriteText(directory / "materials" / "Shared.mtl", "newmtl Red\nKd 0.9 0 0\n");
+    auto changedHash = GetHash(meshPath);
+    EXPECT(changedHash != hash);
+
+    // Libraries that don't exist yet count too, so creating them changes the hash
+    WriteText(meshPath, "mtllib materials/Shared.mtl\nmtllib Later.mtl\nv 0 0 0\n");
+    auto missingHash = GetHash(meshPath);
+    WriteText(directory / "Later.mtl", "newmtl Blue\nKd 0 0 1\n");
+    EXPECT(GetHash(meshPath) != missingHash);
+
+    // Only whole keywords at the start of a line
+    WriteText(meshPath, "v 0 0 0\n# mtllib Later.mtl\nmtllibLater.mtl\n");
+    auto commentedHash = GetHash(meshPath);
+    WriteText(directory / "Later.mtl", "newmtl Blue\nKd 0 0 0.5\n");
+    EXPECT(GetHash(meshPath) == commentedHash);
+
+    std::filesystem::remove_all(directory, error);
+}
@@ -0,0 +1,228 @@
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "SpectatorCodec.h"
+#include "Test.h"
+
+
+// Frames go through Encode, DecodeHeader and DecodeBody like they do between the game and a spectator
+namespace {
+
+bool SameEntity(const QuantizedEntity& lhs, const QuantizedEntity& rhs)
+{
+    return lhs.Id == rhs.Id && lhs.Flags == rhs.Flags && lhs.X == rhs.X && lhs.Y == rhs.Y && lhs.Z == rhs.Z &&
+        lhs.Heading == rhs.Heading;
+}
+
+bool SameFrame(const QuantizedFrame& lhs, const QuantizedFrame& rhs)
+{
+    if (lhs.Tick != rhs.Tick || lhs.Health != rhs.Health || lhs.RemainingTime != rhs.RemainingTime ||
+        lhs.Entities.size() != rhs.Entities.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < lhs.Entities.size(); ++i) {
+        if (!SameEntity(lhs.Entities[i], rhs.Entities[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QuantizedEntity MakeEntity(SpectatorEntityKind kind, uint32_t index, int32_t x, int32_t z)
+{
+    return { SpectatorEntity::MakeId(kind, index), 0, x, 64, z, index % (1u << kSpectatorHeadingBits) };
+}
+
+QuantizedFrame MakeFrame(uint32_t tick)
+{
+    QuantizedFrame frame;
+    frame.Tick = tick;
+    frame.Health = 0.75f;
+    frame.RemainingTime = 512.5f;
+    frame.Entities = {
+        MakeEntity(SpectatorEntityKind::Player, 0, 100, -200),
+        MakeEntity(SpectatorEntityKind::Enemy, 0, -3000, 4000),
+        MakeEntity(SpectatorEntityKind::Enemy, 1, 3000, 4000),
+        MakeEntity(SpectatorEntityKind::Enemy, 7, 0, 0),
+        MakeEntity(SpectatorEntityKind::Projectile, 1, 50, 50),
+    };
+    return frame;
+}
+
+std::vector<uint8_t> Encode(const QuantizedFrame& frame, const QuantizedFrame* baseline)
+{
+    std::vector<uint8_t> bytes;
+    BitWriter writer(bytes);
+    SpectatorCodec::Encode(frame, baseline, writer);
+    return bytes;
+}
+
+bool Decode(const uint8_t* data, std::size_t size, const QuantizedFrame* baseline, QuantizedFrame& frame)
+{
+    BitReader reader(data, size);
+    uint32_t baselineTick;
+    if (!SpectatorCodec::DecodeHeader(reader, frame.Tick, baselineTick)) {
+        return false;
+    }
+    if (baselineTick != (baseline ? baseline->Tick : kSpectatorNoBaseline)) {
+        return false;
+    }
+    return SpectatorCodec::DecodeBody(reader, baseline, frame);
+}
+
+}
+
+TEST(SpectatorCodecQuantizesWithinHalfAStep)
+{
+    SpectatorFrame frame;
+    frame.Tick = 12;
+    frame.Entities = {
+        { SpectatorEntity::MakeId(SpectatorEntityKind::Enemy, 3), 1, 12.3456f, 1.0f, -7.891f, 2.5f },
+        { SpectatorEntity::MakeId(SpectatorEntityKind::Player, 0), 0, -500.01f, 0.0f, 250.2f, -1.0f },
+    };
+    QuantizedFrame quantized;
+    SpectatorCodec::Quantize(frame, quantized);
+    EXPECT(quantized.Entities.size() == 2);
+    EXPECT(quantized.Entities[0].Id < quantized.Entities[1].Id);
+
+    SpectatorFrame received;
+    SpectatorCodec::Dequantize(quantized, received);
+    EXPECT(received.Tick == 12);
+    for (const auto& entity : received.Entities) {
+        const auto& sent = entity.GetKind() == SpectatorEntityKind::Player ? frame.Entities[1] : frame.Entities[0];
+        EXPECT(entity.Id == sent.Id && entity.Flags == sent.Flags);
+        EXPECT(std::fabs(entity.X - sent.X) <= kSpectatorPositionStep / 2.0f);
+        EXPECT(std::fabs(entity.Y - sent.Y) <= kSpectatorPositionStep / 2.0f);
+        EXPECT(std::fabs(entity.Z - sent.Z) <= kSpectatorPositionStep / 2.0f);
+    }
+}
+
+TEST(SpectatorCodecRoundTripsFramesWithoutABaseline)
+{
+    auto frame = MakeFrame(5);
+    auto bytes = Encode(frame, nullptr);
+    QuantizedFrame decoded;
+    EXPECT(Decode(bytes.data(), bytes.size(), nullptr, decoded));
+    EXPECT(SameFrame(decoded, frame));
+}
+
+TEST(SpectatorCodecRoundTripsDeltas)
+{
+    auto baseline = MakeFrame(5);
+    auto frame = MakeFrame(9);
+    frame.Health = 0.5f;
+    auto& entities = frame.Entities;
+    entities[0].X += 3;                                 // Moved
+    entities[1].Heading = 200;                          // Turned
+    entities[2].Flags = 1;                              // Started dying
+    entities.erase(entities.begin() + 3);               // Killed
+    entities.insert(entities.begin() + 3, MakeEntity(SpectatorEntityKind::Enemy, 9, -1, 1));
+    entities.push_back(MakeEntity(SpectatorEntityKind::Projectile, 2, 10, 10));
+    entities.insert(entities.begin(), MakeEntity(SpectatorEntityKind::Player, 0, 0, 0));
+    entities.erase(entities.begin() + 1);               // Same Id, new values
+
+    auto bytes = Encode(frame, &baseline);
+    QuantizedFrame decoded;
+    EXPECT(Decode(bytes.data(), bytes.size(), &baseline, decoded));
+    EXPECT(SameFrame(decoded, frame));
+
+    // Nothing changed but the tick: two bits per entity and the header
+    auto still = baseline;
+    still.Tick = 10;
+    auto stillBytes = Encode(still, &baseline);
+    EXPECT(stillBytes.size() < Encode(still, nullptr).size());
+    EXPECT(stillBytes.size() <= 16 + (2 * baseline.Entities.size() + 1 + 7) / 8);
+    EXPECT(Decode(stillBytes.data(), stillBytes.size(), &baseline, decoded));
+    EXPECT(SameFrame(decoded, still));
+
+    // Everything gone
+    auto empty = baseline;
+    empty.Tick = 11;
+    empty.Entities.clear();
+    auto emptyBytes = Encode(empty, &baseline);
+    EXPECT(Decode(emptyBytes.data(), emptyBytes.size(), &baseline, decoded));
+    EXPECT(SameFrame(decoded, empty));
+}
+
+TEST(SpectatorCodecRejectsTruncatedFrames)
+{
+    auto baseline = MakeFrame(5);
+    auto frame = MakeFrame(6);
+    frame.Entities[1].X -= 1000;
+    frame.Entities.push_back(MakeEntity(SpectatorEntityKind::Projectile, 4, 1, 2));
+    const QuantizedFrame* baselines[] = { nullptr, &baseline };
+    for (const auto* base : baselines) {
+        auto bytes = Encode(frame, base);
+        // The last byte can be all padding
+        for (std::size_t size = 0; size + 1 < bytes.size(); ++size) {
+            QuantizedFrame decoded;
+            EXPECT(!Decode(bytes.data(), size, base, decoded));
+        }
+    }
+}
+
+TEST(SpectatorCodecRejectsBadCountsAndIds)
+{
+    QuantizedFrame decoded;
+    {
+        // More new entities than the body could ever hold
+        std::vector<uint8_t> bytes;
+        BitWriter writer(bytes);
+        writer.Write(1, 32);
+        writer.Write(kSpectatorNoBaseline, 32);
+        writer.Write(0, 32);
+        writer.Write(0, 32);
+        writer.WriteExpGolomb((1u << 24) + 1);
+        writer.Flush();
+        EXPECT(!Decode(bytes.data(), bytes.size(), nullptr, decoded));
+    }
+    {
+        // Id gaps that add up past 32 bits
+        std::vector<uint8_t> bytes;
+        BitWriter writer(bytes);
+        writer.Write(1, 32);
+        writer.Write(kSpectatorNoBaseline, 32);
+        writer.Write(0, 32);
+        writer.Write(0, 32);
+        writer.WriteExpGolomb(2);
+        for (uint32_t i = 0; i < 2; ++i) {
+            writer.WriteExpGolomb(0xFFFFFFF0u);
+            writer.WriteExpGolomb(0);
+            writer.WriteExpGolomb(0);
+            writer.WriteExpGolomb(0);
+            writer.WriteExpGolomb(0);
+            writer.Write(0, kSpectatorHeadingBits);
+        }
+        writer.Flush();
+        EXPECT(!Decode(bytes.data(), bytes.size(), nullptr, decoded));
+    }
+    {
+        // Garbage either decodes into something or is rejected, and never reads past the end
+        std::mt19937 random(42);
+        std::uniform_int_distribution<uint32_t> byte(0, 255);
+        auto baseline = MakeFrame(5);
+        for (uint32_t i = 0; i < 200; ++i) {
+            std::vector<uint8_t> bytes(1 + i % 40);
+            for (auto& value : bytes) {
+                value = (uint8_t)byte(random);
+            }
+            BitReader reader(bytes.data(), bytes.size());
+            SpectatorCodec::DecodeBody(reader, i % 2 == 0 ? &baseline : nullptr, decoded);
+        }
+    }
+}
+
+TEST(SpectatorHistoryForgetsOldFrames)
+{
+    SpectatorHistory history;
+    for (uint32_t tick = 0; tick < 2 * kSpectatorHistorySize; ++tick) {
+        history.Add(tick).Health = (float)tick;
+    }
+    EXPECT(history.Find(2 * kSpectatorHistorySize - 1) != nullptr);
+    const auto* oldest = history.Find(kSpectatorHistorySize);
+    EXPECT(oldest != nullptr && oldest->Health == (float)kSpectatorHistorySize);
+    EXPECT(history.Find(kSpectatorHistorySize - 1) == nullptr);
+    EXPECT(history.Find(2 * kSpectatorHistorySize) == nullptr);
+}
@@ -0,0 +1,74 @@
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "FrameArena.h"
+#include "MemoryTracker.h"
+#include "SimWorld.h"
+#include "Test.h"
+
+
+// Drives the headless simulation the way Application::OnUpdate drives the game: reset the frame arena, update, end
+// the frame. Once warm, no frame may allocate from any tracked resource
+namespace {
+
+constexpr uint32_t kWarmUpFrames = 120;
+constexpr uint32_t kSteadyFrames = 600;
+constexpr float kFrameTime = 1.0f / 60.0f;
+
+// Walks back and forth and shoots now and then, so enemies die and projectiles come and go while it runs
+SimWorld::Action GetAction(uint32_t frame)
+{
+    SimWorld::Action action = {};
+    action.moveX = (frame / 90) % 2 == 0 ? 1.0f : -1.0f;
+    action.shoot = frame % 20 == 0;
+    action.aimX = (frame / 20) % 2 == 0 ? 1.0f : 0.0f;
+    action.aimZ = 1.0f - action.aimX;
+    return action;
+}
+
+// Frame scratch, like the culling and light binning the game does every frame
+void UseFrameArena(const SimWorld& world, std::size_t extraBytes)
+{
+    auto& arena = FrameArena::Get();
+    std::pmr::vector<float> distances(&arena);
+    distances.reserve(world.GetEnemies().size());
+    float position[3];
+    for (const auto& enemy : world.GetEnemies()) {
+        enemy.GetPosition((float)world.GetTime(), position);
+        distances.push_back(position[0] - world.GetPlayerX());
+    }
+    if (extraBytes > 0) {
+        arena.AllocateArray<uint8_t>(extraBytes);
+    }
+}
+
+}
+
+TEST(SimulationFramesDontAllocateOnceWarm)
+{
+    auto& memoryTracker = MemoryTracker::Get();
+    SimWorld world(memoryTracker.GetResource(MemoryTag::Enemies));
+    SimWorld::Config config;
+    config.rows = 41;
+    config.cols = 41;
+    world.Reset(config, 7);
+
+    uint64_t steadyAllocations = 0;
+    uint32_t numSteadyFrames = 0;
+    for (uint32_t frame = 0; frame < kWarmUpFrames + kSteadyFrames; ++frame) {
+        FrameArena::Get().Reset();
+        memoryTracker.EndFrame();
+        if (frame > kWarmUpFrames) {
+            steadyAllocations += memoryTracker.GetFrameAllocations();
+            numSteadyFrames++;
+        }
+        if (world.Step(GetAction(frame), kFrameTime) != SimWorld::Outcome::Running) {
+            break;
+        }
+        // The first frame doesn't fit in the arena, which has to grow while warming up
+        UseFrameArena(world, frame == 0 ? FrameArena::kInitialCapacity : 0);
+    }
+    EXPECT(numSteadyFrames > kSteadyFrames / 2);
+    EXPECT(steadyAllocations == 0);
+}
@@ -0,0 +1,119 @@
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TaskGraph.h"
+#include "Test.h"
+
+
+// Every task records when it ran, in one order shared by all threads
+namespace {
+
+struct RunOrder {
+    std::mutex Mutex;
+    std::vector<std::string> Names;
+
+    std::function<bool()> Record(std::string name, bool succeeds = true)
+    {
+        return [this, name, succeeds]() {
+            std::unique_lock<std::mutex> lock(Mutex);
+            Names.push_back(name);
+            return succeeds;
+        };
+    }
+
+    int GetPosition(const std::string& name)
+    {
+        std::unique_lock<std::mutex> lock(Mutex);
+        for (std::size_t i = 0; i < Names.size(); ++i) {
+            if (Names[i] == name) {
+                return (int)i;
+            }
+        }
+        return -1;
+    }
+};
+
+void WaitForAll(TaskGraph& graph)
+{
+    while (!graph.Poll()) {
+        std::this_thread::yield();
+    }
+}
+
+}
+
+TEST(TaskGraphRunsTasksAfterTheirDependencies)
+{
+    ThreadPool threadPool(4);
+    RunOrder order;
+    TaskGraph graph;
+    auto load = graph.Add("load", order.Record("load"));
+    auto left = graph.Add("left", order.Record("left"), { load });
+    auto right = graph.Add("right", order.Record("right"), { load });
+    auto join = graph.Add("join", order.Record("join"), { left, right });
+    graph.Start(threadPool);
+    EXPECT(graph.Wait(join));
+    WaitForAll(graph);
+
+    EXPECT(graph.Succeeded());
+    EXPECT(order.Names.size() == 4);
+    EXPECT(order.GetPosition("load") == 0);
+    EXPECT(order.GetPosition("join") == 3);
+    for (auto task : { load, left, right, join }) {
+        const auto& timing = graph.GetTiming(task);
+        EXPECT(timing.Ran && timing.Succeeded && timing.StartMs <= timing.EndMs);
+    }
+    EXPECT(graph.GetTiming(join).StartMs >= graph.GetTiming(left).EndMs);
+    EXPECT(graph.GetTiming(join).StartMs >= graph.GetTiming(right).EndMs);
+}
+
+TEST(TaskGraphSkipsTheDependentsOfFailedTasks)
+{
+    ThreadPool threadPool(2);
+    RunOrder order;
+    TaskGraph graph;
+    auto load = graph.Add("load", order.Record("load", false));
+    auto other = graph.Add("other", order.Record("other"));
+    auto use = graph.Add("use", order.Record("use"), { load });
+    auto useMore = graph.AddOnWaitingThread("use more", order.Record("use more"), { use, other });
+    graph.Start(threadPool);
+    EXPECT(!graph.Wait(useMore));
+    WaitForAll(graph);
+
+    EXPECT(!graph.Succeeded());
+    EXPECT(order.GetPosition("load") >= 0);
+    EXPECT(order.GetPosition("other") >= 0);
+    EXPECT(order.GetPosition("use") == -1);
+    EXPECT(order.GetPosition("use more") == -1);
+    EXPECT(graph.GetTiming(load).Ran && !graph.GetTiming(load).Succeeded);
+    EXPECT(!graph.GetTiming(use).Ran && !graph.GetTiming(useMore).Ran);
+    EXPECT(graph.FormatTimeline().find("skipped") != std::string::npos);
+}
+
+TEST(TaskGraphRunsWaitingThreadTasksOnTheWaitingThread)
+{
+    ThreadPool threadPool(2);
+    TaskGraph graph;
+    std::atomic<bool> onWaitingThread = false;
+    auto waitingThread = std::this_thread::get_id();
+    auto work = graph.Add("work", []() { return true; });
+    auto upload = graph.AddOnWaitingThread("upload",
+        [&]() {
+            onWaitingThread = std::this_thread::get_id() == waitingThread;
+            return true;
+        }, { work });
+    graph.Add("after", []() { return true; }, { upload });
+    graph.Start(threadPool);
+    WaitForAll(graph);
+
+    EXPECT(graph.Succeeded());
+    EXPECT(onWaitingThread);
+    EXPECT(graph.GetTiming(upload).Thread == 0);
+    auto timeline = graph.FormatTimeline();
+    for (const char* name : { "work", "upload", "after" }) {
+        EXPECT(timeline.find(name) != std::string::npos);
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+
+#include <cstdio>
+#include <vector>
+
+
+// Just enough of a test framework for the tools: TEST registers a function, EXPECT reports a failed condition and
+// lets the test carry on, so one run shows everything that is wrong. main runs every test and fails if any EXPECT did
+
+struct TestCase {
+    const char* Name;
+    void (*Function)();
+};
+
+inline std::vector<TestCase>& GetTestCases()
+{
+    static std::vector<TestCase> testCases;
+    return testCases;
+}
+
+inline int& GetTestFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+struct TestRegistration {
+    TestRegistration(const char* name, void (*function)())
+    {
+        GetTestCases().push_back({ name, function });
+    }
+};
+
+#define TEST(name) \
+    static void name(); \
+    static TestRegistration name##Registration(#name, name); \
+    static void name()
+
+#define EXPECT(condition) \
+    do { \
+        if (!(condition)) { \
+            std::printf("%s:%d: expected %s\n", __FILE__, __LINE__, #condition); \
+            GetTestFailures()++; \
+        } \
+    } while (false)
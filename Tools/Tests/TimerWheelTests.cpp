@@ -0,0 +1,234 @@
+#include <cstdint>
+#include <vector>
+
+#include "Test.h"
+#include "TimerWheel.h"
+
+
+// The wheel has no clock of its own, so the tests drive it with whole ticks and record the tick every timer fires on
+namespace {
+
+constexpr uint64_t kLevelTicks[TimerWheel::kNumLevels + 1] = {
+    1,
+    TimerWheel::kSlotsPerLevel,
+    (uint64_t)TimerWheel::kSlotsPerLevel * TimerWheel::kSlotsPerLevel,
+    (uint64_t)TimerWheel::kSlotsPerLevel * TimerWheel::kSlotsPerLevel * TimerWheel::kSlotsPerLevel,
+    (uint64_t)TimerWheel::kSlotsPerLevel * TimerWheel::kSlotsPerLevel * TimerWheel::kSlotsPerLevel * TimerWheel::kSlotsPerLevel,
+};
+
+constexpr uint64_t kNotFired = UINT64_MAX;
+
+struct FakeClock {
+    TimerWheel Wheel{ 1.0 };
+    uint64_t Now = 0;
+    std::vector<uint64_t> FiredAt;
+
+    TimerWheel::TimerId Add(uint64_t tick)
+    {
+        auto index = FiredAt.size();
+        FiredAt.push_back(kNotFired);
+        return Wheel.Add((double)tick, [this, index]() { FiredAt[index] = Now; });
+    }
+
+    void AdvanceTo(uint64_t tick)
+    {
+        Now = tick;
+        Wheel.Advance((double)tick);
+    }
+
+    // One Advance per tick, so every timer records exactly the tick it fired on
+    void StepTo(uint64_t tick)
+    {
+        while (Now < tick)
+            AdvanceTo(Now + 1);
+    }
+};
+
+}
+
+TEST(TimerWheelFiresOnTheDeadlineTick)
+{
+    TimerWheel wheel(0.5);
+    int fired = 0;
+    wheel.Add(1.2, [&fired]() { fired++; }); // Rounded up to tick 3, at 1.5
+    wheel.Advance(1.4);
+    EXPECT(fired == 0);
+    wheel.Advance(1.5);
+    EXPECT(fired == 1);
+    EXPECT(wheel.GetNumPending() == 0);
+}
+
+TEST(TimerWheelCascadesThroughEveryLevel)
+{
+    FakeClock clock;
+    // One timer starting out in each level, off the slot boundaries so a cascade that lands a level too low shows
+    std::vector<uint64_t> deadlines;
+    for (uint32_t level = 0; level < TimerWheel::kNumLevels; ++level)
+        deadlines.push_back(kLevelTicks[level] * 2 + 3 * level + 1);
+    // And the last tick every level covers from the start
+    for (uint32_t level = 1; level <= TimerWheel::kNumLevels; ++level)
+        deadlines.push_back(kLevelTicks[level] - 1);
+    for (auto deadline : deadlines)
+        clock.Add(deadline);
+
+    clock.StepTo(kLevelTicks[TimerWheel::kNumLevels]);
+    for (std::size_t i = 0; i < deadlines.size(); ++i)
+        EXPECT(clock.FiredAt[i] == deadlines[i]);
+    EXPECT(clock.Wheel.GetNumPending() == 0);
+}
+
+TEST(TimerWheelCascadesOnLargeAdvances)
+{
+    FakeClock clock;
+    clock.Add(kLevelTicks[3] + 5);
+    clock.Add(kLevelTicks[3] * 3 + kLevelTicks[2] + 7);
+    // Jumping over deadlines fires them late but never early or twice
+    clock.AdvanceTo(kLevelTicks[3] + 4);
+    EXPECT(clock.FiredAt[0] == kNotFired);
+    clock.AdvanceTo(kLevelTicks[3] * 3);
+    EXPECT(clock.FiredAt[0] == kLevelTicks[3] * 3);
+    EXPECT(clock.FiredAt[1] == kNotFired);
+    clock.StepTo(kLevelTicks[3] * 3 + kLevelTicks[2] + 7);
+    EXPECT(clock.FiredAt[1] == kLevelTicks[3] * 3 + kLevelTicks[2] + 7);
+}
+
+TEST(TimerWheelKeepsFarTimersInTheOverflowSlot)
+{
+    FakeClock clock;
+    uint64_t span = kLevelTicks[TimerWheel::kNumLevels];
+    clock.Add(span + 17);
+    clock.Add(span * 2 + kLevelTicks[2] + 5); // Still past the top level after the first wrap
+    clock.Add(span - 1);
+
+    clock.AdvanceTo(span - 2);
+    EXPECT(clock.FiredAt[2] == kNotFired);
+    clock.StepTo(span + 16);
+    EXPECT(clock.FiredAt[2] == span - 1);
+    EXPECT(clock.FiredAt[0] == kNotFired);
+    clock.StepTo(span + 17);
+    EXPECT(clock.FiredAt[0] == span + 17);
+
+    clock.AdvanceTo(span * 2 + kLevelTicks[2] + 4);
+    EXPECT(clock.FiredAt[1] == kNotFired);
+    EXPECT(clock.Wheel.GetNumPending() == 1);
+    clock.AdvanceTo(span * 2 + kLevelTicks[2] + 5);
+    EXPECT(clock.FiredAt[1] == span * 2 + kLevelTicks[2] + 5);
+}
+
+TEST(TimerWheelIgnoresStaleIds)
+{
+    FakeClock clock;
+    auto first = clock.Add(10);
+    EXPECT(clock.Wheel.Cancel(first));
+    EXPECT(!clock.Wheel.Cancel(first));
+
+    // Reuses the node of the cancelled timer, with a new generation
+    auto second = clock.Add(10);
+    EXPECT(second != first);
+    EXPECT(!clock.Wheel.Cancel(first));
+    EXPECT(clock.Wheel.GetNumPending() == 1);
+
+    clock.StepTo(10);
+    EXPECT(clock.FiredAt[0] == kNotFired);
+    EXPECT(clock.FiredAt[1] == 10);
+    EXPECT(!clock.Wheel.Cancel(second));
+    EXPECT(!clock.Wheel.Cancel(TimerWheel::kNoTimer));
+}
+
+TEST(TimerWheelReschedules)
+{
+    FakeClock clock;
+    auto timer = clock.Add(kLevelTicks[2] + 3);
+    clock.StepTo(kLevelTicks[1]);
+    // Moving a timer is cancelling it and adding it again, earlier and later
+    EXPECT(clock.Wheel.Cancel(timer));
+    timer = clock.Add(kLevelTicks[1] + 2);
+    EXPECT(clock.Wheel.Cancel(timer));
+    clock.Add(kLevelTicks[3] + 1);
+    clock.StepTo(kLevelTicks[3] + 1);
+    EXPECT(clock.FiredAt[0] == kNotFired);
+    EXPECT(clock.FiredAt[1] == kNotFired);
+    EXPECT(clock.FiredAt[2] == kLevelTicks[3] + 1);
+}
+
+TEST(TimerWheelReschedulesLikeItAdds)
+{
+    FakeClock clock;
+    std::vector<TimerWheel::TimerId> sameTick;
+    // Timers of a tick fire in the order they were added, so this callback runs first on tick 20 and moves the
+    // timers due with it before they fire, to times already reached
+    clock.Wheel.Add(20.0, [&]() {
+        for (auto timer : sameTick)
+            EXPECT(clock.Wheel.Reschedule(timer, 20.0));
+        EXPECT(clock.Wheel.Reschedule(sameTick[0], 19.0));
+        clock.Add(20);
+    });
+    for (uint32_t i = 0; i < 3; ++i)
+        sameTick.push_back(clock.Add(20));
+    // Earlier, from a higher level
+    auto moved = clock.Add(kLevelTicks[2] + 3);
+    EXPECT(clock.Wheel.Reschedule(moved, 10.0));
+    clock.Add(10);
+
+    clock.StepTo(20);
+    EXPECT(clock.FiredAt[3] == 10 && clock.FiredAt[4] == 10);
+    for (std::size_t i = 0; i < 3; ++i)
+        EXPECT(clock.FiredAt[i] == kNotFired);
+    clock.StepTo(21);
+    // Where an Add from the same callback goes
+    EXPECT(clock.FiredAt[5] == 21);
+    for (std::size_t i = 0; i < 3; ++i)
+        EXPECT(clock.FiredAt[i] == 21);
+    EXPECT(clock.Wheel.GetNumPending() == 0);
+    EXPECT(!clock.Wheel.Reschedule(moved, 30.0));
+    EXPECT(!clock.Wheel.Reschedule(TimerWheel::kNoTimer, 30.0));
+}
+
+TEST(TimerWheelCallbacksAddForLaterTicks)
+{
+    TimerWheel wheel(1.0);
+    uint64_t now = 0;
+    std::vector<uint64_t> firedAt;
+    wheel.Add(5.0, [&]() {
+        firedAt.push_back(now);
+        // Already due, and a whole level away, which is the slot being fired
+        wheel.Add((double)now, [&]() { firedAt.push_back(now); });
+        wheel.Add((double)(now + TimerWheel::kSlotsPerLevel), [&]() { firedAt.push_back(now); });
+    });
+    for (now = 1; now <= 5 + TimerWheel::kSlotsPerLevel; ++now)
+        wheel.Advance((double)now);
+    EXPECT(firedAt.size() == 3);
+    EXPECT(firedAt.size() == 3 && firedAt[0] == 5 && firedAt[1] == 6 && firedAt[2] == 5 + TimerWheel::kSlotsPerLevel);
+}
+
+TEST(TimerWheelResetsAfterLoadingState)
+{
+    // What Maze::LoadState does: drop the timers of the old run, move the wheel to the saved time and add them again
+    FakeClock clock;
+    auto old = clock.Add(200);
+    clock.Add(kLevelTicks[2] * 3);
+    clock.StepTo(150);
+
+    clock.Wheel.Reset(40.0);
+    clock.Now = 40;
+    EXPECT(clock.Wheel.GetNumPending() == 0);
+    EXPECT(!clock.Wheel.Cancel(old));
+
+    clock.Add(41);
+    clock.Add(40); // Already reached, fires on the next tick
+    clock.Add(kLevelTicks[1] * 2);
+    clock.StepTo(41);
+    EXPECT(clock.FiredAt[2] == 41);
+    EXPECT(clock.FiredAt[3] == 41);
+    clock.StepTo(kLevelTicks[2] * 3);
+    EXPECT(clock.FiredAt[0] == kNotFired);
+    EXPECT(clock.FiredAt[1] == kNotFired);
+    EXPECT(clock.FiredAt[4] == kLevelTicks[1] * 2);
+
+    // Loading a later state works the same
+    clock.Wheel.Reset(1000.0);
+    clock.Now = 1000;
+    clock.Add(500);
+    clock.AdvanceTo(1001);
+    EXPECT(clock.FiredAt[5] == 1001);
+}
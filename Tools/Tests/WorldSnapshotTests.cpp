@@ -0,0 +1,117 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Test.h"
+#include "WorldSnapshot.h"
+
+
+// A snapshot of a small made up world: a value, an array and an empty section
+namespace {
+
+struct Body {
+    float Position[3];
+    uint32_t Id;
+};
+
+const Body kBodies[] = {
+    { { 1.0f, 2.0f, 3.0f }, 7 },
+    { { -4.0f, 0.5f, 9.0f }, 8 },
+    { { 0.0f, 0.0f, -1.0f }, 9 },
+};
+
+void WriteWorld(WorldSnapshot& snapshot)
+{
+    snapshot.Clear();
+    snapshot.Write(42.5);
+    snapshot.Write(kBodies, 3);
+    snapshot.Write<uint32_t>(nullptr, 0);
+}
+
+// Whether reader goes through the whole world and finds what WriteWorld wrote
+bool ReadWorld(WorldSnapshot::Reader& reader)
+{
+    double time = 0.0;
+    std::size_t numBodies = 0, numEmpty = 1;
+    if (!reader.Read(time)) {
+        return false;
+    }
+    const auto* bodies = reader.Read<Body>(numBodies);
+    if (!bodies) {
+        return false;
+    }
+    const auto* empty = reader.Read<uint32_t>(numEmpty);
+    return empty && time == 42.5 && numBodies == 3 && numEmpty == 0 &&
+        std::memcmp(bodies, kBodies, sizeof(kBodies)) == 0 && !reader.Failed();
+}
+
+}
+
+TEST(WorldSnapshotRoundTrips)
+{
+    WorldSnapshot snapshot;
+    WriteWorld(snapshot);
+    WorldSnapshot::Reader reader(snapshot);
+    EXPECT(ReadWorld(reader));
+
+    // Saved somewhere else and brought back
+    std::vector<uint8_t> saved(snapshot.GetData(), snapshot.GetData() + snapshot.GetSize());
+    WorldSnapshot copy;
+    copy.Assign(saved.data(), saved.size());
+    WorldSnapshot::Reader copyReader(copy);
+    EXPECT(ReadWorld(copyReader));
+}
+
+TEST(WorldSnapshotKeepsItsMemory)
+{
+    WorldSnapshot snapshot;
+    WriteWorld(snapshot);
+    const auto* data = snapshot.GetData();
+    auto size = snapshot.GetSize();
+    WriteWorld(snapshot);
+    EXPECT(snapshot.GetData() == data);
+    EXPECT(snapshot.GetSize() == size);
+}
+
+TEST(WorldSnapshotRejectsTruncatedSnapshots)
+{
+    WorldSnapshot snapshot;
+    WriteWorld(snapshot);
+    for (std::size_t size = 0; size < snapshot.GetSize(); ++size) {
+        WorldSnapshot truncated;
+        truncated.Assign(snapshot.GetData(), size);
+        WorldSnapshot::Reader reader(truncated);
+        EXPECT(!ReadWorld(reader));
+        EXPECT(reader.Failed());
+    }
+}
+
+TEST(WorldSnapshotRejectsOtherTypes)
+{
+    WorldSnapshot snapshot;
+    WriteWorld(snapshot);
+    WorldSnapshot::Reader reader(snapshot);
+    float time;
+    EXPECT(!reader.Read(time));
+    // Failing is for good, the rest can't be trusted either
+    std::size_t numBodies;
+    EXPECT(reader.Read<Body>(numBodies) == nullptr);
+    EXPECT(reader.Failed());
+}
+
+TEST(WorldSnapshotRejectsHugeCounts)
+{
+    WorldSnapshot snapshot;
+    snapshot.Write(kBodies, 3);
+    // Counts that wrap around when multiplied by the size of a Body
+    for (uint64_t count : { UINT64_MAX, UINT64_MAX / sizeof(Body) + 1, (UINT64_MAX / sizeof(Body)) * 2 }) {
+        std::vector<uint8_t> corrupted(snapshot.GetData(), snapshot.GetData() + snapshot.GetSize());
+        std::memcpy(corrupted.data(), &count, sizeof(count));
+        WorldSnapshot copy;
+        copy.Assign(corrupted.data(), corrupted.size());
+        WorldSnapshot::Reader reader(copy);
+        std::size_t numBodies = 0;
+        EXPECT(reader.Read<Body>(numBodies) == nullptr);
+        EXPECT(reader.Failed());
+    }
+}
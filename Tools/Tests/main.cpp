@@ -0,0 +1,25 @@
+#include <cstring>
+
+#include "Test.h"
+
+
+// Tests [filter], runs the tests whose name contains filter
+int main(int argc, char* argv[])
+{
+    const char* filter = argc > 1 ? argv[1] : "";
+    int numRun = 0;
+    int numFailed = 0;
+    for (const auto& testCase : GetTestCases()) {
+        if (std::strstr(testCase.Name, filter) == nullptr)
+            continue;
+        int failuresBefore = GetTestFailures();
+        testCase.Function();
+        numRun++;
+        if (GetTestFailures() != failuresBefore) {
+            std::printf("FAILED %s\n", testCase.Name);
+            numFailed++;
+        }
+    }
+    std::printf("%d tests, %d failed\n", numRun, numFailed);
+    return numFailed == 0 ? 0 : 1;
+}
@@ -31,6 +31,14 @@ bool FrameResources::Init(uint32_t numObjects, uint32_t numPasses, uint32_t numM
     }
     CHECK(LightsBuffer.Init(1, true), false,
           "Unable to initialize lights buffer with {} elements", 1);
+#if RENDERER_LIGHT_CLUSTERS
+    CHECK(PointLightsBuffer.Init(MAX_BINNED_LIGHTS, false), false,
+          "Unable to initialize point lights buffer with {} elements", MAX_BINNED_LIGHTS);
+    CHECK(LightClustersBuffer.Init(LIGHT_CLUSTERS_ACROSS * LIGHT_CLUSTERS_ACROSS, false), false,
+          "Unable to initialize light clusters buffer with {} elements", LIGHT_CLUSTERS_ACROSS * LIGHT_CLUSTERS_ACROSS);
+    CHECK(LightIndicesBuffer.Init(MAX_LIGHT_INDICES, false), false,
+          "Unable to initialize light indices buffer with {} elements", MAX_LIGHT_INDICES);
+#endif
 
     CHECK(VertexBatchRenderer.Create(), false, "Failed to create vertex batch renderer");
     CHECK(HUDBatchRenderer.Create(), false, "Failed to create HUD batch renderer");
@@ -6,6 +6,18 @@
 #include "Utils/BatchRenderer.h"
 
 
+// Set to 1 by the renderer once its instanced vertex shader reads the motion fields of InstanceInfo and
+// PerPassInfo::Time. Until then instances are drawn at their WorldMatrix and use the original layout
+#ifndef RENDERER_INSTANCE_MOTION
+#define RENDERER_INSTANCE_MOTION 0
+#endif
+
+// Set to 1 by the renderer once its forward shader shades with the clustered lights described by LightsBuffer.
+// Until then the torches closest to the camera share the fixed Lights array with the scene lights
+#ifndef RENDERER_LIGHT_CLUSTERS
+#define RENDERER_LIGHT_CLUSTERS 0
+#endif
+
 struct PerObjectInfo
 {
     DirectX::XMMATRIX World;
@@ -18,10 +30,20 @@ struct PerPassInfo
     DirectX::XMMATRIX Projection;
 
     DirectX::XMFLOAT3 CameraPosition;
+#if RENDERER_INSTANCE_MOTION
+    // Seconds of simulation, what the instances' motion is evaluated at, see InstanceInfo::MotionSpeed
+    float Time;
+#endif
 };
 
 #define MAX_LIGHTS 10
 
+// Clustered point lights (torches), binned on the CPU every frame over a grid of
+// LIGHT_CLUSTERS_ACROSS x LIGHT_CLUSTERS_ACROSS clusters on the XZ plane
+#define MAX_BINNED_LIGHTS 4096
+#define LIGHT_CLUSTERS_ACROSS 64
+#define MAX_LIGHT_INDICES 65536
+
 struct LightCB
 {
     DirectX::XMFLOAT3 Strength = { 0.5f, 0.5f, 0.5f };
@@ -41,6 +63,19 @@ struct LightsBuffer
     unsigned int NumDirectionalLights = 0;
     unsigned int NumPointLights = 0;
     unsigned int NumSpotLights = 0;
+
+#if RENDERER_LIGHT_CLUSTERS
+    // Describes the binned lights in PointLightsBuffer, LightClustersBuffer and LightIndicesBuffer
+    unsigned int NumBinnedLights = 0;
+    DirectX::XMFLOAT2 ClusterOrigin = { 0.0f, 0.0f };
+    float ClusterSize = 1.0f;
+#endif
+};
+
+struct LightCluster
+{
+    unsigned int Offset;
+    unsigned int Count;
 };
 
 struct MaterialConstants
@@ -60,11 +95,26 @@ struct InstanceInfo
     DirectX::XMFLOAT4 Color;
 
     float AnimationTime;
+
+#if RENDERER_INSTANCE_MOTION
+    // Evaluated by the vertex shader on top of WorldMatrix at PerPassInfo::Time, so moving instances don't have to be
+    // written every frame. Translated by MotionDirection * GameRules::GetPatrolOffset(MotionStartTime, MotionSpeed, Time)
+    DirectX::XMFLOAT3 MotionDirection;
+    float MotionStartTime;
+    float MotionSpeed;
+    DirectX::XMFLOAT2 pad;
+#else
     DirectX::XMFLOAT3 pad;
+#endif
     InstanceInfo() {
         WorldMatrix = DirectX::XMMatrixIdentity();
         Color = { 1.0f, 1.0f, 1.0f, 1.0f };
         AnimationTime = 0.0f;
+#if RENDERER_INSTANCE_MOTION
+        MotionDirection = { 0.0f, 0.0f, 0.0f };
+        MotionStartTime = 0.0f;
+        MotionSpeed = 0.0f;
+#endif
     }
 };
 
@@ -85,6 +135,11 @@ struct FrameResources
     UploadBuffer<PerPassInfo> PerPassBuffers;
     UploadBuffer<MaterialConstants> MaterialsBuffers;
     UploadBuffer<LightsBuffer> LightsBuffer;
+#if RENDERER_LIGHT_CLUSTERS
+    UploadBuffer<LightCB> PointLightsBuffer;
+    UploadBuffer<LightCluster> LightClustersBuffer;
+    UploadBuffer<unsigned int> LightIndicesBuffer;
+#endif
     
     // These should be unique per object, so we'll just use object's addres as key
     std::unordered_map<uuids::uuid, UploadBuffer<InstanceInfo>> InstanceBuffer;